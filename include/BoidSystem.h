@@ -0,0 +1,95 @@
+// This file is part of dexvt-lite.
+// -- 3D Inverse Kinematics (Cyclic Coordinate Descent) with Constraints
+// Copyright (C) 2018 onlyuser <mailto:onlyuser@gmail.com>
+//
+// dexvt-lite is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// dexvt-lite is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with dexvt-lite.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef VT_BOID_SYSTEM_H_
+#define VT_BOID_SYSTEM_H_
+
+#include <glm/glm.hpp>
+#include <vector>
+
+namespace vt {
+
+class TransformObject;
+
+// flocking (separation / alignment / cohesion) for many objects at once
+// NOTE: boids are simulated in their parents' local space
+class BoidSystem
+{
+public:
+    BoidSystem(float neighbor_radius   = 1,
+               float separation_radius = 0.5,
+               float max_speed         = 1);
+    virtual ~BoidSystem();
+
+    void add_boid(TransformObject* object, glm::vec3 velocity = glm::vec3(0));
+    void clear();
+    size_t size() const { return m_objects.size(); }
+
+    // parameters
+    void set_neighbor_radius(float neighbor_radius);
+    void set_separation_radius(float separation_radius) { m_separation_radius = separation_radius; }
+    void set_max_speed(float max_speed)                 { m_max_speed = max_speed; }
+    void set_weights(float separation_weight, float alignment_weight, float cohesion_weight)
+    {
+        m_separation_weight = separation_weight;
+        m_alignment_weight  = alignment_weight;
+        m_cohesion_weight   = cohesion_weight;
+    }
+    void set_target(glm::vec3 target, float seek_weight)
+    {
+        m_target      = target;
+        m_seek_weight = seek_weight;
+    }
+
+    // simulation
+    void read_objects();
+    void update(float delta_time);
+    void write_objects() const;
+
+    const std::vector<glm::vec3> &get_positions() const  { return m_positions; }
+    const std::vector<glm::vec3> &get_velocities() const { return m_velocities; }
+
+private:
+    std::vector<TransformObject*> m_objects;
+    std::vector<glm::vec3>        m_positions;
+    std::vector<glm::vec3>        m_velocities;
+    std::vector<glm::vec3>        m_new_velocities;
+
+    float     m_neighbor_radius;
+    float     m_separation_radius;
+    float     m_max_speed;
+    float     m_separation_weight;
+    float     m_alignment_weight;
+    float     m_cohesion_weight;
+    glm::vec3 m_target;
+    float     m_seek_weight;
+
+    // spatial hash grid (cell size = neighbor radius)
+    // boids in bucket i are m_sorted_boids[m_bucket_start[i], m_bucket_start[i + 1])
+    std::vector<int> m_boid_buckets;
+    std::vector<int> m_bucket_start;
+    std::vector<int> m_sorted_boids;
+
+    glm::ivec3 get_cell(glm::vec3 pos) const;
+    int get_bucket(glm::ivec3 cell) const;
+    void update_spatial_hash();
+    void update_velocities(int start_index, int end_index, float delta_time);
+};
+
+}
+
+#endif
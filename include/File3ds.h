@@ -18,7 +18,7 @@
 #ifndef H_FILE_3DS
 #define H_FILE_3DS
 
-#include <stdio.h>
+#include <stdint.h>
 #include <vector>
 #include <string>
 
@@ -28,6 +28,7 @@
 #define OBJ_TRIMESH 0x4100
 #define TRI_VERTEXL 0x4110
 #define TRI_FACEL 0x4120
+#define TRI_MAPPINGCOORS 0x4140
 
 namespace vt {
 
@@ -41,11 +42,10 @@ public:
 
 private:
     static bool load3ds_impl(std::string filename, int index, std::vector<MeshBase*>* meshes);
-	static uint32_t enter_chunk(FILE* stream, uint32_t chunk_id, uint32_t chunk_end);
-	static void read_vertices(FILE* stream, MeshBase* mesh);
-	static void read_faces(FILE* stream, MeshBase* mesh);
-	static uint16_t read_short(FILE* stream);
-	static uint32_t read_long(FILE* stream);
+	static uint32_t enter_chunk(const uint8_t* buf, uint32_t* pos, uint32_t chunk_id, uint32_t chunk_end);
+	static MeshBase* read_trimesh(const uint8_t* buf, uint32_t pos, uint32_t mesh_end, std::string name);
+	static uint16_t read_short(const uint8_t* buf);
+	static uint32_t read_long(const uint8_t* buf);
 };
 
 }
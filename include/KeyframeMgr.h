@@ -69,6 +69,7 @@ public:
     bool erase_keyframe(int frame_number);
     bool export_keyframe_values(std::vector<glm::vec3>* keyframe_values, bool include_control_points = false);
     bool interpolate_frame_value(int frame_number, glm::vec3* value, bool is_smooth = false) const;
+    bool export_frame_values(int start_frame_number, int end_frame_number, glm::vec3* frame_values, bool is_smooth = false) const;
 
     // util
     bool get_frame_number_range(int* start_frame_number, int* end_frame_number) const;
@@ -100,6 +101,11 @@ public:
                                                   int                        frame_number,
                                                   glm::vec3*                 value,
                                                   bool                       is_smooth = false) const;
+    bool export_frame_values_for_motion_track(MotionTrack::motion_type_t motion_type,
+                                              int                        start_frame_number,
+                                              int                        end_frame_number,
+                                              glm::vec3*                 frame_values,
+                                              bool                       is_smooth = false) const;
 
     // util
     bool get_frame_number_range(int* start_frame_number, int* end_frame_number) const;
@@ -143,14 +149,50 @@ public:
                                         std::vector<glm::vec3>* euler_frame_values,
                                         std::vector<glm::vec3>* scale_frame_values,
                                         bool                    is_smooth = false) const;
+    bool export_frame_values_for_object(long       object_id,
+                                        int        start_frame_number,
+                                        int        end_frame_number,
+                                        glm::vec3* origin_frame_values, // out (end - start values)
+                                        glm::vec3* euler_frame_values,  // out (end - start values)
+                                        glm::vec3* scale_frame_values,  // out (end - start values)
+                                        bool       is_smooth = false) const;
 
     void clear();
 
+    // compiled representation (flat arrays, rebuilt on demand after editing)
+    bool compile();
+    bool is_compiled() const { return m_is_compiled; }
+    size_t get_num_compiled_objects() const { return m_compiled_object_ids.size(); }
+    long get_compiled_object_id(int index) const;
+    bool interpolate_all_objects(int        frame_number,
+                                 glm::vec3* origins, // out (one per compiled object)
+                                 glm::vec3* eulers,  // out (one per compiled object)
+                                 glm::vec3* scales,  // out (one per compiled object)
+                                 bool       is_smooth = false);
+
 private:
-    KeyframeMgr() {}
+    // keyframes [m_start, m_start + m_count) of the compiled arrays
+    struct compiled_track_t
+    {
+        int m_start;
+        int m_count;
+        int m_cursor; // last used segment, makes sequential playback O(1)
+    };
+
+    KeyframeMgr();
     ~KeyframeMgr();
 
     script_t m_script;
+
+    // compiled representation
+    bool                          m_is_compiled;
+    std::vector<long>             m_compiled_object_ids;
+    std::vector<compiled_track_t> m_compiled_tracks;      // origin, euler and scale per object
+    std::vector<int>              m_compiled_frame_numbers;
+    std::vector<glm::vec3>        m_compiled_values;      // value, control point 1 and control point 2 per keyframe
+
+    void compile_motion_track(const MotionTrack* motion_track);
+    bool interpolate_compiled_track(compiled_track_t* track, int frame_number, glm::vec3* value, bool is_smooth) const;
 };
 
 }
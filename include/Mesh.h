@@ -26,6 +26,7 @@
 #include <GL/glew.h>
 #include <glm/glm.hpp>
 #include <string>
+#include <vector>
 #include <stddef.h>
 #include <memory> // std::unique_ptr
 
@@ -44,6 +45,7 @@ public:
     virtual ~Mesh();
     void resize(size_t num_vertex, size_t num_tri, bool preserve_mesh_geometry = false);
     void merge(const MeshBase* other, bool copy_tex_coords = false);
+    void merge_all(const std::vector<const MeshBase*> &others, bool copy_tex_coords = false);
 
     size_t get_num_vertex() const
     {
@@ -83,11 +85,20 @@ public:
     glm::ivec3 get_tri_indices(int index) const;
     void       set_tri_indices(int index, glm::ivec3 indices);
 
+    // set all elements at once (arrays sized by vertex / triangle count)
+    void set_vert_coords(const glm::vec3* coords);
+    void set_tex_coords(const glm::vec2* coords);
+    void set_tri_indices(const glm::ivec3* indices);
+
     void update_bbox();
     void update_normals_and_tangents();
+    void apply_ripple(glm::vec3 origin, float amplitude, float wavelength, float phase);
+    void set_ripple(glm::vec3 origin, float amplitude, float wavelength, float phase);
 
     // NOTE: strangely required by pure virtual (already defined in base class!)
     void get_min_max(glm::vec3* min, glm::vec3* max) const;
+    void get_world_center_extent(glm::vec3* center, glm::vec3* extent);
+    void get_world_min_max(glm::vec3* min, glm::vec3* max);
 
     // NOTE: strangely required by pure virtual (already defined in base class!)
     glm::vec3 in_abs_system(glm::vec3 local_point = glm::vec3(0));
@@ -192,6 +203,23 @@ public:
         m_reflect_to_refract_ratio = reflect_to_refract_ratio;
     }
 
+    glm::vec3 get_ripple_origin() const
+    {
+        return m_ripple_origin;
+    }
+    float get_ripple_amplitude() const
+    {
+        return m_ripple_amplitude;
+    }
+    float get_ripple_wavelength() const
+    {
+        return m_ripple_wavelength;
+    }
+    float get_ripple_phase() const
+    {
+        return m_ripple_phase;
+    }
+
     glm::vec3 get_ambient_color() const;
     void set_ambient_color(glm::vec3 ambient_color);
 
@@ -231,9 +259,33 @@ private:
     int            m_backface_depth_overlay_texture_index;
     int            m_backface_normal_overlay_texture_index;
     float          m_reflect_to_refract_ratio;
+    glm::vec3      m_ripple_origin;
+    float          m_ripple_amplitude;
+    float          m_ripple_wavelength;
+    float          m_ripple_phase;
     GLfloat*       m_ambient_color;
 
+    // world-space bbox (cached until transform or bbox changes)
+    glm::vec3     m_world_center;
+    glm::vec3     m_world_extent;
+    bool          m_is_dirty_world_bbox;
+    unsigned long m_world_bbox_transform_generation;
+
+    // vertex-to-triangle adjacency (CSR), rebuilt after triangles change
+    // triangles of vertex i are m_vert_tris[m_vert_tri_offsets[i], m_vert_tri_offsets[i + 1])
+    std::vector<int>       m_vert_tri_offsets;
+    std::vector<int>       m_vert_tris;
+    bool                   m_is_dirty_vert_tri_adjacency;
+    std::vector<glm::vec3> m_tri_normals;  // area-weighted
+    std::vector<glm::vec3> m_tri_tangents;
+
     void update_transform();
+    void update_vertices(const glm::mat4* transform);
+    void update_vertex_range(int start_index, int end_index, const glm::mat4* transform, glm::vec3* min, glm::vec3* max);
+    void update_vert_tri_adjacency();
+    void update_tri_normals_and_tangents(int start_index, int end_index);
+    void update_vert_normals_and_tangents(int start_index, int end_index);
+    void apply_ripple_range(int start_index, int end_index, glm::vec3 origin, float amplitude, float wave_number, float phase);
 };
 
 MeshBase* alloc_mesh_base(std::string name, size_t num_vertex, size_t num_tri);
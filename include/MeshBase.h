@@ -20,6 +20,7 @@
 
 #include <BBoxObject.h>
 #include <glm/glm.hpp>
+#include <vector>
 
 namespace vt {
 
@@ -35,6 +36,7 @@ public:
     virtual void       set_smooth(bool smooth) = 0;
     virtual void       resize(size_t num_vertex, size_t num_tri, bool preserve_mesh_geometry = false) = 0;
     virtual void       merge(const MeshBase* other, bool copy_tex_coords = false) = 0;
+    virtual void       merge_all(const std::vector<const MeshBase*> &others, bool copy_tex_coords = false) = 0;
     virtual Material*  get_material() const = 0;
     virtual size_t     get_num_vertex() const = 0;
     virtual size_t     get_num_tri() const = 0;
@@ -48,8 +50,13 @@ public:
     virtual void       set_tex_coord(int index, glm::vec2 coord) = 0;
     virtual glm::ivec3 get_tri_indices(int index) const = 0;
     virtual void       set_tri_indices(int index, glm::ivec3 indices) = 0;
+    virtual void       set_vert_coords(const glm::vec3* coords) = 0;
+    virtual void       set_tex_coords(const glm::vec2* coords) = 0;
+    virtual void       set_tri_indices(const glm::ivec3* indices) = 0;
     virtual void       update_bbox() = 0;
     virtual void       update_normals_and_tangents() = 0;
+    virtual void       apply_ripple(glm::vec3 origin, float amplitude, float wavelength, float phase) = 0;
+    virtual void       set_ripple(glm::vec3 origin, float amplitude, float wavelength, float phase) = 0;
     virtual void       get_min_max(glm::vec3* min, glm::vec3* max) const = 0;
     virtual glm::vec3  in_abs_system(glm::vec3 local_point = glm::vec3(0)) = 0;
     virtual void       set_axis(glm::vec3 axis) = 0;
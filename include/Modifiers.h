@@ -30,9 +30,14 @@ enum tessellation_type_t {
     TESSELLATION_TYPE_TRI_CENTER
 };
 
+enum ripple_mode_t {
+    RIPPLE_MODE_CPU, // displace vertices in place
+    RIPPLE_MODE_GPU  // set ripple uniforms for the *_ripple vertex shaders
+};
+
 void mesh_attach(Scene* scene, MeshBase* mesh1, MeshBase* mesh2);
-void mesh_apply_ripple(MeshBase* mesh, glm::vec3 origin, float amplitude, float wavelength, float phase, bool smooth);
-void mesh_tessellate(MeshBase* mesh, tessellation_type_t tessellation_type, bool smooth);
+void mesh_apply_ripple(MeshBase* mesh, glm::vec3 origin, float amplitude, float wavelength, float phase, bool smooth, ripple_mode_t ripple_mode = RIPPLE_MODE_CPU);
+void mesh_tessellate(MeshBase* mesh, tessellation_type_t tessellation_type, bool smooth, int levels = 1);
 
 }
 
@@ -40,22 +40,51 @@ public:
     int           get_depth() const         { return m_depth; }
     Octree*       get_parent() const        { return m_parent; }
     Octree*       get_node(int index) const { return m_nodes[index]; }
+    bool          is_leaf() const           { return m_depth + 1 == m_max_depth; }
+    size_t        get_num_objects() const   { return m_objects.size(); }
     bool          encloses(glm::vec3 pos) const;
+    bool          encloses(glm::vec3 min, glm::vec3 max) const;
     const Octree* downtrace_leaf_enclosing(glm::vec3 pos) const;
+    Octree*       downtrace_node_enclosing(glm::vec3 min, glm::vec3 max);
     Octree*       uptrace_parent_enclosing(glm::vec3 pos) const;
+    Octree*       uptrace_parent_enclosing(glm::vec3 min, glm::vec3 max) const;
+
+    // NOTE: object operations and queries are meant to be called on the root node
     bool          add_object(long id, glm::vec3* pos);
+    bool          add_object(long id, glm::vec3 min, glm::vec3 max);
+    bool          update_object(long id, glm::vec3 min, glm::vec3 max);
+    bool          remove_object(long id);
+    bool          has_object(long id) const;
+    void          clear_objects();
     int           find_k_nearest(int k, glm::vec3 pos, std::vector<long>* k_nearest) const;
+    int           find_within_radius(glm::vec3 pos, float radius, std::vector<long>* ids) const;
+    int           find_in_frustum(glm::mat4 view_proj_transform, std::vector<long>* ids) const;
     void          update();
 
 private:
-    glm::vec3                  m_origin;
-    glm::vec3                  m_dim;
-    glm::vec3                  m_center;
-    int                        m_max_depth;
-    int                        m_depth;
-    Octree*                    m_parent;
-    Octree*                    m_nodes[8];
-    std::map<long, glm::vec3*> m_objects;
+    struct object_t
+    {
+        glm::vec3* m_pos; // tracked by update() if not NULL
+        glm::vec3  m_min;
+        glm::vec3  m_max;
+    };
+
+    typedef std::map<long, object_t> objects_t;
+    typedef std::map<long, Octree*>  object_nodes_t;
+
+    glm::vec3      m_origin;
+    glm::vec3      m_dim;
+    glm::vec3      m_center;
+    int            m_max_depth;
+    int            m_depth;
+    Octree*        m_parent;
+    Octree*        m_nodes[8];
+    objects_t      m_objects;
+    object_nodes_t m_object_nodes; // root only
+
+    void insert_object(long id, const object_t& object, Octree* start_node);
+    void collect_objects(std::vector<long>* ids) const;
+    void find_in_frustum_impl(const glm::vec4* planes, std::vector<long>* ids) const;
 };
 
 }
@@ -74,6 +74,10 @@ public:
         var_uniform_type_normal_transform,
         var_uniform_type_random_texture,
         var_uniform_type_reflect_to_refract_ratio,
+        var_uniform_type_ripple_amplitude,
+        var_uniform_type_ripple_origin,
+        var_uniform_type_ripple_phase,
+        var_uniform_type_ripple_wavelength,
         var_uniform_type_ssao_sample_kernel_pos,
         var_uniform_type_viewport_dim,
         var_uniform_type_view_proj_transform,
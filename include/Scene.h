@@ -83,6 +83,23 @@ public:
         return m_oct_tree;
     }
 
+    void set_frustum_culling(bool frustum_culling)
+    {
+        m_frustum_culling = frustum_culling;
+    }
+    bool get_frustum_culling() const
+    {
+        return m_frustum_culling;
+    }
+    size_t get_num_culled_meshes() const
+    {
+        return m_num_culled_meshes;
+    }
+    size_t get_num_drawn_meshes() const
+    {
+        return m_num_drawn_meshes;
+    }
+
     Light* find_light(std::string name);
     void add_light(Light* light);
     void remove_light(Light* light);
@@ -156,6 +173,7 @@ public:
                 bool                render_skybox     = true,
                 use_material_type_t use_material_type = use_material_type_t::USE_MESH_MATERIAL);
     void render_oct_tree(Octree* oct_tree, glm::mat4 camera_transform) const;
+    void update_oct_tree();
     void render_lines_and_text(bool  draw_guide_wires,
                                bool  draw_paths,
                                bool  draw_axis,
@@ -186,6 +204,16 @@ private:
     GLint*   m_light_enabled;
     GLfloat* m_ssao_sample_kernel_pos;
 
+    // oct tree object ids are indices into m_meshes
+    std::vector<long> m_oct_tree_query_ids;
+    std::vector<bool> m_mesh_in_frustum;
+
+    // frustum culling
+    bool      m_frustum_culling;
+    glm::vec4 m_frustum_planes_soa[8];
+    size_t    m_num_culled_meshes;
+    size_t    m_num_drawn_meshes;
+
     Scene();
     ~Scene();
 };
@@ -71,6 +71,10 @@ public:
     void set_normal_transform(glm::mat4 normal_transform);
     void set_random_texture_index(GLint texture_id);
     void set_reflect_to_refract_ratio(GLfloat reflect_to_refract_ratio);
+    void set_ripple_amplitude(GLfloat ripple_amplitude);
+    void set_ripple_origin(const float* ripple_origin_arr);
+    void set_ripple_phase(GLfloat ripple_phase);
+    void set_ripple_wavelength(GLfloat ripple_wavelength);
     void set_ssao_sample_kernel_pos(size_t num_kernels, const float* kernel_pos_arr);
     void set_texture_index(GLint texture_id);
     void set_texture2_index(GLint texture_id);
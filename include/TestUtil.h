@@ -0,0 +1,87 @@
+// This file is part of dexvt-lite.
+// -- 3D Inverse Kinematics (Cyclic Coordinate Descent) with Constraints
+// Copyright (C) 2018 onlyuser <mailto:onlyuser@gmail.com>
+//
+// dexvt-lite is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// dexvt-lite is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with dexvt-lite.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef VT_TEST_UTIL_H_
+#define VT_TEST_UTIL_H_
+
+#include <iostream>
+#include <string>
+#include <chrono>
+#include <string.h>
+
+// helpers for the bin/test_* targets
+// each test exits non-zero if any check failed, and benchmarks when run with "-b"
+
+#define TEST_CHECK(cond) vt::test_check((cond), #cond, __FILE__, __LINE__)
+
+namespace vt {
+
+inline int &test_fail_count()
+{
+    static int fail_count = 0;
+    return fail_count;
+}
+
+inline bool test_check(bool cond, const char* expr, const char* filename, int line)
+{
+    if(!cond) {
+        std::cout << "Error: " << filename << ":" << line << ": check failed: " << expr << std::endl;
+        test_fail_count()++;
+    }
+    return cond;
+}
+
+inline bool test_bench_mode(int argc, char** argv)
+{
+    for(int i = 1; i < argc; i++) {
+        if(!strcmp(argv[i], "-b")) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// exit code for main()
+inline int test_report(std::string test_name)
+{
+    if(test_fail_count()) {
+        std::cout << test_name << ": " << test_fail_count() << " check(s) failed" << std::endl;
+        return 1;
+    }
+    std::cout << test_name << ": passed" << std::endl;
+    return 0;
+}
+
+class BenchTimer
+{
+public:
+    BenchTimer()
+        : m_start(std::chrono::steady_clock::now())
+    {
+    }
+    double get_elapsed_ms() const
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_start).count();
+    }
+
+private:
+    std::chrono::steady_clock::time_point m_start;
+};
+
+}
+
+#endif
@@ -45,10 +45,12 @@ public:
                                                               DEFAULT_TEXTURE_HEIGHT),
             bool                 smooth          = true,
             format_t             format          = Texture::RGBA,
-            const unsigned char* pixels      = NULL);
+            const unsigned char* pixels      = NULL,
+            bool                 trilinear       = false);
     Texture(std::string name,
-            std::string png_filename,
-            bool        smooth = true);
+            std::string image_filename,
+            bool        smooth    = true,
+            bool        trilinear = false);
     Texture(std::string name,
             std::string png_filename_pos_x,
             std::string png_filename_neg_x,
@@ -62,6 +64,8 @@ public:
     // accessors
     format_t get_internal_format() const { return m_internal_format; }
     unsigned char* get_pixels() const    { return m_pixels; }
+    bool get_trilinear() const           { return m_trilinear; }
+    void set_trilinear(bool trilinear);
 
 private:
     // core functionality
@@ -76,6 +80,8 @@ private:
                const void* pixels_neg_y,
                const void* pixels_pos_z,
                const void* pixels_neg_z);
+    bool alloc_compressed(std::string image_filename, bool smooth);
+    void update_mipmaps();
 
 public:
     size_t size() const;
@@ -102,6 +108,7 @@ public:
 
 private:
     bool           m_skybox;
+    bool           m_trilinear; // mipmapped, GL_LINEAR_MIPMAP_LINEAR minification
     format_t       m_internal_format;
     unsigned char* m_pixels;
     unsigned char* m_pixels_pos_x;
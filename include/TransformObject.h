@@ -110,8 +110,9 @@ public:
                      float     avoid_radius);
 
     // core functionality
-    const glm::mat4 &get_transform(bool trace_down = true);
+    const glm::mat4 &get_transform();
     const glm::mat4 &get_normal_transform();
+    unsigned long get_transform_generation();
     glm::mat4 get_local_rotation_transform() const;
 
 protected:
@@ -135,15 +136,16 @@ protected:
 
     // caching
     void mark_dirty_transform() {
-        m_is_dirty_transform        = true;
-        m_is_dirty_normal_transform = true;
+        m_is_dirty_transform = true;
     }
     virtual void update_transform() = 0;
 
 private:
     // caching
-    bool m_is_dirty_transform;
-    bool m_is_dirty_normal_transform;
+    bool          m_is_dirty_transform;          // local components changed
+    unsigned long m_generation;                  // renewed whenever m_transform is recomputed
+    unsigned long m_parent_generation;           // parent generation m_transform was computed against
+    unsigned long m_normal_transform_generation; // generation m_normal_transform was computed against
 
     // joint constraints
     void check_roll_hinge();
@@ -153,7 +155,7 @@ private:
     virtual void set_axis(glm::vec3 axis) {}
 
     // caching
-    void update_transform_hier();
+    static unsigned long next_generation();
     void update_normal_transform();
 };
 
@@ -25,6 +25,7 @@
 #include <vector>
 #include <string>
 #include <iostream>
+#include <functional>
 
 #define EPSILON 0.0001
 
@@ -73,6 +74,12 @@ enum euler_index_t {
     EULER_INDEX_YAW
 };
 
+enum frustum_test_t {
+    FRUSTUM_OUTSIDE,
+    FRUSTUM_INTERSECT,
+    FRUSTUM_INSIDE
+};
+
 void print_bitmap_string(void* font, const char* s);
 glm::vec3 euler_to_offset(glm::vec3  euler,
                           glm::vec3* up_direction); // out
@@ -86,21 +93,35 @@ glm::vec3 euler_modulo(glm::vec3 euler);
 float angle_modulo(float angle);
 float angle_distance(float angle1, float angle2);
 glm::vec3 nearest_point_on_plane(glm::vec3 plane_origin, glm::vec3 plane_normal, glm::vec3 point);
+void extract_frustum_planes(glm::mat4  view_proj_transform,
+                            glm::vec4* planes); // out (6 planes)
+frustum_test_t frustum_test_aabb(const glm::vec4* planes, glm::vec3 min, glm::vec3 max);
+void extract_frustum_planes_soa(glm::mat4  view_proj_transform,
+                                glm::vec4* planes_soa); // out (8 vec4s)
+bool frustum_test_center_extent(const glm::vec4* planes_soa, glm::vec3 center, glm::vec3 extent);
 glm::vec3 bezier_interpolate(glm::vec3 p0, glm::vec3 p1, glm::vec3 p2, glm::vec3 p3, float alpha);
+void bezier_interpolate_n(glm::vec3  p0,
+                          glm::vec3  p1,
+                          glm::vec3  p2,
+                          glm::vec3  p3,
+                          float      start_alpha,
+                          float      alpha_step,
+                          int        n,
+                          glm::vec3* values); // out (n values)
+void parallel_for(int count, int min_count_per_task, std::function<void(int, int)> func);
 bool read_file(std::string filename, std::string &s);
 bool regexp(std::string &s, std::string pattern, std::vector<std::string*> &cap_groups, size_t* start_pos);
 bool regexp(std::string &s, std::string pattern, std::vector<std::string*> &cap_groups);
 bool regexp(std::string &s, std::string pattern, int nmatch, ...);
-bool read_png(std::string png_filename,
-              void**      pixel_data,
-              size_t*     width,
-              size_t*     height);
-bool read_png_impl(std::string png_filename,
-                   void**      pixel_data,
-                   size_t*     width,
-                   size_t*     height,
-                   int*        color_type);
-
+std::string get_file_extension(std::string filename); // lower case, without dot
+bool is_s3tc_format(int format); // gli::format
+bool read_image(std::string image_filename,
+                void**      pixel_data,
+                size_t*     width,
+                size_t*     height);
+void read_images(const std::vector<std::string> &image_filenames,
+                 std::vector<unsigned char*>*    pixel_data, // out (NULL if failed)
+                 std::vector<glm::ivec2>*        dims);      // out
 }
 
 #endif
@@ -8,16 +8,37 @@
 #include <algorithm>
 #include <functional>
 #include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/matrix_inverse.hpp>
 
 namespace saba
 {
 	MMDIkSolver::MMDIkSolver()
-		: m_ikNode(nullptr)
+		: m_chainPathDirty(true)
+		, m_chainPathValid(false)
+		, m_fastSolve(false)
+		, m_fastSolving(false)
+		, m_convergenceThreshold(0)
+		, m_warmStart(false)
+		, m_hasWarmStart(false)
+		, m_priority(0)
+		, m_iterationLimit(std::numeric_limits<uint32_t>::max())
+		, m_ikNode(nullptr)
 		, m_ikTarget(nullptr)
 		, m_iterateCount(1)
 		, m_limitAngle(glm::pi<float>() * 2.0f)
 		, m_enable(true)
 	{
+		ResetStats();
+	}
+
+	void MMDIkSolver::ResetStats()
+	{
+		m_stats.m_solveCount = 0;
+		m_stats.m_iterationCount = 0;
+		m_stats.m_convergedCount = 0;
+		m_stats.m_limitedCount = 0;
+		m_stats.m_lastIterationCount = 0;
+		m_stats.m_lastDistance = 0;
 	}
 
 	void MMDIkSolver::AddIKChain(MMDNode * node, bool isKnee)
@@ -50,40 +71,269 @@ namespace saba
 
 	void MMDIkSolver::AddIKChain(MMDIkSolver::IKChain&& chain)
 	{
+		// X,Y,Z 軸のいずれかしか回転しないものは専用の Solver を使用する
+		chain.m_planeAxis = SolveAxis::None;
+		if (chain.m_enableAxisLimit)
+		{
+			if ((chain.m_limitMin.x != 0 || chain.m_limitMax.x != 0) &&
+				(chain.m_limitMin.y == 0 || chain.m_limitMax.y == 0) &&
+				(chain.m_limitMin.z == 0 || chain.m_limitMax.z == 0)
+				)
+			{
+				chain.m_planeAxis = SolveAxis::X;
+			}
+			else if ((chain.m_limitMin.y != 0 || chain.m_limitMax.y != 0) &&
+				(chain.m_limitMin.x == 0 || chain.m_limitMax.x == 0) &&
+				(chain.m_limitMin.z == 0 || chain.m_limitMax.z == 0)
+				)
+			{
+				chain.m_planeAxis = SolveAxis::Y;
+			}
+			else if ((chain.m_limitMin.z != 0 || chain.m_limitMax.z != 0) &&
+				(chain.m_limitMin.x == 0 || chain.m_limitMax.x == 0) &&
+				(chain.m_limitMin.y == 0 || chain.m_limitMax.y == 0)
+				)
+			{
+				chain.m_planeAxis = SolveAxis::Z;
+			}
+		}
+		chain.m_pathIndex = 0;
+		chain.m_warmIKRot = glm::quat(1, 0, 0, 0);
+		chain.m_warmPrevAngle = glm::vec3(0);
+		chain.m_warmPlaneModeAngle = 0;
 		m_chains.emplace_back(chain);
+		m_chainPathDirty = true;
+		m_hasWarmStart = false;
+	}
+
+	void MMDIkSolver::SetupChainPath()
+	{
+		m_chainPathDirty = false;
+		m_chainPathValid = false;
+		m_chainPath.clear();
+		if (m_ikNode == nullptr || m_ikTarget == nullptr || m_chains.empty())
+		{
+			return;
+		}
+
+		// m_ikTarget から親をたどり、全てのチェインを含む経路を作る
+		size_t foundCount = 0;
+		for (MMDNode* node = m_ikTarget; node != nullptr && foundCount < m_chains.size(); node = node->GetParent())
+		{
+			ChainPathNode pathNode;
+			pathNode.m_node = node;
+			pathNode.m_global = glm::mat4(1);
+			m_chainPath.push_back(pathNode);
+			for (const auto& chain : m_chains)
+			{
+				if (chain.m_node == node)
+				{
+					foundCount++;
+				}
+			}
+		}
+		if (foundCount != m_chains.size())
+		{
+			m_chainPath.clear();
+			return;
+		}
+		std::reverse(m_chainPath.begin(), m_chainPath.end());
+
+		for (auto& chain : m_chains)
+		{
+			for (size_t pathIdx = 0; pathIdx < m_chainPath.size(); pathIdx++)
+			{
+				if (m_chainPath[pathIdx].m_node == chain.m_node)
+				{
+					chain.m_pathIndex = pathIdx;
+					break;
+				}
+			}
+		}
+
+		// IK ノードがチェインの子孫の場合、反復中に IK ノードも動くため使用できない
+		for (MMDNode* node = m_ikNode; node != nullptr; node = node->GetParent())
+		{
+			for (const auto& chain : m_chains)
+			{
+				if (chain.m_node == node)
+				{
+					m_chainPath.clear();
+					return;
+				}
+			}
+		}
+
+		m_chainPathValid = true;
+	}
+
+	void MMDIkSolver::UpdateChainPath(size_t pathIdx)
+	{
+		for (size_t i = pathIdx; i < m_chainPath.size(); i++)
+		{
+			auto& pathNode = m_chainPath[i];
+			const auto& local = pathNode.m_node->GetLocalTransform();
+			if (i == 0)
+			{
+				MMDNode* parent = pathNode.m_node->GetParent();
+				if (parent == nullptr)
+				{
+					pathNode.m_global = local;
+				}
+				else
+				{
+					pathNode.m_global = parent->GetGlobalTransform() * local;
+				}
+			}
+			else
+			{
+				pathNode.m_global = m_chainPath[i - 1].m_global * local;
+			}
+		}
+	}
+
+	glm::mat4 MMDIkSolver::GetChainInverseTransform(size_t chainIdx) const
+	{
+		const auto& chain = m_chains[chainIdx];
+		if (m_fastSolving)
+		{
+			return glm::affineInverse(m_chainPath[chain.m_pathIndex].m_global);
+		}
+		else
+		{
+			return glm::inverse(chain.m_node->GetGlobalTransform());
+		}
+	}
+
+	glm::vec3 MMDIkSolver::GetTargetPosition() const
+	{
+		if (m_fastSolving)
+		{
+			return glm::vec3(m_chainPath.back().m_global[3]);
+		}
+		else
+		{
+			return glm::vec3(m_ikTarget->GetGlobalTransform()[3]);
+		}
+	}
+
+	float MMDIkSolver::GetDistance() const
+	{
+		auto targetPos = GetTargetPosition();
+		auto ikPos = glm::vec3(m_ikNode->GetGlobalTransform()[3]);
+		return glm::length(targetPos - ikPos);
+	}
+
+	void MMDIkSolver::SaveWarmStart()
+	{
+		for (auto& chain : m_chains)
+		{
+			chain.m_warmIKRot = chain.m_node->GetIKRotate();
+			chain.m_warmPrevAngle = chain.m_prevAngle;
+			chain.m_warmPlaneModeAngle = chain.m_planeModeAngle;
+		}
+		m_hasWarmStart = true;
+	}
+
+	void MMDIkSolver::UpdateChainTransform(size_t chainIdx)
+	{
+		const auto& chain = m_chains[chainIdx];
+		chain.m_node->UpdateLocalTransform();
+		if (m_fastSolving)
+		{
+			// 子孫ノードは Solve の最後にまとめて更新する
+			UpdateChainPath(chain.m_pathIndex);
+		}
+		else
+		{
+			chain.m_node->UpdateGlobalTransform();
+		}
 	}
 
 	void MMDIkSolver::Solve()
 	{
 		if (!m_enable)
 		{
+			m_hasWarmStart = false;
 			return;
 		}
+
+		if (m_fastSolve && m_chainPathDirty)
+		{
+			SetupChainPath();
+		}
+		m_fastSolving = m_fastSolve && m_chainPathValid;
+
 		// Initialize IKChain
+		bool warmStart = m_warmStart && m_hasWarmStart;
 		for (auto& chain : m_chains)
 		{
-			chain.m_prevAngle = glm::vec3(0);
-			chain.m_node->SetIKRotate(glm::quat(1, 0, 0, 0));
-			chain.m_planeModeAngle = 0;
+			if (warmStart)
+			{
+				chain.m_prevAngle = chain.m_warmPrevAngle;
+				chain.m_node->SetIKRotate(chain.m_warmIKRot);
+				chain.m_planeModeAngle = chain.m_warmPlaneModeAngle;
+			}
+			else
+			{
+				chain.m_prevAngle = glm::vec3(0);
+				chain.m_node->SetIKRotate(glm::quat(1, 0, 0, 0));
+				chain.m_planeModeAngle = 0;
+			}
 
 			chain.m_node->UpdateLocalTransform();
-			chain.m_node->UpdateGlobalTransform();
+			if (!m_fastSolving)
+			{
+				chain.m_node->UpdateGlobalTransform();
+			}
+		}
+		if (m_fastSolving)
+		{
+			UpdateChainPath(0);
 		}
 
+		// 高速モードでは十分近づいたら反復を打ち切る
+		const float fastSolveEpsilon = 1.0e-4f;
+		float threshold = m_convergenceThreshold;
+		if (m_fastSolving)
+		{
+			threshold = std::max(threshold, fastSolveEpsilon);
+		}
+
+		uint32_t iterateCount = std::min(m_iterateCount, m_iterationLimit);
+		uint32_t iteration = 0;
+		bool converged = false;
 		float maxDist = std::numeric_limits<float>::max();
-		for (uint32_t i = 0; i < m_iterateCount; i++)
+		if (warmStart)
 		{
-			SolveCore(i);
+			// 前回の結果より悪くならないようにする
+			maxDist = GetDistance();
+			for (auto& chain : m_chains)
+			{
+				chain.m_saveIKRot = chain.m_node->GetIKRotate();
+				chain.m_savePrevAngle = chain.m_prevAngle;
+				chain.m_savePlaneModeAngle = chain.m_planeModeAngle;
+			}
+			// ターゲットが動いていなければ反復しない
+			converged = maxDist < threshold;
+		}
+		for (; iteration < iterateCount && !converged; iteration++)
+		{
+			SolveCore(iteration);
 
-			auto targetPos = glm::vec3(m_ikTarget->GetGlobalTransform()[3]);
-			auto ikPos = glm::vec3(m_ikNode->GetGlobalTransform()[3]);
-			float dist = glm::length(targetPos - ikPos);
+			float dist = GetDistance();
 			if (dist < maxDist)
 			{
 				maxDist = dist;
 				for (auto& chain : m_chains)
 				{
 					chain.m_saveIKRot = chain.m_node->GetIKRotate();
+					chain.m_savePrevAngle = chain.m_prevAngle;
+					chain.m_savePlaneModeAngle = chain.m_planeModeAngle;
+				}
+				if (dist < threshold)
+				{
+					converged = true;
 				}
 			}
 			else
@@ -91,12 +341,43 @@ namespace saba
 				for (auto& chain : m_chains)
 				{
 					chain.m_node->SetIKRotate(chain.m_saveIKRot);
+					chain.m_prevAngle = chain.m_savePrevAngle;
+					chain.m_planeModeAngle = chain.m_savePlaneModeAngle;
 					chain.m_node->UpdateLocalTransform();
-					chain.m_node->UpdateGlobalTransform();
+					if (!m_fastSolving)
+					{
+						chain.m_node->UpdateGlobalTransform();
+					}
 				}
+				iteration++;
 				break;
 			}
 		}
+
+		if (m_fastSolving)
+		{
+			// 一番上のチェインから子孫ノードへ反映する
+			m_chainPath[0].m_node->UpdateGlobalTransform();
+			m_fastSolving = false;
+		}
+
+		if (m_warmStart)
+		{
+			SaveWarmStart();
+		}
+
+		m_stats.m_solveCount++;
+		m_stats.m_iterationCount += iteration;
+		if (converged)
+		{
+			m_stats.m_convergedCount++;
+		}
+		else if (iteration == iterateCount && iterateCount < m_iterateCount)
+		{
+			m_stats.m_limitedCount++;
+		}
+		m_stats.m_lastIterationCount = iteration;
+		m_stats.m_lastDistance = maxDist;
 	}
 
 	namespace
@@ -116,9 +397,10 @@ namespace saba
 			return ret;
 		}
 
-		float DiffAngle(float a, float b)
+		// b は NormalizeAngle 済みの角度
+		float DiffNormalizedAngle(float a, float b)
 		{
-			float diff = NormalizeAngle(a) - NormalizeAngle(b);
+			float diff = NormalizeAngle(a) - b;
 			if (diff > glm::pi<float>())
 			{
 				return diff - glm::two_pi<float>();
@@ -130,6 +412,11 @@ namespace saba
 			return diff;
 		}
 
+		float DiffAngle(float a, float b)
+		{
+			return DiffNormalizedAngle(a, NormalizeAngle(b));
+		}
+
 		float ClampAngle(float angle, float minAngle, float maxAngle)
 		{
 			if (minAngle == maxAngle)
@@ -229,15 +516,17 @@ namespace saba
 				{ r.x - pi, -pi - r.y, r.z - pi },
 			};
 
-			float errX = std::abs(DiffAngle(r.x, before.x));
-			float errY = std::abs(DiffAngle(r.y, before.y));
-			float errZ = std::abs(DiffAngle(r.z, before.z));
+			// before の正規化は一度だけ行う
+			const glm::vec3 nb(NormalizeAngle(before.x), NormalizeAngle(before.y), NormalizeAngle(before.z));
+			float errX = std::abs(DiffNormalizedAngle(r.x, nb.x));
+			float errY = std::abs(DiffNormalizedAngle(r.y, nb.y));
+			float errZ = std::abs(DiffNormalizedAngle(r.z, nb.z));
 			float minErr = errX + errY + errZ;
-			for (const auto test : tests)
+			for (const auto& test : tests)
 			{
-				float err = std::abs(DiffAngle(test.x, before.x))
-					+ std::abs(DiffAngle(test.y, before.y))
-					+ std::abs(DiffAngle(test.z, before.z));
+				float err = std::abs(DiffNormalizedAngle(test.x, nb.x))
+					+ std::abs(DiffNormalizedAngle(test.y, nb.y))
+					+ std::abs(DiffNormalizedAngle(test.z, nb.z));
 				if (err < minErr)
 				{
 					minErr = err;
@@ -294,38 +583,15 @@ namespace saba
 				continue;
 			}
 
-			if (chain.m_enableAxisLimit)
+			if (chain.m_planeAxis != SolveAxis::None)
 			{
-				// X,Y,Z 軸のいずれかしか回転しないものは専用の Solver を使用する
-				if ((chain.m_limitMin.x != 0 || chain.m_limitMax.x != 0) &&
-					(chain.m_limitMin.y == 0 || chain.m_limitMax.y == 0) &&
-					(chain.m_limitMin.z == 0 || chain.m_limitMax.z == 0)
-					)
-				{
-					SolvePlane(iteration, chainIdx, SolveAxis::X);
-					continue;
-				}
-				else if ((chain.m_limitMin.y != 0 || chain.m_limitMax.y != 0) &&
-					(chain.m_limitMin.x == 0 || chain.m_limitMax.x == 0) &&
-					(chain.m_limitMin.z == 0 || chain.m_limitMax.z == 0)
-					)
-				{
-					SolvePlane(iteration, chainIdx, SolveAxis::Y);
-					continue;
-				}
-				else if ((chain.m_limitMin.z != 0 || chain.m_limitMax.z != 0) &&
-					(chain.m_limitMin.x == 0 || chain.m_limitMax.x == 0) &&
-					(chain.m_limitMin.y == 0 || chain.m_limitMax.y == 0)
-					)
-				{
-					SolvePlane(iteration, chainIdx, SolveAxis::Z);
-					continue;
-				}
+				SolvePlane(iteration, chainIdx, chain.m_planeAxis);
+				continue;
 			}
 
-			auto targetPos = glm::vec3(m_ikTarget->GetGlobalTransform()[3]);
+			auto targetPos = GetTargetPosition();
 
-			auto invChain = glm::inverse(chain.m_node->GetGlobalTransform());
+			auto invChain = GetChainInverseTransform(chainIdx);
 
 			auto chainIkPos = glm::vec3(invChain * glm::vec4(ikPos, 1));
 			auto chainTargetPos = glm::vec3(invChain * glm::vec4(targetPos, 1));
@@ -367,8 +633,7 @@ namespace saba
 				* glm::inverse(glm::mat3_cast(chainNode->AnimateRotate()));
 			chainNode->SetIKRotate(glm::quat_cast(ikRotM));
 
-			chainNode->UpdateLocalTransform();
-			chainNode->UpdateGlobalTransform();
+			UpdateChainTransform(chainIdx);
 		}
 	}
 
@@ -401,9 +666,9 @@ namespace saba
 		auto& chain = m_chains[chainIdx];
 		auto ikPos = glm::vec3(m_ikNode->GetGlobalTransform()[3]);
 
-		auto targetPos = glm::vec3(m_ikTarget->GetGlobalTransform()[3]);
+		auto targetPos = GetTargetPosition();
 
-		auto invChain = glm::inverse(chain.m_node->GetGlobalTransform());
+		auto invChain = GetChainInverseTransform(chainIdx);
 
 		auto chainIkPos = glm::vec3(invChain * glm::vec4(ikPos, 1));
 		auto chainTargetPos = glm::vec3(invChain * glm::vec4(targetPos, 1));
@@ -472,8 +737,7 @@ namespace saba
 		auto ikRotM = glm::rotate(glm::quat(), newAngle, RotateAxis) * glm::inverse(chain.m_node->AnimateRotate());
 		chain.m_node->SetIKRotate(ikRotM);
 
-		chain.m_node->UpdateLocalTransform();
-		chain.m_node->UpdateGlobalTransform();
+		UpdateChainTransform(chainIdx);
 	}
 }
 
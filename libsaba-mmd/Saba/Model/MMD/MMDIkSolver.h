@@ -11,6 +11,7 @@
 #include <vector>
 #include <string>
 #include <glm/vec3.hpp>
+#include <glm/mat4x4.hpp>
 
 namespace saba
 {
@@ -19,8 +20,8 @@ namespace saba
 	public:
 		MMDIkSolver();
 
-		void SetIKNode(MMDNode* node) { m_ikNode = node; }
-		void SetTargetNode(MMDNode* node) { m_ikTarget = node; }
+		void SetIKNode(MMDNode* node) { m_ikNode = node; m_chainPathDirty = true; }
+		void SetTargetNode(MMDNode* node) { m_ikTarget = node; m_chainPathDirty = true; }
 		MMDNode* GetIKNode() const { return m_ikNode; }
 		MMDNode* GetTargetNode() const { return m_ikTarget; }
 		std::string GetName() const
@@ -36,10 +37,46 @@ namespace saba
 		}
 
 		void SetIterateCount(uint32_t count) { m_iterateCount = count; }
+		uint32_t GetIterateCount() const { return m_iterateCount; }
 		void SetLimitAngle(float angle) { m_limitAngle = angle; }
 		void Enable(bool enable) { m_enable = enable; }
 		bool Enabled() { return m_enable; }
 
+		// 高速モード
+		// 反復中はチェインの変換を作業用の配列だけで計算し、子孫ノードへは最後に一度だけ反映する
+		void EnableFastSolve(bool enable) { m_fastSolve = enable; }
+		bool IsFastSolveEnabled() const { return m_fastSolve; }
+
+		// IK ノードとターゲットの距離がこの値未満になったら反復を打ち切る (0 で無効)
+		void SetConvergenceThreshold(float threshold) { m_convergenceThreshold = threshold; }
+		float GetConvergenceThreshold() const { return m_convergenceThreshold; }
+
+		// 前回の Solve の結果から反復を開始する
+		void EnableWarmStart(bool enable) { m_warmStart = enable; m_hasWarmStart = false; }
+		bool IsWarmStartEnabled() const { return m_warmStart; }
+		void ClearWarmStart() { m_hasWarmStart = false; }
+
+		// MMDIKManager の反復回数の予算を割り当てる時の優先度 (大きいほうが先)
+		void SetPriority(int32_t priority) { m_priority = priority; }
+		int32_t GetPriority() const { return m_priority; }
+		// 1回の Solve の反復回数の上限 (IterateCount とどちらか小さいほうを使う)
+		void SetIterationLimit(uint32_t limit) { m_iterationLimit = limit; }
+		uint32_t GetIterationLimit() const { return m_iterationLimit; }
+
+		struct Stats
+		{
+			uint32_t	m_solveCount;
+			uint32_t	m_iterationCount;
+			// 収束して反復を打ち切った回数
+			uint32_t	m_convergedCount;
+			// 反復回数の上限で打ち切った回数
+			uint32_t	m_limitedCount;
+			uint32_t	m_lastIterationCount;
+			float		m_lastDistance;
+		};
+		const Stats& GetStats() const { return m_stats; }
+		void ResetStats();
+
 		void AddIKChain(MMDNode* node, bool isKnee = false);
 		void AddIKChain(
 			MMDNode* node,
@@ -48,6 +85,9 @@ namespace saba
 			const glm::vec3& limitMax
 		);
 
+		size_t GetIKChainCount() const { return m_chains.size(); }
+		MMDNode* GetIKChainNode(size_t idx) const { return m_chains[idx].m_node; }
+
 		void Solve();
 
 		void SaveBaseAnimation() { m_baseAnimEnable = m_enable; }
@@ -56,6 +96,13 @@ namespace saba
 		bool GetBaseAnimationEnabled() const { return m_baseAnimEnable; }
 
 	private:
+		enum class SolveAxis {
+			None,
+			X,
+			Y,
+			Z,
+		};
+
 		struct IKChain
 		{
 			MMDNode*	m_node;
@@ -64,22 +111,50 @@ namespace saba
 			glm::vec3	m_limitMin;
 			glm::vec3	m_prevAngle;
 			glm::quat	m_saveIKRot;
+			glm::vec3	m_savePrevAngle;
+			float		m_savePlaneModeAngle;
 			float		m_planeModeAngle;
+			SolveAxis	m_planeAxis;
+			// Warm Start 用 (前回の Solve の結果)
+			glm::quat	m_warmIKRot;
+			glm::vec3	m_warmPrevAngle;
+			float		m_warmPlaneModeAngle;
+			size_t		m_pathIndex;
+		};
+
+		// 一番上のチェインから m_ikTarget までのノード (高速モード用)
+		struct ChainPathNode
+		{
+			MMDNode*	m_node;
+			glm::mat4	m_global;
 		};
 
 	private:
 		void AddIKChain(IKChain&& chain);
 		void SolveCore(uint32_t iteration);
-
-		enum class SolveAxis {
-			X,
-			Y,
-			Z,
-		};
 		void SolvePlane(uint32_t iteration, size_t chainIdx, SolveAxis solveAxis);
 
+		void SetupChainPath();
+		void UpdateChainPath(size_t pathIdx);
+		glm::mat4 GetChainInverseTransform(size_t chainIdx) const;
+		glm::vec3 GetTargetPosition() const;
+		void UpdateChainTransform(size_t chainIdx);
+		float GetDistance() const;
+		void SaveWarmStart();
+
 	private:
 		std::vector<IKChain>	m_chains;
+		std::vector<ChainPathNode>	m_chainPath;
+		bool		m_chainPathDirty;
+		bool		m_chainPathValid;
+		bool		m_fastSolve;
+		bool		m_fastSolving;
+		float		m_convergenceThreshold;
+		bool		m_warmStart;
+		bool		m_hasWarmStart;
+		int32_t		m_priority;
+		uint32_t	m_iterationLimit;
+		Stats		m_stats;
 		MMDNode*	m_ikNode;
 		MMDNode*	m_ikTarget;
 		uint32_t	m_iterateCount;
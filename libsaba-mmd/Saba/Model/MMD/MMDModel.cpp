@@ -12,8 +12,65 @@
 
 #include <Saba/Base/Log.h>
 
+#include <limits>
+#include <unordered_map>
+
 namespace saba
 {
+	MMDIKManager::MMDIKManager()
+		: m_iterationBudget(0)
+	{
+	}
+
+	void MMDIKManager::AllocateIterationBudget()
+	{
+		size_t solverCount = GetIKSolverCount();
+		if (m_iterationBudget == 0)
+		{
+			for (size_t i = 0; i < solverCount; i++)
+			{
+				GetMMDIKSolver(i)->SetIterationLimit(std::numeric_limits<uint32_t>::max());
+			}
+			return;
+		}
+
+		m_budgetOrder.clear();
+		for (size_t i = 0; i < solverCount; i++)
+		{
+			m_budgetOrder.push_back(GetMMDIKSolver(i));
+		}
+		std::stable_sort(
+			m_budgetOrder.begin(),
+			m_budgetOrder.end(),
+			[](const MMDIkSolver* a, const MMDIkSolver* b) { return a->GetPriority() > b->GetPriority(); }
+		);
+
+		// 予算を使い切った Solver にも最低1回は反復させる
+		uint32_t remaining = m_iterationBudget;
+		for (auto solver : m_budgetOrder)
+		{
+			uint32_t limit = std::max(std::min(solver->GetIterateCount(), remaining), 1u);
+			solver->SetIterationLimit(limit);
+			remaining -= std::min(limit, remaining);
+		}
+	}
+
+	void MMDIKManager::ClearWarmStart()
+	{
+		for (size_t i = 0; i < GetIKSolverCount(); i++)
+		{
+			GetMMDIKSolver(i)->ClearWarmStart();
+		}
+	}
+
+	void MMDIKManager::ResetStats()
+	{
+		for (size_t i = 0; i < GetIKSolverCount(); i++)
+		{
+			GetMMDIKSolver(i)->ResetStats();
+		}
+	}
+
 	MMDPhysicsManager::MMDPhysicsManager()
 	{
 	}
@@ -138,6 +195,83 @@ namespace saba
 		}
 	}
 
+	void MMDModel::SetupNodeHierarchy()
+	{
+		ClearNodeHierarchy();
+
+		auto nodeMan = GetNodeManager();
+		size_t nodeCount = nodeMan->GetNodeCount();
+
+		// 深さ優先で並べる (親は子より前、部分木は連続した範囲になる)
+		std::vector<MMDNode*> sortedNodes;
+		std::unordered_map<const MMDNode*, int32_t> sortedIndices;
+		sortedNodes.reserve(nodeCount);
+		for (size_t i = 0; i < nodeCount; i++)
+		{
+			MMDNode* root = nodeMan->GetMMDNode(i);
+			if (root->GetParent() != nullptr)
+			{
+				continue;
+			}
+
+			MMDNode* node = root;
+			while (node != nullptr)
+			{
+				sortedIndices[node] = int32_t(sortedNodes.size());
+				sortedNodes.push_back(node);
+
+				if (node->GetChild() != nullptr)
+				{
+					node = node->GetChild();
+					continue;
+				}
+				while (node != root && node->GetNext() == nullptr)
+				{
+					node = node->GetParent();
+				}
+				node = (node == root) ? nullptr : node->GetNext();
+			}
+		}
+		if (sortedNodes.size() != nodeCount)
+		{
+			SABA_WARN("Node Hierarchy Setup Failed. Node Count Mismatch : {} / {}", sortedNodes.size(), nodeCount);
+			return;
+		}
+
+		m_nodeHierarchy.m_parents.resize(nodeCount);
+		m_nodeHierarchy.m_locals.resize(nodeCount);
+		m_nodeHierarchy.m_globals.resize(nodeCount);
+		std::vector<size_t> subtreeSizes(nodeCount, 1);
+		for (size_t i = 0; i < nodeCount; i++)
+		{
+			auto parent = sortedNodes[i]->GetParent();
+			m_nodeHierarchy.m_parents[i] = parent != nullptr ? sortedIndices[parent] : -1;
+		}
+		for (size_t i = nodeCount; i > 0; i--)
+		{
+			int32_t parent = m_nodeHierarchy.m_parents[i - 1];
+			if (parent >= 0)
+			{
+				subtreeSizes[parent] += subtreeSizes[i - 1];
+			}
+		}
+
+		for (size_t i = 0; i < nodeCount; i++)
+		{
+			sortedNodes[i]->BindHierarchy(&m_nodeHierarchy, i, subtreeSizes[i]);
+		}
+	}
+
+	void MMDModel::ClearNodeHierarchy()
+	{
+		auto nodeMan = GetNodeManager();
+		for (size_t i = 0; i < nodeMan->GetNodeCount(); i++)
+		{
+			nodeMan->GetMMDNode(i)->UnbindHierarchy();
+		}
+		m_nodeHierarchy.Clear();
+	}
+
 	namespace
 	{
 		glm::mat3 InvZ(const glm::mat3& m)
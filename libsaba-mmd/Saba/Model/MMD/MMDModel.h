@@ -51,6 +51,8 @@ namespace saba
 	public:
 		static const size_t NPos = -1;
 
+		MMDIKManager();
+
 		virtual size_t GetIKSolverCount() = 0;
 		virtual size_t FindIKSolverIndex(const std::string& name) = 0;
 		virtual MMDIkSolver* GetMMDIKSolver(size_t idx) = 0;
@@ -64,6 +66,19 @@ namespace saba
 			}
 			return GetMMDIKSolver(findIdx);
 		}
+
+		// 1フレームで全 Solver が使える反復回数の合計 (0 で無制限)
+		void SetIterationBudget(uint32_t budget) { m_iterationBudget = budget; }
+		uint32_t GetIterationBudget() const { return m_iterationBudget; }
+		// Priority の高い Solver から順に反復回数の上限を割り当てる (BeginAnimation で呼ぶ)
+		void AllocateIterationBudget();
+
+		void ClearWarmStart();
+		void ResetStats();
+
+	private:
+		uint32_t					m_iterationBudget;
+		std::vector<MMDIkSolver*>	m_budgetOrder;
 	};
 
 	class MMDMorphManager
@@ -137,6 +152,8 @@ namespace saba
 		virtual const glm::vec3* GetUpdatePositions() const = 0;
 		virtual const glm::vec3* GetUpdateNormals() const = 0;
 		virtual const glm::vec2* GetUpdateUVs() const = 0;
+		// UV Morph を持つ場合、GetUpdateUVs() はフレームごとに変わる
+		virtual bool HasUVMorph() const = 0;
 
 		virtual size_t GetIndexElementSize() const = 0;
 		virtual size_t GetIndexCount() const = 0;
@@ -144,6 +161,9 @@ namespace saba
 
 		virtual size_t GetMaterialCount() const = 0;
 		virtual const MMDMaterial* GetMaterials() const = 0;
+		// Material Morph などでマテリアルが変更されたか (ClearMaterialsDirty まで保持)
+		virtual bool MaterialsDirty() const = 0;
+		virtual void ClearMaterialsDirty() = 0;
 
 		virtual size_t GetSubMeshCount() const = 0;
 		virtual const MMDSubMesh* GetSubMeshes() const = 0;
@@ -179,6 +199,16 @@ namespace saba
 		void UpdateAllAnimation(VMDAnimation* vmdAnim, float vmdFrame, float physicsElapsed);
 		void LoadPose(const VPDFile& vpd, int frameCount = 30);
 
+		const MMDNodeHierarchy& GetNodeHierarchy() const { return m_nodeHierarchy; }
+
+	protected:
+		// ノードの親子関係を作成した後に呼ぶ
+		void SetupNodeHierarchy();
+		void ClearNodeHierarchy();
+
+	private:
+		MMDNodeHierarchy	m_nodeHierarchy;
+
 	protected:
 		template <typename NodeType>
 		class MMDNodeManagerT : public MMDNodeManager
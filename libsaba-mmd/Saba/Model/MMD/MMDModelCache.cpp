@@ -0,0 +1,395 @@
+﻿//
+// Copyright(c) 2016-2017 benikabocha.
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+//
+
+#include "MMDModelCache.h"
+
+#include <Saba/Base/File.h>
+#include <Saba/Base/Log.h>
+#include <Saba/Base/Path.h>
+
+#include <atomic>
+#include <cinttypes>
+#include <cstdio>
+
+#if _WIN32
+#include <process.h>
+#else // !_WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif // !_WIN32
+
+namespace saba
+{
+	namespace
+	{
+		const char		CacheMagic[8] = { 'S', 'A', 'B', 'A', 'M', 'D', 'L', 'C' };
+		const uint32_t	CacheFormatVersion = 1;
+		const size_t	CacheAlignment = 16;
+
+		struct CacheHeader
+		{
+			char		m_magic[8];
+			uint32_t	m_formatVersion;
+			uint32_t	m_loaderVersion;
+			uint64_t	m_sourceSize;
+			uint64_t	m_sourceHash;
+			uint64_t	m_pathHash;
+			uint64_t	m_payloadSize;
+		};
+		static_assert(sizeof(CacheHeader) % CacheAlignment == 0, "payload must start aligned");
+
+		std::string			g_modelCacheDir;
+		std::atomic<bool>	g_modelCacheWriteWarned(false);
+
+		// FNV-1a (8 byte 単位、キャッシュのキー用)
+		uint64_t Hash(const char* data, size_t size, uint64_t hash = 14695981039346656037ULL)
+		{
+			const uint64_t prime = 1099511628211ULL;
+			size_t i = 0;
+			for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t))
+			{
+				uint64_t word;
+				memcpy(&word, data + i, sizeof(uint64_t));
+				hash = (hash ^ word) * prime;
+			}
+			for (; i < size; i++)
+			{
+				hash = (hash ^ uint8_t(data[i])) * prime;
+			}
+			return hash;
+		}
+
+		// 同じキャッシュを書く他のプロセス/スレッドと衝突しない一時ファイル名
+		bool MakeTempFile(const std::string& filepath, std::string* tempPath)
+		{
+#if _WIN32
+			static std::atomic<uint32_t> counter(0);
+			*tempPath = filepath + "." + std::to_string(_getpid()) + "." + std::to_string(counter++) + ".tmp";
+			return true;
+#else // !_WIN32
+			std::string path = filepath + ".XXXXXX";
+			int fd = mkstemp(&path[0]);
+			if (fd == -1)
+			{
+				return false;
+			}
+			close(fd);
+			*tempPath = path;
+			return true;
+#endif // !_WIN32
+		}
+
+		// 読み取り専用のディレクトリなどでは毎回失敗するので、警告は1回だけ出す
+		void WarnWriteFail(const std::string& filepath)
+		{
+			if (!g_modelCacheWriteWarned.exchange(true))
+			{
+				SABA_WARN("Write Model Cache Fail: [{}]", filepath);
+			}
+		}
+	}
+
+	bool MakeModelCacheKey(const std::string& filepath, const std::string& mmdDataDir, MMDModelCacheKey* key)
+	{
+		File file;
+		std::vector<char> source;
+		if (!file.Open(filepath) || !file.ReadAll(&source))
+		{
+			return false;
+		}
+		key->m_sourceSize = source.size();
+		key->m_sourceHash = Hash(source.data(), source.size());
+		// テクスチャパスはモデルパスと MMD データパスから解決済みなのでキーに含める
+		std::string paths = filepath + '\0' + mmdDataDir;
+		key->m_pathHash = Hash(paths.data(), paths.size());
+		return true;
+	}
+
+	std::string GetModelCachePath(const std::string& filepath, const MMDModelCacheKey& key)
+	{
+		// 別のディレクトリにある同名のモデルと区別するため、パスのハッシュを付ける
+		char pathHash[17];
+		snprintf(pathHash, sizeof(pathHash), "%016" PRIx64, key.m_pathHash);
+		return PathUtil::Combine(g_modelCacheDir, PathUtil::GetFilename(filepath) + "." + pathHash + ".cache");
+	}
+
+	void SetModelCacheDirectory(const std::string& dir)
+	{
+		g_modelCacheDir = dir;
+	}
+
+	const std::string& GetModelCacheDirectory()
+	{
+		return g_modelCacheDir;
+	}
+
+	bool IsModelCacheEnabled()
+	{
+		return !g_modelCacheDir.empty();
+	}
+
+	void MMDModelCacheWriter::WriteString(const std::string& str)
+	{
+		Write(uint32_t(str.size()));
+		Append(str.data(), str.size());
+	}
+
+	bool MMDModelCacheWriter::Save(const std::string& filepath, uint32_t loaderVersion, const MMDModelCacheKey& key)
+	{
+		CacheHeader header;
+		memcpy(header.m_magic, CacheMagic, sizeof(CacheMagic));
+		header.m_formatVersion = CacheFormatVersion;
+		header.m_loaderVersion = loaderVersion;
+		header.m_sourceSize = key.m_sourceSize;
+		header.m_sourceHash = key.m_sourceHash;
+		header.m_pathHash = key.m_pathHash;
+		header.m_payloadSize = m_payload.size();
+
+		// 書き込み途中のファイルを読まないように、一時ファイルに書いてから置き換える
+		std::string tempPath;
+		if (!MakeTempFile(filepath, &tempPath))
+		{
+			WarnWriteFail(filepath);
+			return false;
+		}
+		{
+			File file;
+			if (!file.Create(tempPath))
+			{
+				remove(tempPath.c_str());
+				WarnWriteFail(filepath);
+				return false;
+			}
+			if (!file.Write(&header) || !file.Write(m_payload.data(), m_payload.size()))
+			{
+				file.Close();
+				remove(tempPath.c_str());
+				WarnWriteFail(filepath);
+				return false;
+			}
+		}
+#if _WIN32
+		remove(filepath.c_str());
+#endif // _WIN32
+		if (rename(tempPath.c_str(), filepath.c_str()) != 0)
+		{
+			remove(tempPath.c_str());
+			WarnWriteFail(filepath);
+			return false;
+		}
+		return true;
+	}
+
+	void MMDModelCacheWriter::Append(const void* data, size_t size)
+	{
+		const char* src = static_cast<const char*>(data);
+		m_payload.insert(m_payload.end(), src, src + size);
+	}
+
+	void MMDModelCacheWriter::Align()
+	{
+		size_t padding = (CacheAlignment - m_payload.size() % CacheAlignment) % CacheAlignment;
+		m_payload.resize(m_payload.size() + padding, '\0');
+	}
+
+	MMDModelCacheReader::MMDModelCacheReader()
+		: m_mapping(nullptr)
+		, m_mappingSize(0)
+		, m_payload(nullptr)
+		, m_payloadSize(0)
+		, m_pos(0)
+		, m_badFlag(false)
+	{
+	}
+
+	MMDModelCacheReader::~MMDModelCacheReader()
+	{
+		Close();
+	}
+
+	bool MMDModelCacheReader::Open(const std::string& filepath, uint32_t loaderVersion, const MMDModelCacheKey& key)
+	{
+		Close();
+
+		const char* data = nullptr;
+		size_t size = 0;
+#if _WIN32
+		File file;
+		if (!file.Open(filepath) || !file.ReadAll(&m_buffer))
+		{
+			return false;
+		}
+		data = m_buffer.data();
+		size = m_buffer.size();
+#else // !_WIN32
+		int fd = open(filepath.c_str(), O_RDONLY);
+		if (fd == -1)
+		{
+			return false;
+		}
+		struct stat st;
+		if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(CacheHeader))
+		{
+			close(fd);
+			return false;
+		}
+		void* mapping = mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+		close(fd);
+		if (mapping == MAP_FAILED)
+		{
+			return false;
+		}
+		m_mapping = mapping;
+		m_mappingSize = size_t(st.st_size);
+		data = static_cast<const char*>(mapping);
+		size = m_mappingSize;
+#endif // !_WIN32
+
+		CacheHeader header;
+		if (size < sizeof(CacheHeader))
+		{
+			Close();
+			return false;
+		}
+		memcpy(&header, data, sizeof(CacheHeader));
+		if (memcmp(header.m_magic, CacheMagic, sizeof(CacheMagic)) != 0 ||
+			header.m_formatVersion != CacheFormatVersion ||
+			header.m_loaderVersion != loaderVersion ||
+			header.m_sourceSize != key.m_sourceSize ||
+			header.m_sourceHash != key.m_sourceHash ||
+			header.m_pathHash != key.m_pathHash ||
+			header.m_payloadSize != size - sizeof(CacheHeader))
+		{
+			Close();
+			return false;
+		}
+		m_payload = data + sizeof(CacheHeader);
+		m_payloadSize = size_t(header.m_payloadSize);
+		m_pos = 0;
+		m_badFlag = false;
+		return true;
+	}
+
+	void MMDModelCacheReader::Close()
+	{
+#if !_WIN32
+		if (m_mapping != nullptr)
+		{
+			munmap(m_mapping, m_mappingSize);
+		}
+#endif // !_WIN32
+		m_mapping = nullptr;
+		m_mappingSize = 0;
+		m_buffer.clear();
+		m_buffer.shrink_to_fit();
+		m_payload = nullptr;
+		m_payloadSize = 0;
+		m_pos = 0;
+	}
+
+	bool MMDModelCacheReader::ReadString(std::string* str)
+	{
+		uint32_t size;
+		if (!Read(&size))
+		{
+			return false;
+		}
+		const char* src = Consume(size);
+		if (src == nullptr)
+		{
+			return false;
+		}
+		str->assign(src, size);
+		return true;
+	}
+
+	const char* MMDModelCacheReader::Consume(size_t size)
+	{
+		if (m_badFlag || m_payload == nullptr || size > m_payloadSize - m_pos)
+		{
+			m_badFlag = true;
+			return nullptr;
+		}
+		const char* src = m_payload + m_pos;
+		m_pos += size;
+		return src;
+	}
+
+	bool MMDModelCacheReader::Align()
+	{
+		size_t padding = (CacheAlignment - m_pos % CacheAlignment) % CacheAlignment;
+		return Consume(padding) != nullptr;
+	}
+
+	void WriteModelCacheMaterials(MMDModelCacheWriter* cache, const std::vector<MMDMaterial>& materials)
+	{
+		cache->Write(uint64_t(materials.size()));
+		for (const auto& mat : materials)
+		{
+			cache->Write(mat.m_diffuse);
+			cache->Write(mat.m_alpha);
+			cache->Write(mat.m_specular);
+			cache->Write(mat.m_specularPower);
+			cache->Write(mat.m_ambient);
+			cache->Write(mat.m_edgeFlag);
+			cache->Write(mat.m_edgeSize);
+			cache->Write(mat.m_edgeColor);
+			cache->WriteString(mat.m_texture);
+			cache->WriteString(mat.m_spTexture);
+			cache->Write(mat.m_spTextureMode);
+			cache->WriteString(mat.m_toonTexture);
+			cache->Write(mat.m_textureMulFactor);
+			cache->Write(mat.m_spTextureMulFactor);
+			cache->Write(mat.m_toonTextureMulFactor);
+			cache->Write(mat.m_textureAddFactor);
+			cache->Write(mat.m_spTextureAddFactor);
+			cache->Write(mat.m_toonTextureAddFactor);
+			cache->Write(mat.m_bothFace);
+			cache->Write(mat.m_groundShadow);
+			cache->Write(mat.m_shadowCaster);
+			cache->Write(mat.m_shadowReceiver);
+		}
+	}
+
+	bool ReadModelCacheMaterials(MMDModelCacheReader* cache, std::vector<MMDMaterial>* materials)
+	{
+		uint64_t count;
+		if (!cache->Read(&count))
+		{
+			return false;
+		}
+		materials->clear();
+		for (uint64_t i = 0; i < count && !cache->IsBad(); i++)
+		{
+			MMDMaterial mat;
+			cache->Read(&mat.m_diffuse);
+			cache->Read(&mat.m_alpha);
+			cache->Read(&mat.m_specular);
+			cache->Read(&mat.m_specularPower);
+			cache->Read(&mat.m_ambient);
+			cache->Read(&mat.m_edgeFlag);
+			cache->Read(&mat.m_edgeSize);
+			cache->Read(&mat.m_edgeColor);
+			cache->ReadString(&mat.m_texture);
+			cache->ReadString(&mat.m_spTexture);
+			cache->Read(&mat.m_spTextureMode);
+			cache->ReadString(&mat.m_toonTexture);
+			cache->Read(&mat.m_textureMulFactor);
+			cache->Read(&mat.m_spTextureMulFactor);
+			cache->Read(&mat.m_toonTextureMulFactor);
+			cache->Read(&mat.m_textureAddFactor);
+			cache->Read(&mat.m_spTextureAddFactor);
+			cache->Read(&mat.m_toonTextureAddFactor);
+			cache->Read(&mat.m_bothFace);
+			cache->Read(&mat.m_groundShadow);
+			cache->Read(&mat.m_shadowCaster);
+			cache->Read(&mat.m_shadowReceiver);
+			materials->emplace_back(std::move(mat));
+		}
+		return !cache->IsBad();
+	}
+}
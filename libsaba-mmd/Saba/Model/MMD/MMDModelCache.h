@@ -0,0 +1,167 @@
+﻿//
+// Copyright(c) 2016-2017 benikabocha.
+// Distributed under the MIT License (http://opensource.org/licenses/MIT)
+//
+
+#ifndef SABA_MODEL_MMD_MMDMODELCACHE_H_
+#define SABA_MODEL_MMD_MMDMODELCACHE_H_
+
+#include "MMDMaterial.h"
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <type_traits>
+
+namespace saba
+{
+	/*
+	ロード後のモデルデータのキャッシュ (<キャッシュディレクトリ>/<モデルファイル名>.<パスのハッシュ>.cache)
+	ポインタを含まない形式で書き出し、1回の mmap で読み込む
+
+	Header
+	  char[8]	"SABAMDLC"
+	  uint32_t	format version
+	  uint32_t	loader version (PMXModel / PMDModel ごと)
+	  uint64_t	source size
+	  uint64_t	source hash (ファイル内容)
+	  uint64_t	path hash (モデルパス + MMD データパス)
+	  uint64_t	payload size
+	Payload
+	  値、文字列 (uint32_t 長さ + UTF-8)、配列 (uint64_t 要素数 + 16 byte 境界の生データ) の並び
+
+	ネイティブのエンディアン/構造体レイアウトのまま書き出すので、ビルド間で共有しないこと
+	(構造体を変更したらローダーのバージョンを上げる)
+	*/
+	struct MMDModelCacheKey
+	{
+		uint64_t	m_sourceSize;
+		uint64_t	m_sourceHash;
+		uint64_t	m_pathHash;
+	};
+
+	bool MakeModelCacheKey(const std::string& filepath, const std::string& mmdDataDir, MMDModelCacheKey* key);
+	std::string GetModelCachePath(const std::string& filepath, const MMDModelCacheKey& key);
+
+	// キャッシュを置くディレクトリを設定する (デフォルト: 空 = キャッシュ無効)
+	// モデルと同じディレクトリには書き込まない。ロード前に設定すること
+	void SetModelCacheDirectory(const std::string& dir);
+	const std::string& GetModelCacheDirectory();
+	bool IsModelCacheEnabled();
+
+	class MMDModelCacheWriter
+	{
+	public:
+		template <typename T>
+		void Write(const T& val)
+		{
+			static_assert(std::is_trivially_copyable<T>::value, "MMDModelCacheWriter::Write needs a trivially copyable type");
+			Append(&val, sizeof(T));
+		}
+
+		void WriteString(const std::string& str);
+
+		template <typename T>
+		void WriteArray(const T* data, size_t count)
+		{
+			static_assert(std::is_trivially_copyable<T>::value, "MMDModelCacheWriter::WriteArray needs a trivially copyable type");
+			Write(uint64_t(count));
+			Align();
+			Append(data, sizeof(T) * count);
+		}
+
+		template <typename T>
+		void WriteArray(const std::vector<T>& arr)
+		{
+			WriteArray(arr.data(), arr.size());
+		}
+
+		bool Save(const std::string& filepath, uint32_t loaderVersion, const MMDModelCacheKey& key);
+
+	private:
+		void Append(const void* data, size_t size);
+		void Align();
+
+	private:
+		std::vector<char>	m_payload;
+	};
+
+	class MMDModelCacheReader
+	{
+	public:
+		MMDModelCacheReader();
+		~MMDModelCacheReader();
+
+		MMDModelCacheReader(const MMDModelCacheReader&) = delete;
+		MMDModelCacheReader& operator = (const MMDModelCacheReader&) = delete;
+
+		// ヘッダーのバージョン、キーが一致しない場合は false
+		bool Open(const std::string& filepath, uint32_t loaderVersion, const MMDModelCacheKey& key);
+		void Close();
+		bool IsBad() const { return m_badFlag; }
+		bool IsEOF() const { return m_pos == m_payloadSize; }
+
+		template <typename T>
+		bool Read(T* val)
+		{
+			static_assert(std::is_trivially_copyable<T>::value, "MMDModelCacheReader::Read needs a trivially copyable type");
+			const char* src = Consume(sizeof(T));
+			if (src == nullptr)
+			{
+				return false;
+			}
+			memcpy(val, src, sizeof(T));
+			return true;
+		}
+
+		bool ReadString(std::string* str);
+
+		// マッピングしたキャッシュ内の配列を指す (Close するまで有効)
+		template <typename T>
+		bool GetArray(const T** data, size_t* count)
+		{
+			static_assert(std::is_trivially_copyable<T>::value, "MMDModelCacheReader::GetArray needs a trivially copyable type");
+			uint64_t arrayCount;
+			if (!Read(&arrayCount) || !Align() || arrayCount > (m_payloadSize - m_pos) / sizeof(T))
+			{
+				m_badFlag = true;
+				return false;
+			}
+			*data = reinterpret_cast<const T*>(Consume(sizeof(T) * size_t(arrayCount)));
+			*count = size_t(arrayCount);
+			return true;
+		}
+
+		template <typename T>
+		bool ReadArray(std::vector<T>* arr)
+		{
+			const T* data;
+			size_t count;
+			if (!GetArray(&data, &count))
+			{
+				return false;
+			}
+			arr->assign(data, data + count);
+			return true;
+		}
+
+	private:
+		const char* Consume(size_t size);
+		bool Align();
+
+	private:
+		void*				m_mapping;
+		size_t				m_mappingSize;
+		std::vector<char>	m_buffer;	// mmap が使えない環境用
+		const char*			m_payload;
+		size_t				m_payloadSize;
+		size_t				m_pos;
+		bool				m_badFlag;
+	};
+
+	void WriteModelCacheMaterials(MMDModelCacheWriter* cache, const std::vector<MMDMaterial>& materials);
+	bool ReadModelCacheMaterials(MMDModelCacheReader* cache, std::vector<MMDMaterial>* materials);
+}
+
+#endif // !SABA_MODEL_MMD_MMDMODELCACHE_H_
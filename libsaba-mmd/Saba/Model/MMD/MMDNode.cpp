@@ -11,10 +11,41 @@
 
 namespace saba
 {
+	void MMDNodeHierarchy::Clear()
+	{
+		m_parents.clear();
+		m_locals.clear();
+		m_globals.clear();
+	}
+
+	void MMDNodeHierarchy::UpdateGlobalTransforms(size_t begin, size_t end)
+	{
+		const int32_t* parents = m_parents.data();
+		const glm::mat4* locals = m_locals.data();
+		glm::mat4* globals = m_globals.data();
+		for (size_t i = begin; i < end; i++)
+		{
+			int32_t parent = parents[i];
+			if (parent < 0)
+			{
+				globals[i] = locals[i];
+			}
+			else
+			{
+				globals[i] = globals[parent] * locals[i];
+			}
+		}
+	}
+
 	MMDNode::MMDNode()
 		: m_enableIK(false)
-		, m_local(1.0f)
-		, m_global(1.0f)
+		, m_local(&m_localStorage)
+		, m_global(&m_globalStorage)
+		, m_localStorage(1.0f)
+		, m_globalStorage(1.0f)
+		, m_hierarchy(nullptr)
+		, m_hierarchyIndex(0)
+		, m_subtreeSize(0)
 		, m_parent(nullptr)
 		, m_child(nullptr)
 		, m_next(nullptr)
@@ -76,13 +107,20 @@ namespace saba
 
 	void MMDNode::UpdateGlobalTransform()
 	{
+		if (m_hierarchy != nullptr)
+		{
+			// 部分木は連続しているので、ポインタをたどらずに順番に計算する
+			m_hierarchy->UpdateGlobalTransforms(m_hierarchyIndex, m_hierarchyIndex + m_subtreeSize);
+			return;
+		}
+
 		if (m_parent == nullptr)
 		{
-			m_global = m_local;
+			*m_global = *m_local;
 		}
 		else
 		{
-			m_global = m_parent->m_global * m_local;
+			*m_global = (*m_parent->m_global) * (*m_local);
 		}
 		MMDNode* child = m_child;
 		while (child != nullptr)
@@ -94,6 +132,12 @@ namespace saba
 
 	void MMDNode::UpdateChildTransform()
 	{
+		if (m_hierarchy != nullptr)
+		{
+			m_hierarchy->UpdateGlobalTransforms(m_hierarchyIndex + 1, m_hierarchyIndex + m_subtreeSize);
+			return;
+		}
+
 		MMDNode* child = m_child;
 		while (child != nullptr)
 		{
@@ -102,9 +146,35 @@ namespace saba
 		}
 	}
 
+	void MMDNode::BindHierarchy(MMDNodeHierarchy * hierarchy, size_t index, size_t subtreeSize)
+	{
+		hierarchy->m_locals[index] = *m_local;
+		hierarchy->m_globals[index] = *m_global;
+		m_local = &hierarchy->m_locals[index];
+		m_global = &hierarchy->m_globals[index];
+		m_hierarchy = hierarchy;
+		m_hierarchyIndex = index;
+		m_subtreeSize = subtreeSize;
+	}
+
+	void MMDNode::UnbindHierarchy()
+	{
+		if (m_hierarchy == nullptr)
+		{
+			return;
+		}
+		m_localStorage = *m_local;
+		m_globalStorage = *m_global;
+		m_local = &m_localStorage;
+		m_global = &m_globalStorage;
+		m_hierarchy = nullptr;
+		m_hierarchyIndex = 0;
+		m_subtreeSize = 0;
+	}
+
 	void MMDNode::CalculateInverseInitTransform()
 	{
-		m_inverseInit = glm::inverse(m_global);
+		m_inverseInit = glm::inverse(*m_global);
 	}
 
 	void MMDNode::OnBeginUpdateTransform()
@@ -124,7 +194,7 @@ namespace saba
 		{
 			r = glm::mat4_cast(m_ikRotate) * r;
 		}
-		m_local = t * r * s;
+		*m_local = t * r * s;
 	}
 
 }
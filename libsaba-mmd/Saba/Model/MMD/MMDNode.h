@@ -7,12 +7,26 @@
 #define SABA_MODEL_MMD_MMDNODE_H_
 
 #include <string>
+#include <vector>
 #include <glm/vec3.hpp>
 #include <glm/gtc/quaternion.hpp>
 #include <glm/mat4x4.hpp>
 
 namespace saba
 {
+	// ノードを深さ優先順 (親が先、部分木は連続した範囲) に並べた変換の配列
+	// MMDModel::SetupNodeHierarchy で作成し、各 MMDNode の変換はこの配列を参照する
+	struct MMDNodeHierarchy
+	{
+		std::vector<int32_t>	m_parents;
+		std::vector<glm::mat4>	m_locals;
+		std::vector<glm::mat4>	m_globals;
+
+		void Clear();
+		// [begin, end) のグローバル変換を順番に計算する
+		void UpdateGlobalTransforms(size_t begin, size_t end);
+	};
+
 	class MMDNode
 	{
 	public:
@@ -27,6 +41,13 @@ namespace saba
 		void UpdateGlobalTransform();
 		void UpdateChildTransform();
 
+		// 変換の格納先を MMDNodeHierarchy の配列に切り替える
+		void BindHierarchy(MMDNodeHierarchy* hierarchy, size_t index, size_t subtreeSize);
+		void UnbindHierarchy();
+		bool IsHierarchyBound() const { return m_hierarchy != nullptr; }
+		size_t GetHierarchyIndex() const { return m_hierarchyIndex; }
+		size_t GetSubtreeSize() const { return m_subtreeSize; }
+
 		void SetIndex(uint32_t idx) { m_index = idx; }
 		uint32_t GetIndex() const { return m_index; }
 
@@ -62,11 +83,11 @@ namespace saba
 		MMDNode* GetNext() const { return m_next; }
 		MMDNode* GetPrev() const { return m_prev; }
 
-		void SetLocalTransform(const glm::mat4& m) { m_local = m; }
-		const glm::mat4& GetLocalTransform() const { return m_local; }
+		void SetLocalTransform(const glm::mat4& m) { *m_local = m; }
+		const glm::mat4& GetLocalTransform() const { return *m_local; }
 
-		void SetGlobalTransform(const glm::mat4& m) { m_global = m; }
-		const glm::mat4& GetGlobalTransform() const { return m_global; }
+		void SetGlobalTransform(const glm::mat4& m) { *m_global = m; }
+		const glm::mat4& GetGlobalTransform() const { return *m_global; }
 
 		void CalculateInverseInitTransform();
 		const glm::mat4& GetInverseInitTransform() const { return m_inverseInit; }
@@ -138,10 +159,17 @@ namespace saba
 
 		glm::quat	m_ikRotate;
 
-		glm::mat4		m_local;
-		glm::mat4		m_global;
+		// MMDNodeHierarchy に登録されていない時は m_localStorage, m_globalStorage を指す
+		glm::mat4*		m_local;
+		glm::mat4*		m_global;
 		glm::mat4		m_inverseInit;
 
+		glm::mat4			m_localStorage;
+		glm::mat4			m_globalStorage;
+		MMDNodeHierarchy*	m_hierarchy;
+		size_t				m_hierarchyIndex;
+		size_t				m_subtreeSize;
+
 		glm::vec3	m_initTranslate;
 		glm::quat	m_initRotate;
 		glm::vec3	m_initScale;
@@ -54,6 +54,11 @@ namespace saba
 	};
 
 	MMDPhysics::MMDPhysics()
+		: m_enableSleeping(false)
+		, m_linearSleepingThreshold(0.01f)
+		, m_angularSleepingThreshold(glm::radians(0.1f))
+		, m_wakeUpThreshold(1.0e-4f)
+		, m_groupEnableMask(0xFFFF)
 	{
 	}
 
@@ -124,6 +129,12 @@ namespace saba
 		}
 	}
 
+	void MMDPhysics::SetSleepingThresholds(float linear, float angular)
+	{
+		m_linearSleepingThreshold = linear;
+		m_angularSleepingThreshold = angular;
+	}
+
 	void MMDPhysics::AddRigidBody(MMDRigidBody * mmdRB)
 	{
 		m_world->addRigidBody(
@@ -340,6 +351,8 @@ namespace saba
 	};
 
 	MMDRigidBody::MMDRigidBody()
+		: m_parentNode(nullptr)
+		, m_frozen(false)
 	{
 	}
 
@@ -470,6 +483,8 @@ namespace saba
 		m_group = pmdRigidBody.m_groupIndex;
 		m_groupMask = pmdRigidBody.m_groupTarget;
 		m_node = node;
+		m_parentNode = (node != nullptr && node->GetParent() != nullptr) ? node->GetParent() : kinematicNode;
+		m_parentTransform = m_parentNode->GetGlobalTransform();
 		m_name = pmdRigidBody.m_rigidBodyName.ToUtf8String();
 
 		return true;
@@ -592,6 +607,8 @@ namespace saba
 		m_group = pmxRigidBody.m_group;
 		m_groupMask = pmxRigidBody.m_collisionGroup;
 		m_node = node;
+		m_parentNode = (node != nullptr && node->GetParent() != nullptr) ? node->GetParent() : kinematicNode;
+		m_parentTransform = m_parentNode->GetGlobalTransform();
 		m_name = pmxRigidBody.m_name;
 
 		return true;
@@ -638,6 +655,75 @@ namespace saba
 		}
 	}
 
+	namespace
+	{
+		bool IsTransformChanged(const glm::mat4& a, const glm::mat4& b, float epsilon)
+		{
+			for (int i = 0; i < 4; i++)
+			{
+				glm::vec4 diff = glm::abs(a[i] - b[i]);
+				if (diff.x > epsilon || diff.y > epsilon || diff.z > epsilon || diff.w > epsilon)
+				{
+					return true;
+				}
+			}
+			return false;
+		}
+	}
+
+	void MMDRigidBody::UpdateActivation(MMDPhysics* physics)
+	{
+		if (m_rigidBodyType == RigidBodyType::Kinematic)
+		{
+			SetActivation(true);
+			return;
+		}
+
+		bool frozen = !physics->IsGroupEnabled(m_group);
+		if (frozen != m_frozen)
+		{
+			m_frozen = frozen;
+			if (!frozen)
+			{
+				// 止めていた間に動いたボーンの位置から再開する
+				ResetTransform();
+				Reset(physics);
+			}
+		}
+		SetActivation(!frozen);
+
+		// Kinematic として扱う間はボーンに追従させるため、スリープさせない
+		if (frozen || !physics->IsSleepingEnabled())
+		{
+			if (m_rigidBody->getActivationState() != DISABLE_DEACTIVATION)
+			{
+				m_rigidBody->forceActivationState(DISABLE_DEACTIVATION);
+			}
+			m_parentTransform = m_parentNode->GetGlobalTransform();
+			return;
+		}
+
+		if (m_rigidBody->getActivationState() == DISABLE_DEACTIVATION)
+		{
+			m_rigidBody->setSleepingThresholds(
+				physics->GetLinearSleepingThreshold(),
+				physics->GetAngularSleepingThreshold()
+			);
+			m_rigidBody->forceActivationState(ACTIVE_TAG);
+		}
+
+		const glm::mat4& parentTransform = m_parentNode->GetGlobalTransform();
+		if (m_rigidBody->isActive())
+		{
+			m_parentTransform = parentTransform;
+		}
+		else if (IsTransformChanged(parentTransform, m_parentTransform, physics->GetWakeUpThreshold()))
+		{
+			m_rigidBody->activate(true);
+			m_parentTransform = parentTransform;
+		}
+	}
+
 	void MMDRigidBody::ResetTransform()
 	{
 		if (m_activeMotionState != nullptr)
@@ -661,7 +747,7 @@ namespace saba
 
 	void MMDRigidBody::ReflectGlobalTransform()
 	{
-		if (m_activeMotionState != nullptr)
+		if (m_activeMotionState != nullptr && !m_frozen)
 		{
 			m_activeMotionState->ReflectGlobalTransform();
 		}
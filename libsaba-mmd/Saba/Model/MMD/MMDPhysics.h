@@ -53,6 +53,9 @@ namespace saba
 		uint16_t GetGroupMask() const;
 
 		void SetActivation(bool activation);
+		// グループマスクとスリープ判定を反映する (Physics 更新前に呼ぶ)
+		void UpdateActivation(MMDPhysics* physics);
+		bool IsFrozen() const { return m_frozen; }
 		void ResetTransform();
 		void Reset(MMDPhysics* physics);
 
@@ -83,6 +86,11 @@ namespace saba
 		glm::mat4	m_offsetMat;
 		glm::mat4	m_invOffsetMat;
 
+		// スリープ中の剛体を起こす判定用 (動かしている親ボーン)
+		MMDNode*	m_parentNode;
+		glm::mat4	m_parentTransform;
+		bool		m_frozen;
+
 		std::string					m_name;
 	};
 
@@ -118,6 +126,22 @@ namespace saba
 
 		void Update(float time);
 
+		// 静止した剛体のスリープ (デフォルトは無効)
+		void EnableSleeping(bool enable) { m_enableSleeping = enable; }
+		bool IsSleepingEnabled() const { return m_enableSleeping; }
+		void SetSleepingThresholds(float linear, float angular);
+		float GetLinearSleepingThreshold() const { return m_linearSleepingThreshold; }
+		float GetAngularSleepingThreshold() const { return m_angularSleepingThreshold; }
+		// 親ボーンの変化がこの値を超えたらスリープ中の剛体を起こす
+		void SetWakeUpThreshold(float epsilon) { m_wakeUpThreshold = epsilon; }
+		float GetWakeUpThreshold() const { return m_wakeUpThreshold; }
+
+		// 剛体グループ単位の有効マスク (bit = 1 << group)
+		// 無効なグループの剛体は物理演算を止めてボーンに追従させる
+		void SetGroupEnableMask(uint16_t mask) { m_groupEnableMask = mask; }
+		uint16_t GetGroupEnableMask() const { return m_groupEnableMask; }
+		bool IsGroupEnabled(uint16_t group) const { return (m_groupEnableMask & (1 << group)) != 0; }
+
 		void AddRigidBody(MMDRigidBody* mmdRB);
 		void RemoveRigidBody(MMDRigidBody* mmdRB);
 		void AddJoint(MMDJoint* mmdJoint);
@@ -135,6 +159,12 @@ namespace saba
 		std::unique_ptr<btMotionState>						m_groundMS;
 		std::unique_ptr<btRigidBody>						m_groundRB;
 		std::unique_ptr<btOverlapFilterCallback>			m_filterCB;
+
+		bool		m_enableSleeping;
+		float		m_linearSleepingThreshold;
+		float		m_angularSleepingThreshold;
+		float		m_wakeUpThreshold;
+		uint16_t	m_groupEnableMask;
 	};
 
 }
@@ -6,6 +6,7 @@
 #include "PMDModel.h"
 #include "PMDFile.h"
 #include "MMDPhysics.h"
+#include "MMDModelCache.h"
 
 #include <Saba/Base/Path.h>
 #include <Saba/Base/File.h>
@@ -21,6 +22,9 @@ namespace saba
 {
 	namespace
 	{
+		// キャッシュに書き出す内容 (変換結果、構造体) を変えたら上げる
+		const uint32_t PMDModelCacheVersion = 1;
+
 		std::string ResolveToonTexturePath(
 			const std::string mmdDataDir,
 			const std::string mmdLoadDir,
@@ -77,6 +81,7 @@ namespace saba
 		for (auto& solver : (*m_ikSolverMan.GetIKSolvers()))
 		{
 			solver->Enable(true);
+			solver->ClearWarmStart();
 			solver->Solve();
 		}
 
@@ -89,6 +94,7 @@ namespace saba
 		{
 			node->BeginUpdateTransform();
 		}
+		m_ikSolverMan.AllocateIterationBudget();
 	}
 
 	void PMDModel::EndAnimation()
@@ -186,7 +192,7 @@ namespace saba
 		auto joints = physicsMan->GetJoints();
 		for (auto& rb : (*rigidbodys))
 		{
-			rb->SetActivation(true);
+			rb->UpdateActivation(physics);
 		}
 
 		physics->Update(elapsed);
@@ -302,14 +308,68 @@ namespace saba
 	{
 		Destroy();
 
+		// キャッシュがあれば PMD の解析、SJIS の変換、頂点/マテリアルの変換を省略する
+		MMDModelCacheKey cacheKey;
+		bool useCache = IsModelCacheEnabled() && MakeModelCacheKey(filepath, mmdDataDir, &cacheKey);
+		std::string cachePath = useCache ? GetModelCachePath(filepath, cacheKey) : std::string();
 		PMDFile pmd;
-		if (!ReadPMDFile(&pmd, filepath.c_str()))
+		std::vector<std::string> boneNames;
+		std::vector<std::string> morphNames;
+		bool cacheLoaded = false;
+		if (useCache)
+		{
+			MMDModelCacheReader cache;
+			if (cache.Open(cachePath, PMDModelCacheVersion, cacheKey))
+			{
+				cacheLoaded = ReadCache(&cache, &pmd, &boneNames, &morphNames);
+				if (!cacheLoaded)
+				{
+					SABA_WARN("Broken Model Cache: [{}]", cachePath);
+					Destroy();
+					pmd = PMDFile();
+				}
+			}
+		}
+
+		if (!cacheLoaded)
+		{
+			if (!ReadPMDFile(&pmd, filepath.c_str()))
+			{
+				return false;
+			}
+			if (!SetupMesh(pmd, PathUtil::GetDirectoryName(filepath), mmdDataDir))
+			{
+				return false;
+			}
+			boneNames.clear();
+			for (const auto& bone : pmd.m_bones)
+			{
+				boneNames.emplace_back(bone.m_boneName.ToUtf8String());
+			}
+			morphNames.clear();
+			for (const auto& morph : pmd.m_morphs)
+			{
+				morphNames.emplace_back(morph.m_morphName.ToUtf8String());
+			}
+		}
+
+		if (!Setup(pmd, boneNames, morphNames))
 		{
 			return false;
 		}
 
-		std::string dirPath = PathUtil::GetDirectoryName(filepath);
+		if (useCache && !cacheLoaded)
+		{
+			MMDModelCacheWriter cache;
+			WriteCache(&cache, pmd, boneNames, morphNames);
+			cache.Save(cachePath, PMDModelCacheVersion, cacheKey); // 失敗時の警告は Save が出す
+		}
 
+		return true;
+	}
+
+	bool PMDModel::SetupMesh(const PMDFile& pmd, const std::string& dirPath, const std::string& mmdDataDir)
+	{
 		size_t vertexCount = pmd.m_vertices.size();
 		m_positions.reserve(vertexCount);
 		m_normals.reserve(vertexCount);
@@ -333,9 +393,6 @@ namespace saba
 			m_bboxMax = glm::max(m_bboxMax, pos);
 			m_bboxMin = glm::min(m_bboxMin, pos);
 		}
-		m_updatePositions.resize(m_positions.size());
-		m_updateNormals.resize(m_normals.size());
-
 		m_indices.reserve(pmd.m_faces.size() * 3);
 		for (const auto& face : pmd.m_faces)
 		{
@@ -440,8 +497,21 @@ namespace saba
 			beginIndex = beginIndex + pmdMat.m_faceVertexCount;
 		}
 
-		for (const auto& pmdMorph : pmd.m_morphs)
+		return true;
+	}
+
+	bool PMDModel::Setup(
+		const PMDFile& pmd,
+		const std::vector<std::string>& boneNames,
+		const std::vector<std::string>& morphNames
+	)
+	{
+		m_updatePositions.resize(m_positions.size());
+		m_updateNormals.resize(m_normals.size());
+
+		for (size_t i = 0; i < pmd.m_morphs.size(); i++)
 		{
+			const auto& pmdMorph = pmd.m_morphs[i];
 			PMDMorph* morph = nullptr;
 			if (pmdMorph.m_morphType == saba::PMDMorph::Base)
 			{
@@ -450,7 +520,7 @@ namespace saba
 			else
 			{
 				morph = m_morphMan.AddMorph();
-				morph->SetName(pmdMorph.m_morphName.ToUtf8String());
+				morph->SetName(morphNames[i]);
 			}
 			size_t numVtx = pmdMorph.m_vertices.size();
 			morph->SetWeight(0.0f);
@@ -466,10 +536,10 @@ namespace saba
 
 		// Nodeの作成
 		m_nodeMan.GetNodes()->reserve(pmd.m_bones.size());
-		for (const auto& bone : pmd.m_bones)
+		for (const auto& boneName : boneNames)
 		{
 			auto* node = m_nodeMan.AddNode();
-			node->SetName(bone.m_boneName.ToUtf8String());
+			node->SetName(boneName);
 		}
 		for (size_t i = 0; i < pmd.m_bones.size(); i++)
 		{
@@ -500,6 +570,7 @@ namespace saba
 			node->CalculateInverseInitTransform();
 			node->SaveInitialTRS();
 		}
+		SetupNodeHierarchy();
 		m_transforms.resize(m_nodeMan.GetNodeCount());
 
 		// IKを作成
@@ -584,6 +655,122 @@ namespace saba
 		return true;
 	}
 
+	void PMDModel::WriteCache(
+		MMDModelCacheWriter* cache,
+		const PMDFile& pmd,
+		const std::vector<std::string>& boneNames,
+		const std::vector<std::string>& morphNames
+	) const
+	{
+		// 変換済みの頂点、インデックス、マテリアル
+		cache->WriteArray(m_positions);
+		cache->WriteArray(m_normals);
+		cache->WriteArray(m_uvs);
+		cache->WriteArray(m_bones);
+		cache->WriteArray(m_boneWeights);
+		cache->Write(m_bboxMin);
+		cache->Write(m_bboxMax);
+		cache->WriteArray(m_indices);
+		WriteModelCacheMaterials(cache, m_materials);
+		cache->WriteArray(m_subMeshes);
+
+		// Node、IK、Morph、Physics の生成に使う情報 (名前は UTF-8 に変換済み)
+		cache->WriteArray(pmd.m_bones);
+		for (const auto& boneName : boneNames)
+		{
+			cache->WriteString(boneName);
+		}
+		cache->Write(uint64_t(pmd.m_iks.size()));
+		for (const auto& ik : pmd.m_iks)
+		{
+			cache->Write(ik.m_ikNode);
+			cache->Write(ik.m_ikTarget);
+			cache->Write(ik.m_numIteration);
+			cache->Write(ik.m_rotateLimit);
+			cache->WriteArray(ik.m_chanins);
+		}
+		cache->Write(uint64_t(pmd.m_morphs.size()));
+		for (size_t i = 0; i < pmd.m_morphs.size(); i++)
+		{
+			cache->WriteString(morphNames[i]);
+			cache->Write(pmd.m_morphs[i].m_morphType);
+			cache->WriteArray(pmd.m_morphs[i].m_vertices);
+		}
+		cache->WriteArray(pmd.m_rigidBodies);
+		cache->WriteArray(pmd.m_joints);
+	}
+
+	bool PMDModel::ReadCache(
+		MMDModelCacheReader* cache,
+		PMDFile* pmd,
+		std::vector<std::string>* boneNames,
+		std::vector<std::string>* morphNames
+	)
+	{
+		cache->ReadArray(&m_positions);
+		cache->ReadArray(&m_normals);
+		cache->ReadArray(&m_uvs);
+		cache->ReadArray(&m_bones);
+		cache->ReadArray(&m_boneWeights);
+		cache->Read(&m_bboxMin);
+		cache->Read(&m_bboxMax);
+		cache->ReadArray(&m_indices);
+		ReadModelCacheMaterials(cache, &m_materials);
+		cache->ReadArray(&m_subMeshes);
+
+		cache->ReadArray(&pmd->m_bones);
+		boneNames->resize(pmd->m_bones.size());
+		for (auto& boneName : *boneNames)
+		{
+			cache->ReadString(&boneName);
+		}
+		uint64_t ikCount = 0;
+		cache->Read(&ikCount);
+		pmd->m_iks.clear();
+		for (uint64_t i = 0; i < ikCount && !cache->IsBad(); i++)
+		{
+			PMDIk ik;
+			cache->Read(&ik.m_ikNode);
+			cache->Read(&ik.m_ikTarget);
+			cache->Read(&ik.m_numIteration);
+			cache->Read(&ik.m_rotateLimit);
+			cache->ReadArray(&ik.m_chanins);
+			ik.m_numChain = uint8_t(ik.m_chanins.size());
+			pmd->m_iks.emplace_back(std::move(ik));
+		}
+		uint64_t morphCount = 0;
+		cache->Read(&morphCount);
+		pmd->m_morphs.clear();
+		morphNames->clear();
+		for (uint64_t i = 0; i < morphCount && !cache->IsBad(); i++)
+		{
+			saba::PMDMorph morph;
+			std::string morphName;
+			cache->ReadString(&morphName);
+			cache->Read(&morph.m_morphType);
+			cache->ReadArray(&morph.m_vertices);
+			pmd->m_morphs.emplace_back(std::move(morph));
+			morphNames->emplace_back(std::move(morphName));
+		}
+		cache->ReadArray(&pmd->m_rigidBodies);
+		cache->ReadArray(&pmd->m_joints);
+		if (cache->IsBad() || !cache->IsEOF())
+		{
+			return false;
+		}
+
+		size_t vertexCount = m_positions.size();
+		if (m_normals.size() != vertexCount ||
+			m_uvs.size() != vertexCount ||
+			m_bones.size() != vertexCount ||
+			m_boneWeights.size() != vertexCount ||
+			m_subMeshes.size() != m_materials.size())
+		{
+			return false;
+		}
+		return true;
+	}
+
 	void PMDModel::Destroy()
 	{
 		m_materials.clear();
@@ -597,6 +784,7 @@ namespace saba
 
 		m_indices.clear();
 
+		ClearNodeHierarchy();
 		m_nodeMan.GetNodes()->clear();
 	}
 
@@ -18,6 +18,10 @@
 
 namespace saba
 {
+	struct PMDFile;
+	class MMDModelCacheReader;
+	class MMDModelCacheWriter;
+
 	class PMDModel : public MMDModel
 	{
 	public:
@@ -33,6 +37,7 @@ namespace saba
 		const glm::vec3* GetUpdatePositions() const override { return &m_updatePositions[0]; }
 		const glm::vec3* GetUpdateNormals() const override { return &m_updateNormals[0]; }
 		const glm::vec2* GetUpdateUVs() const override { return &m_uvs[0]; }
+		bool HasUVMorph() const override { return false; }
 
 		size_t GetIndexElementSize() const override { return sizeof(uint16_t); }
 		size_t GetIndexCount() const override { return m_indices.size(); }
@@ -40,6 +45,8 @@ namespace saba
 
 		size_t GetMaterialCount() const override { return m_materials.size(); }
 		const MMDMaterial* GetMaterials() const override { return &m_materials[0]; }
+		bool MaterialsDirty() const override { return false; }
+		void ClearMaterialsDirty() override {}
 
 		size_t GetSubMeshCount() const override { return m_subMeshes.size(); }
 		const MMDSubMesh* GetSubMeshes() const override { return &m_subMeshes[0]; }
@@ -69,6 +76,26 @@ namespace saba
 
 	protected:
 
+	private:
+		bool SetupMesh(const PMDFile& pmd, const std::string& dirPath, const std::string& mmdDataDir);
+		bool Setup(
+			const PMDFile& pmd,
+			const std::vector<std::string>& boneNames,
+			const std::vector<std::string>& morphNames
+		);
+		void WriteCache(
+			MMDModelCacheWriter* cache,
+			const PMDFile& pmd,
+			const std::vector<std::string>& boneNames,
+			const std::vector<std::string>& morphNames
+		) const;
+		bool ReadCache(
+			MMDModelCacheReader* cache,
+			PMDFile* pmd,
+			std::vector<std::string>* boneNames,
+			std::vector<std::string>* morphNames
+		);
+
 	private:
 		struct MorphVertex
 		{
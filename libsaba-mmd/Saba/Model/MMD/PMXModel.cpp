@@ -7,6 +7,7 @@
 
 #include "PMXFile.h"
 #include "MMDPhysics.h"
+#include "MMDModelCache.h"
 
 #include <Saba/Base/Path.h>
 #include <Saba/Base/File.h>
@@ -29,8 +30,200 @@
 
 namespace saba
 {
+	namespace
+	{
+		// キャッシュに書き出す内容 (変換結果、構造体) を変えたら上げる
+		const uint32_t PMXModelCacheVersion = 1;
+
+		void WriteBones(MMDModelCacheWriter* cache, const std::vector<PMXBone>& bones)
+		{
+			cache->Write(uint64_t(bones.size()));
+			for (const auto& bone : bones)
+			{
+				cache->WriteString(bone.m_name);
+				cache->Write(bone.m_position);
+				cache->Write(bone.m_parentBoneIndex);
+				cache->Write(bone.m_deformDepth);
+				cache->Write(bone.m_boneFlag);
+				cache->Write(bone.m_appendBoneIndex);
+				cache->Write(bone.m_appendWeight);
+				cache->Write(bone.m_ikTargetBoneIndex);
+				cache->Write(bone.m_ikIterationCount);
+				cache->Write(bone.m_ikLimit);
+				cache->WriteArray(bone.m_ikLinks);
+			}
+		}
+
+		bool ReadBones(MMDModelCacheReader* cache, std::vector<PMXBone>* bones)
+		{
+			uint64_t count;
+			if (!cache->Read(&count))
+			{
+				return false;
+			}
+			bones->clear();
+			for (uint64_t i = 0; i < count && !cache->IsBad(); i++)
+			{
+				PMXBone bone;
+				cache->ReadString(&bone.m_name);
+				cache->Read(&bone.m_position);
+				cache->Read(&bone.m_parentBoneIndex);
+				cache->Read(&bone.m_deformDepth);
+				cache->Read(&bone.m_boneFlag);
+				cache->Read(&bone.m_appendBoneIndex);
+				cache->Read(&bone.m_appendWeight);
+				cache->Read(&bone.m_ikTargetBoneIndex);
+				cache->Read(&bone.m_ikIterationCount);
+				cache->Read(&bone.m_ikLimit);
+				cache->ReadArray(&bone.m_ikLinks);
+				bones->emplace_back(std::move(bone));
+			}
+			return !cache->IsBad();
+		}
+
+		void WriteMorphs(MMDModelCacheWriter* cache, const std::vector<PMXMorph>& morphs)
+		{
+			cache->Write(uint64_t(morphs.size()));
+			for (const auto& morph : morphs)
+			{
+				cache->WriteString(morph.m_name);
+				cache->Write(morph.m_morphType);
+				cache->WriteArray(morph.m_positionMorph);
+				cache->WriteArray(morph.m_uvMorph);
+				cache->WriteArray(morph.m_boneMorph);
+				cache->WriteArray(morph.m_materialMorph);
+				cache->WriteArray(morph.m_groupMorph);
+			}
+		}
+
+		bool ReadMorphs(MMDModelCacheReader* cache, std::vector<PMXMorph>* morphs)
+		{
+			uint64_t count;
+			if (!cache->Read(&count))
+			{
+				return false;
+			}
+			morphs->clear();
+			for (uint64_t i = 0; i < count && !cache->IsBad(); i++)
+			{
+				PMXMorph morph;
+				cache->ReadString(&morph.m_name);
+				cache->Read(&morph.m_morphType);
+				cache->ReadArray(&morph.m_positionMorph);
+				cache->ReadArray(&morph.m_uvMorph);
+				cache->ReadArray(&morph.m_boneMorph);
+				cache->ReadArray(&morph.m_materialMorph);
+				cache->ReadArray(&morph.m_groupMorph);
+				morphs->emplace_back(std::move(morph));
+			}
+			return !cache->IsBad();
+		}
+
+		void WriteRigidbodies(MMDModelCacheWriter* cache, const std::vector<PMXRigidbody>& rigidbodies)
+		{
+			cache->Write(uint64_t(rigidbodies.size()));
+			for (const auto& rb : rigidbodies)
+			{
+				cache->WriteString(rb.m_name);
+				cache->Write(rb.m_boneIndex);
+				cache->Write(rb.m_group);
+				cache->Write(rb.m_collisionGroup);
+				cache->Write(rb.m_shape);
+				cache->Write(rb.m_shapeSize);
+				cache->Write(rb.m_translate);
+				cache->Write(rb.m_rotate);
+				cache->Write(rb.m_mass);
+				cache->Write(rb.m_translateDimmer);
+				cache->Write(rb.m_rotateDimmer);
+				cache->Write(rb.m_repulsion);
+				cache->Write(rb.m_friction);
+				cache->Write(rb.m_op);
+			}
+		}
+
+		bool ReadRigidbodies(MMDModelCacheReader* cache, std::vector<PMXRigidbody>* rigidbodies)
+		{
+			uint64_t count;
+			if (!cache->Read(&count))
+			{
+				return false;
+			}
+			rigidbodies->clear();
+			for (uint64_t i = 0; i < count && !cache->IsBad(); i++)
+			{
+				PMXRigidbody rb;
+				cache->ReadString(&rb.m_name);
+				cache->Read(&rb.m_boneIndex);
+				cache->Read(&rb.m_group);
+				cache->Read(&rb.m_collisionGroup);
+				cache->Read(&rb.m_shape);
+				cache->Read(&rb.m_shapeSize);
+				cache->Read(&rb.m_translate);
+				cache->Read(&rb.m_rotate);
+				cache->Read(&rb.m_mass);
+				cache->Read(&rb.m_translateDimmer);
+				cache->Read(&rb.m_rotateDimmer);
+				cache->Read(&rb.m_repulsion);
+				cache->Read(&rb.m_friction);
+				cache->Read(&rb.m_op);
+				rigidbodies->emplace_back(std::move(rb));
+			}
+			return !cache->IsBad();
+		}
+
+		void WriteJoints(MMDModelCacheWriter* cache, const std::vector<PMXJoint>& joints)
+		{
+			cache->Write(uint64_t(joints.size()));
+			for (const auto& joint : joints)
+			{
+				cache->WriteString(joint.m_name);
+				cache->Write(joint.m_type);
+				cache->Write(joint.m_rigidbodyAIndex);
+				cache->Write(joint.m_rigidbodyBIndex);
+				cache->Write(joint.m_translate);
+				cache->Write(joint.m_rotate);
+				cache->Write(joint.m_translateLowerLimit);
+				cache->Write(joint.m_translateUpperLimit);
+				cache->Write(joint.m_rotateLowerLimit);
+				cache->Write(joint.m_rotateUpperLimit);
+				cache->Write(joint.m_springTranslateFactor);
+				cache->Write(joint.m_springRotateFactor);
+			}
+		}
+
+		bool ReadJoints(MMDModelCacheReader* cache, std::vector<PMXJoint>* joints)
+		{
+			uint64_t count;
+			if (!cache->Read(&count))
+			{
+				return false;
+			}
+			joints->clear();
+			for (uint64_t i = 0; i < count && !cache->IsBad(); i++)
+			{
+				PMXJoint joint;
+				cache->ReadString(&joint.m_name);
+				cache->Read(&joint.m_type);
+				cache->Read(&joint.m_rigidbodyAIndex);
+				cache->Read(&joint.m_rigidbodyBIndex);
+				cache->Read(&joint.m_translate);
+				cache->Read(&joint.m_rotate);
+				cache->Read(&joint.m_translateLowerLimit);
+				cache->Read(&joint.m_translateUpperLimit);
+				cache->Read(&joint.m_rotateLowerLimit);
+				cache->Read(&joint.m_rotateUpperLimit);
+				cache->Read(&joint.m_springTranslateFactor);
+				cache->Read(&joint.m_springRotateFactor);
+				joints->emplace_back(std::move(joint));
+			}
+			return !cache->IsBad();
+		}
+	}
+
 	PMXModel::PMXModel()
-		: m_parallelUpdateCount(0)
+		: m_materialsDirty(false)
+		, m_parallelNodeUpdate(false)
+		, m_parallelUpdateCount(0)
 	{
 	}
 
@@ -64,6 +257,7 @@ namespace saba
 		for (auto& ikSolver : (*m_ikSolverMan.GetIKSolvers()))
 		{
 			ikSolver->Enable(true);
+			ikSolver->ClearWarmStart();
 		}
 
 		for (const auto& node : (*m_nodeMan.GetNodes()))
@@ -108,12 +302,7 @@ namespace saba
 		{
 			node->BeginUpdateTransform();
 		}
-		size_t vtxCount = m_morphPositions.size();
-		for (size_t vtxIdx = 0; vtxIdx < vtxCount; vtxIdx++)
-		{
-			m_morphPositions[vtxIdx] = glm::vec3(0);
-			m_morphUVs[vtxIdx] = glm::vec4(0);
-		}
+		m_ikSolverMan.AllocateIterationBudget();
 	}
 
 	void PMXModel::EndAnimation()
@@ -129,11 +318,39 @@ namespace saba
 		// Morph の処理
 		BeginMorphMaterial();
 
+		// Group Morph は末端の Morph の重みに加算し、各 Morph を1回だけ適用する
 		const auto& morphs = (*m_morphMan.GetMorphs());
+		std::fill(m_morphWeights.begin(), m_morphWeights.end(), 0.0f);
+		std::fill(m_positionMorphWeights.begin(), m_positionMorphWeights.end(), 0.0f);
+		std::fill(m_uvMorphWeights.begin(), m_uvMorphWeights.end(), 0.0f);
 		for (size_t i = 0; i < morphs.size(); i++)
 		{
 			const auto& morph = morphs[i];
-			Morph(morph.get(), morph->GetWeight());
+			float weight = morph->GetWeight();
+			if (weight == 0)
+			{
+				continue;
+			}
+			if (morph->m_morphType == MorphType::Group)
+			{
+				const auto& groupMorphData = m_groupMorphDatas[morph->m_dataIndex];
+				for (const auto& flatMorph : groupMorphData.m_flatMorphs)
+				{
+					m_morphWeights[flatMorph.m_morphIndex] += flatMorph.m_weight * weight;
+				}
+			}
+			else
+			{
+				m_morphWeights[i] += weight;
+			}
+		}
+
+		for (size_t i = 0; i < morphs.size(); i++)
+		{
+			if (m_morphWeights[i] != 0)
+			{
+				Morph(morphs[i].get(), m_morphWeights[i]);
+			}
 		}
 
 		EndMorphMaterial();
@@ -141,15 +358,22 @@ namespace saba
 
 	void PMXModel::UpdateNodeAnimation(bool afterPhysicsAnim)
 	{
-		for (auto pmxNode : m_sortedNodes)
-		{
-			if (pmxNode->IsDeformAfterPhysics() != afterPhysicsAnim)
+		ParallelNodeUpdate(
+			m_sortedNodes.size(),
+			[this, afterPhysicsAnim](size_t begin, size_t end)
 			{
-				continue;
-			}
+				for (size_t i = begin; i < end; i++)
+				{
+					auto pmxNode = m_sortedNodes[i];
+					if (pmxNode->IsDeformAfterPhysics() != afterPhysicsAnim)
+					{
+						continue;
+					}
 
-			pmxNode->UpdateLocalTransform();
-		}
+					pmxNode->UpdateLocalTransform();
+				}
+			}
+		);
 
 		for (auto pmxNode : m_sortedNodes)
 		{
@@ -164,24 +388,20 @@ namespace saba
 			}
 		}
 
-		for (auto pmxNode : m_sortedNodes)
+		// 付与と IK は変形階層順のバッチ毎に更新する (バッチ内は互いに依存しない)
+		const auto& batches = afterPhysicsAnim ? m_afterPhysicsNodeUpdateBatches : m_nodeUpdateBatches;
+		for (const auto& batch : batches)
 		{
-			if (pmxNode->IsDeformAfterPhysics() != afterPhysicsAnim)
-			{
-				continue;
-			}
-
-			if (pmxNode->GetAppendNode() != nullptr)
-			{
-				pmxNode->UpdateAppendTransform();
-				pmxNode->UpdateGlobalTransform();
-			}
-			if (pmxNode->GetIKSolver() != nullptr)
-			{
-				auto ikSolver = pmxNode->GetIKSolver();
-				ikSolver->Solve();
-				pmxNode->UpdateGlobalTransform();
-			}
+			ParallelNodeUpdate(
+				batch.m_nodes.size(),
+				[this, &batch](size_t begin, size_t end)
+				{
+					for (size_t i = begin; i < end; i++)
+					{
+						UpdateNodeTransform(batch.m_nodes[i]);
+					}
+				}
+			);
 		}
 
 		for (auto pmxNode : m_sortedNodes)
@@ -198,6 +418,50 @@ namespace saba
 		}
 	}
 
+	void PMXModel::UpdateNodeTransform(PMXNode * pmxNode)
+	{
+		if (pmxNode->GetAppendNode() != nullptr)
+		{
+			pmxNode->UpdateAppendTransform();
+			pmxNode->UpdateGlobalTransform();
+		}
+		if (pmxNode->GetIKSolver() != nullptr)
+		{
+			auto ikSolver = pmxNode->GetIKSolver();
+			ikSolver->Solve();
+			pmxNode->UpdateGlobalTransform();
+		}
+	}
+
+	void PMXModel::ParallelNodeUpdate(size_t count, const std::function<void(size_t, size_t)>& func)
+	{
+		size_t chunkCount = std::min(size_t(m_parallelUpdateCount), count);
+		if (!m_parallelNodeUpdate || chunkCount <= 1)
+		{
+			func(0, count);
+			return;
+		}
+
+		size_t chunkSize = (count + chunkCount - 1) / chunkCount;
+		m_nodeUpdateFutures.resize(chunkCount - 1);
+		for (size_t i = 1; i < chunkCount; i++)
+		{
+			size_t begin = std::min(chunkSize * i, count);
+			size_t end = std::min(begin + chunkSize, count);
+			m_nodeUpdateFutures[i - 1] = std::async(
+				std::launch::async,
+				[&func, begin, end]() { func(begin, end); }
+			);
+		}
+
+		func(0, std::min(chunkSize, count));
+
+		for (auto& future : m_nodeUpdateFutures)
+		{
+			future.wait();
+		}
+	}
+
 	void PMXModel::ResetPhysics()
 	{
 		MMDPhysicsManager* physicsMan = GetPhysicsManager();
@@ -254,7 +518,7 @@ namespace saba
 		auto rigidbodys = physicsMan->GetRigidBodys();
 		for (auto& rb : (*rigidbodys))
 		{
-			rb->SetActivation(true);
+			rb->UpdateActivation(physics);
 		}
 
 		physics->Update(elapsed);
@@ -327,14 +591,56 @@ namespace saba
 	{
 		Destroy();
 
+		// キャッシュがあれば PMX の解析、文字列変換、頂点/マテリアルの変換を省略する
+		MMDModelCacheKey cacheKey;
+		bool useCache = IsModelCacheEnabled() && MakeModelCacheKey(filepath, mmdDataDir, &cacheKey);
+		std::string cachePath = useCache ? GetModelCachePath(filepath, cacheKey) : std::string();
 		PMXFile pmx;
-		if (!ReadPMXFile(&pmx, filepath.c_str()))
+		bool cacheLoaded = false;
+		if (useCache)
+		{
+			MMDModelCacheReader cache;
+			if (cache.Open(cachePath, PMXModelCacheVersion, cacheKey))
+			{
+				cacheLoaded = ReadCache(&cache, &pmx);
+				if (!cacheLoaded)
+				{
+					SABA_WARN("Broken Model Cache: [{}]", cachePath);
+					Destroy();
+					pmx = PMXFile();
+				}
+			}
+		}
+
+		if (!cacheLoaded)
+		{
+			if (!ReadPMXFile(&pmx, filepath.c_str()))
+			{
+				return false;
+			}
+			if (!SetupMesh(pmx, PathUtil::GetDirectoryName(filepath), mmdDataDir))
+			{
+				return false;
+			}
+		}
+
+		if (!Setup(pmx))
 		{
 			return false;
 		}
 
-		std::string dirPath = PathUtil::GetDirectoryName(filepath);
+		if (useCache && !cacheLoaded)
+		{
+			MMDModelCacheWriter cache;
+			WriteCache(&cache, pmx);
+			cache.Save(cachePath, PMXModelCacheVersion, cacheKey); // 失敗時の警告は Save が出す
+		}
 
+		return true;
+	}
+
+	bool PMXModel::SetupMesh(const PMXFile& pmx, const std::string& dirPath, const std::string& mmdDataDir)
+	{
 		size_t vertexCount = pmx.m_vertices.size();
 		m_positions.reserve(vertexCount);
 		m_normals.reserve(vertexCount);
@@ -409,12 +715,6 @@ namespace saba
 			m_bboxMax = glm::max(m_bboxMax, pos);
 			m_bboxMin = glm::min(m_bboxMin, pos);
 		}
-		m_morphPositions.resize(m_positions.size());
-		m_morphUVs.resize(m_positions.size());
-		m_updatePositions.resize(m_positions.size());
-		m_updateNormals.resize(m_normals.size());
-		m_updateUVs.resize(m_uvs.size());
-
 
 		m_indexElementSize = pmx.m_header.m_vertexIndexSize;
 		m_indices.resize(pmx.m_faces.size() * 3 * m_indexElementSize);
@@ -553,9 +853,25 @@ namespace saba
 
 			beginIndex = beginIndex + pmxMat.m_numFaceVertices;
 		}
+
+		return true;
+	}
+
+	bool PMXModel::Setup(const PMXFile& pmx)
+	{
+		m_morphPositions = m_positions;
+		m_morphTouchFlags.resize(m_positions.size(), 0);
+		m_updatePositions.resize(m_positions.size());
+		m_updateNormals.resize(m_normals.size());
+		m_updateUVs = m_uvs;
+
 		m_initMaterials = m_materials;
 		m_mulMaterialFactors.resize(m_materials.size());
 		m_addMaterialFactors.resize(m_materials.size());
+		m_materialTouchFlags.resize(m_materials.size(), 0);
+		m_materialTouchIndices.reserve(m_materials.size());
+		m_prevMaterialTouchIndices.reserve(m_materials.size());
+		m_materialsDirty = true;
 
 		// Node
 		m_nodeMan.GetNodes()->reserve(pmx.m_bones.size());
@@ -608,6 +924,7 @@ namespace saba
 			}
 			node->SaveInitialTRS();
 		}
+		SetupNodeHierarchy();
 		m_transforms.resize(m_nodeMan.GetNodeCount());
 
 		m_sortedNodes.clear();
@@ -664,6 +981,8 @@ namespace saba
 			}
 		}
 
+		SetupNodeUpdateBatches();
+
 		// Morph
 		for (const auto& pmxMorph : pmx.m_morphs)
 		{
@@ -746,6 +1065,10 @@ namespace saba
 			}
 		}
 
+		SetupGroupMorphs();
+		m_positionMorphWeights.resize(m_positionMorphDatas.size(), 0.0f);
+		m_uvMorphWeights.resize(m_uvMorphDatas.size(), 0.0f);
+
 		// Physics
 		if (!m_physicsMan.Create())
 		{
@@ -803,18 +1126,87 @@ namespace saba
 		return true;
 	}
 
+	void PMXModel::WriteCache(MMDModelCacheWriter* cache, const PMXFile& pmx) const
+	{
+		// 変換済みの頂点、インデックス、マテリアル
+		cache->WriteArray(m_positions);
+		cache->WriteArray(m_normals);
+		cache->WriteArray(m_uvs);
+		cache->WriteArray(m_vertexBoneInfos);
+		cache->Write(m_bboxMin);
+		cache->Write(m_bboxMax);
+		cache->Write(uint64_t(m_indexElementSize));
+		cache->Write(uint64_t(m_indexCount));
+		cache->WriteArray(m_indices);
+		WriteModelCacheMaterials(cache, m_materials);
+		cache->WriteArray(m_subMeshes);
+
+		// Node、Morph、Physics の生成に使う情報 (文字列は UTF-8 に変換済み)
+		WriteBones(cache, pmx.m_bones);
+		WriteMorphs(cache, pmx.m_morphs);
+		WriteRigidbodies(cache, pmx.m_rigidbodies);
+		WriteJoints(cache, pmx.m_joints);
+	}
+
+	bool PMXModel::ReadCache(MMDModelCacheReader* cache, PMXFile* pmx)
+	{
+		uint64_t indexElementSize = 0;
+		uint64_t indexCount = 0;
+		cache->ReadArray(&m_positions);
+		cache->ReadArray(&m_normals);
+		cache->ReadArray(&m_uvs);
+		cache->ReadArray(&m_vertexBoneInfos);
+		cache->Read(&m_bboxMin);
+		cache->Read(&m_bboxMax);
+		cache->Read(&indexElementSize);
+		cache->Read(&indexCount);
+		cache->ReadArray(&m_indices);
+		ReadModelCacheMaterials(cache, &m_materials);
+		cache->ReadArray(&m_subMeshes);
+
+		ReadBones(cache, &pmx->m_bones);
+		ReadMorphs(cache, &pmx->m_morphs);
+		ReadRigidbodies(cache, &pmx->m_rigidbodies);
+		ReadJoints(cache, &pmx->m_joints);
+		if (cache->IsBad() || !cache->IsEOF())
+		{
+			return false;
+		}
+
+		size_t vertexCount = m_positions.size();
+		if (m_normals.size() != vertexCount ||
+			m_uvs.size() != vertexCount ||
+			m_vertexBoneInfos.size() != vertexCount ||
+			m_indices.size() != indexCount * indexElementSize ||
+			m_subMeshes.size() != m_materials.size())
+		{
+			return false;
+		}
+		m_indexElementSize = size_t(indexElementSize);
+		m_indexCount = size_t(indexCount);
+		return true;
+	}
+
 	void PMXModel::Destroy()
 	{
 		m_materials.clear();
 		m_subMeshes.clear();
+		m_materialTouchFlags.clear();
+		m_materialTouchIndices.clear();
+		m_prevMaterialTouchIndices.clear();
 
 		m_positions.clear();
 		m_normals.clear();
 		m_uvs.clear();
 		m_vertexBoneInfos.clear();
+		m_morphPositions.clear();
+		m_morphTouchFlags.clear();
 
 		m_indices.clear();
 
+		m_nodeUpdateBatches.clear();
+		m_afterPhysicsNodeUpdateBatches.clear();
+		ClearNodeHierarchy();
 		m_nodeMan.GetNodes()->clear();
 
 		m_updateRanges.clear();
@@ -835,6 +1227,10 @@ namespace saba
 
 		SABA_INFO("Select PMX Parallel Update Count : {}", m_parallelUpdateCount);
 
+		for (auto& range : m_updateRanges)
+		{
+			ResetMorphVertices(range);
+		}
 		m_updateRanges.resize(m_parallelUpdateCount);
 		m_parallelUpdateFutures.resize(m_parallelUpdateCount - 1);
 
@@ -874,20 +1270,191 @@ namespace saba
 				offset = range.m_vertexOffset + range.m_vertexCount;
 			}
 		}
+
+		SetupMorphRanges();
+	}
+
+	void PMXModel::SetupNodeUpdateBatches()
+	{
+		SetupNodeUpdateBatches(false, &m_nodeUpdateBatches);
+		SetupNodeUpdateBatches(true, &m_afterPhysicsNodeUpdateBatches);
+	}
+
+	void PMXModel::SetupNodeUpdateBatches(bool afterPhysicsAnim, std::vector<NodeUpdateBatch>* batches)
+	{
+		batches->clear();
+
+		// 付与/IK が書き換える範囲 (MMDNodeHierarchy の部分木) と読み込むノード
+		struct NodeDependency
+		{
+			std::vector<std::pair<size_t, size_t>>	m_writeRanges;
+			std::vector<size_t>						m_reads;
+		};
+		auto addWriteRange = [](NodeDependency* dep, const MMDNode* node)
+		{
+			size_t begin = node->GetHierarchyIndex();
+			dep->m_writeRanges.emplace_back(begin, begin + node->GetSubtreeSize());
+		};
+		auto isWrite = [](const NodeDependency& dep, size_t idx)
+		{
+			for (const auto& range : dep.m_writeRanges)
+			{
+				if (idx >= range.first && idx < range.second)
+				{
+					return true;
+				}
+			}
+			return false;
+		};
+		auto isConflict = [&isWrite](const NodeDependency& a, const NodeDependency& b)
+		{
+			for (const auto& range : a.m_writeRanges)
+			{
+				for (const auto& otherRange : b.m_writeRanges)
+				{
+					if (range.first < otherRange.second && otherRange.first < range.second)
+					{
+						return true;
+					}
+				}
+			}
+			for (auto idx : a.m_reads)
+			{
+				if (isWrite(b, idx))
+				{
+					return true;
+				}
+			}
+			for (auto idx : b.m_reads)
+			{
+				if (isWrite(a, idx))
+				{
+					return true;
+				}
+			}
+			return false;
+		};
+
+		// 階層が作れなかった場合は依存関係がわからないので全て順番に更新する
+		bool hierarchyBound = true;
+		for (auto pmxNode : m_sortedNodes)
+		{
+			hierarchyBound = hierarchyBound && pmxNode->IsHierarchyBound();
+		}
+
+		std::vector<NodeDependency> batchDeps;
+		int32_t batchDepth = 0;
+		for (auto pmxNode : m_sortedNodes)
+		{
+			if (pmxNode->IsDeformAfterPhysics() != afterPhysicsAnim)
+			{
+				continue;
+			}
+			if (pmxNode->GetAppendNode() == nullptr && pmxNode->GetIKSolver() == nullptr)
+			{
+				continue;
+			}
+
+			NodeDependency dep;
+			addWriteRange(&dep, pmxNode);
+			if (pmxNode->GetAppendNode() != nullptr)
+			{
+				dep.m_reads.push_back(pmxNode->GetAppendNode()->GetHierarchyIndex());
+			}
+			if (pmxNode->GetIKSolver() != nullptr)
+			{
+				auto ikSolver = pmxNode->GetIKSolver();
+				for (size_t i = 0; i < ikSolver->GetIKChainCount(); i++)
+				{
+					addWriteRange(&dep, ikSolver->GetIKChainNode(i));
+				}
+				if (ikSolver->GetTargetNode() != nullptr)
+				{
+					dep.m_reads.push_back(ikSolver->GetTargetNode()->GetHierarchyIndex());
+				}
+			}
+
+			// 変形階層が変わるか、現在のバッチと依存する場合は新しいバッチにする
+			bool newBatch = batches->empty() || !hierarchyBound ||
+				pmxNode->GetDeformdepth() != batchDepth;
+			for (size_t i = 0; i < batchDeps.size() && !newBatch; i++)
+			{
+				newBatch = isConflict(batchDeps[i], dep);
+			}
+			if (newBatch)
+			{
+				batches->emplace_back();
+				batchDeps.clear();
+				batchDepth = pmxNode->GetDeformdepth();
+			}
+			batches->back().m_nodes.push_back(pmxNode);
+			batchDeps.emplace_back(std::move(dep));
+		}
+	}
+
+	void PMXModel::SetupMorphRanges()
+	{
+		for (auto& range : m_updateRanges)
+		{
+			range.m_positionMorphDatas.clear();
+			range.m_positionMorphDatas.resize(m_positionMorphDatas.size());
+			range.m_uvMorphDatas.clear();
+			range.m_uvMorphDatas.resize(m_uvMorphDatas.size());
+			range.m_morphTouchIndices.clear();
+		}
+
+		auto findRange = [this](uint32_t vtxIdx) -> UpdateRange*
+		{
+			for (auto& range : m_updateRanges)
+			{
+				if (vtxIdx >= range.m_vertexOffset &&
+					vtxIdx < range.m_vertexOffset + range.m_vertexCount)
+				{
+					return &range;
+				}
+			}
+			return nullptr;
+		};
+
+		for (size_t dataIdx = 0; dataIdx < m_positionMorphDatas.size(); dataIdx++)
+		{
+			for (const auto& morphVtx : m_positionMorphDatas[dataIdx].m_morphVertices)
+			{
+				auto range = findRange(morphVtx.m_index);
+				if (range != nullptr)
+				{
+					range->m_positionMorphDatas[dataIdx].m_morphVertices.push_back(morphVtx);
+				}
+			}
+		}
+
+		for (size_t dataIdx = 0; dataIdx < m_uvMorphDatas.size(); dataIdx++)
+		{
+			for (const auto& morphUV : m_uvMorphDatas[dataIdx].m_morphUVs)
+			{
+				auto range = findRange(morphUV.m_index);
+				if (range != nullptr)
+				{
+					range->m_uvMorphDatas[dataIdx].m_morphUVs.push_back(morphUV);
+				}
+			}
+		}
 	}
 
-	void PMXModel::Update(const UpdateRange & range)
+	void PMXModel::Update(UpdateRange & range)
 	{
-		const auto* position = m_positions.data() + range.m_vertexOffset;
+		// この範囲の頂点に Position/UV Morph を適用してからスキニングする
+		// UV Morph は m_updateUVs に直接反映する
+		ResetMorphVertices(range);
+		MorphPosition(range);
+		MorphUV(range);
+
+		const auto* position = m_morphPositions.data() + range.m_vertexOffset;
 		const auto* normal = m_normals.data() + range.m_vertexOffset;
-		const auto* uv = m_uvs.data() + range.m_vertexOffset;
-		const auto* morphPos = m_morphPositions.data() + range.m_vertexOffset;
-		const auto* morphUV = m_morphUVs.data() + range.m_vertexOffset;
 		const auto* vtxInfo = m_vertexBoneInfos.data() + range.m_vertexOffset;
 		const auto* transforms = m_transforms.data();
 		auto* updatePosition = m_updatePositions.data() + range.m_vertexOffset;
 		auto* updateNormal = m_updateNormals.data() + range.m_vertexOffset;
-		auto* updateUV = m_updateUVs.data() + range.m_vertexOffset;
 
 		for (size_t i = 0; i < range.m_vertexCount; i++)
 		{
@@ -959,19 +1526,14 @@ namespace saba
 				break;
 			}
 
-			*updatePosition = glm::vec3(m * glm::vec4(*position + *morphPos, 1));
+			*updatePosition = glm::vec3(m * glm::vec4(*position, 1));
 			*updateNormal = glm::normalize(glm::mat3(m) * *normal);
-			*updateUV = *uv + glm::vec2((*morphUV).x, (*morphUV).y);
 
 			vtxInfo++;
 			position++;
 			normal++;
-			uv++;
 			updatePosition++;
 			updateNormal++;
-			updateUV++;
-			morphPos++;
-			morphUV++;
 		}
 	}
 
@@ -980,16 +1542,11 @@ namespace saba
 		switch (morph->m_morphType)
 		{
 		case MorphType::Position:
-			MorphPosition(
-				m_positionMorphDatas[morph->m_dataIndex],
-				weight
-			);
+			// 頂点への適用は Update の各範囲で行う
+			m_positionMorphWeights[morph->m_dataIndex] += weight;
 			break;
 		case MorphType::UV:
-			MorphUV(
-				m_uvMorphDatas[morph->m_dataIndex],
-				weight
-			);
+			m_uvMorphWeights[morph->m_dataIndex] += weight;
 			break;
 		case MorphType::Material:
 			MorphMaterial(
@@ -1006,10 +1563,10 @@ namespace saba
 		case MorphType::Group:
 		{
 			auto& groupMorphData = m_groupMorphDatas[morph->m_dataIndex];
-			for (const auto& groupMorph : groupMorphData.m_groupMorphs)
+			for (const auto& flatMorph : groupMorphData.m_flatMorphs)
 			{
-				auto& elemMorph = (*m_morphMan.GetMorphs())[groupMorph.m_morphIndex];
-				Morph(elemMorph.get(), groupMorph.m_weight * weight);
+				auto& elemMorph = (*m_morphMan.GetMorphs())[flatMorph.m_morphIndex];
+				Morph(elemMorph.get(), flatMorph.m_weight * weight);
 			}
 			break;
 		}
@@ -1018,92 +1575,221 @@ namespace saba
 		}
 	}
 
-	void PMXModel::MorphPosition(const PositionMorphData & morphData, float weight)
+	void PMXModel::SetupGroupMorphs()
 	{
-		if (weight == 0)
+		const auto& morphs = (*m_morphMan.GetMorphs());
+		m_morphWeights.resize(morphs.size());
+
+		std::vector<uint8_t> visiting(morphs.size(), 0);
+		for (size_t i = 0; i < morphs.size(); i++)
+		{
+			const auto& morph = morphs[i];
+			if (morph->m_morphType != MorphType::Group)
+			{
+				continue;
+			}
+			auto& groupMorphData = m_groupMorphDatas[morph->m_dataIndex];
+			groupMorphData.m_flatMorphs.clear();
+			FlattenGroupMorph(i, 1.0f, &visiting, &groupMorphData.m_flatMorphs);
+		}
+	}
+
+	void PMXModel::FlattenGroupMorph(
+		size_t morphIdx,
+		float weight,
+		std::vector<uint8_t>* visiting,
+		std::vector<saba::PMXMorph::GroupMorph>* flatMorphs
+	)
+	{
+		const auto& morphs = (*m_morphMan.GetMorphs());
+		const auto& morph = morphs[morphIdx];
+		if (morph->m_morphType == MorphType::None)
 		{
 			return;
 		}
+		if (morph->m_morphType != MorphType::Group)
+		{
+			auto findIt = std::find_if(
+				flatMorphs->begin(),
+				flatMorphs->end(),
+				[morphIdx](const saba::PMXMorph::GroupMorph& x) { return x.m_morphIndex == (int32_t)morphIdx; }
+			);
+			if (findIt != flatMorphs->end())
+			{
+				findIt->m_weight += weight;
+			}
+			else
+			{
+				saba::PMXMorph::GroupMorph flatMorph;
+				flatMorph.m_morphIndex = (int32_t)morphIdx;
+				flatMorph.m_weight = weight;
+				flatMorphs->push_back(flatMorph);
+			}
+			return;
+		}
+
+		if ((*visiting)[morphIdx] != 0)
+		{
+			SABA_WARN("Group Morph Cycle Detected: [{}]", morph->GetName());
+			return;
+		}
+		(*visiting)[morphIdx] = 1;
+		const auto& groupMorphData = m_groupMorphDatas[morph->m_dataIndex];
+		for (const auto& groupMorph : groupMorphData.m_groupMorphs)
+		{
+			if (groupMorph.m_morphIndex < 0 || (size_t)groupMorph.m_morphIndex >= morphs.size())
+			{
+				SABA_WARN("Illegal Group Morph Index({}): [{}]", groupMorph.m_morphIndex, morph->GetName());
+				continue;
+			}
+			FlattenGroupMorph(groupMorph.m_morphIndex, weight * groupMorph.m_weight, visiting, flatMorphs);
+		}
+		(*visiting)[morphIdx] = 0;
+	}
 
-		for (const auto& morphVtx : morphData.m_morphVertices)
+	void PMXModel::ResetMorphVertices(UpdateRange & range)
+	{
+		for (auto vtxIdx : range.m_morphTouchIndices)
 		{
-			m_morphPositions[morphVtx.m_index] += morphVtx.m_position * weight;
+			m_morphPositions[vtxIdx] = m_positions[vtxIdx];
+			m_updateUVs[vtxIdx] = m_uvs[vtxIdx];
+			m_morphTouchFlags[vtxIdx] = 0;
 		}
+		range.m_morphTouchIndices.clear();
 	}
 
-	void PMXModel::MorphUV(const UVMorphData & morphData, float weight)
+	void PMXModel::TouchMorphVertex(UpdateRange & range, uint32_t vtxIdx)
 	{
-		if (weight == 0)
+		if (m_morphTouchFlags[vtxIdx] == 0)
 		{
-			return;
+			m_morphTouchFlags[vtxIdx] = 1;
+			range.m_morphTouchIndices.push_back(vtxIdx);
 		}
+	}
 
-		for (const auto& morphUV : morphData.m_morphUVs)
+	void PMXModel::MorphPosition(UpdateRange & range)
+	{
+		for (size_t dataIdx = 0; dataIdx < range.m_positionMorphDatas.size(); dataIdx++)
 		{
-			m_morphUVs[morphUV.m_index] += morphUV.m_uv * weight;
+			float weight = m_positionMorphWeights[dataIdx];
+			if (weight == 0)
+			{
+				continue;
+			}
+
+			for (const auto& morphVtx : range.m_positionMorphDatas[dataIdx].m_morphVertices)
+			{
+				TouchMorphVertex(range, morphVtx.m_index);
+				m_morphPositions[morphVtx.m_index] += morphVtx.m_position * weight;
+			}
+		}
+	}
+
+	void PMXModel::MorphUV(UpdateRange & range)
+	{
+		for (size_t dataIdx = 0; dataIdx < range.m_uvMorphDatas.size(); dataIdx++)
+		{
+			float weight = m_uvMorphWeights[dataIdx];
+			if (weight == 0)
+			{
+				continue;
+			}
+
+			for (const auto& morphUV : range.m_uvMorphDatas[dataIdx].m_morphUVs)
+			{
+				TouchMorphVertex(range, morphUV.m_index);
+				m_updateUVs[morphUV.m_index] += glm::vec2(morphUV.m_uv) * weight;
+			}
 		}
 	}
 
 	void PMXModel::BeginMorphMaterial()
 	{
-		MaterialFactor initMul;
-		initMul.m_diffuse = glm::vec3(1);
-		initMul.m_alpha = 1;
-		initMul.m_specular = glm::vec3(1);
-		initMul.m_specularPower = 1;
-		initMul.m_ambient = glm::vec3(1);
-		initMul.m_edgeColor = glm::vec4(1);
-		initMul.m_edgeSize = 1;
-		initMul.m_textureFactor = glm::vec4(1);
-		initMul.m_spTextureFactor = glm::vec4(1);
-		initMul.m_toonTextureFactor = glm::vec4(1);
-
-		MaterialFactor initAdd;
-		initAdd.m_diffuse = glm::vec3(0);
-		initAdd.m_alpha = 0;
-		initAdd.m_specular = glm::vec3(0);
-		initAdd.m_specularPower = 0;
-		initAdd.m_ambient = glm::vec3(0);
-		initAdd.m_edgeColor = glm::vec4(0);
-		initAdd.m_edgeSize = 0;
-		initAdd.m_textureFactor = glm::vec4(0);
-		initAdd.m_spTextureFactor = glm::vec4(0);
-		initAdd.m_toonTextureFactor = glm::vec4(0);
-
-		size_t matCount = m_materials.size();
-		for (size_t matIdx = 0; matIdx < matCount; matIdx++)
-		{
-			m_mulMaterialFactors[matIdx] = initMul;
-			m_mulMaterialFactors[matIdx].m_diffuse = m_initMaterials[matIdx].m_diffuse;
-			m_mulMaterialFactors[matIdx].m_alpha = m_initMaterials[matIdx].m_alpha;
-			m_mulMaterialFactors[matIdx].m_specular = m_initMaterials[matIdx].m_specular;
-			m_mulMaterialFactors[matIdx].m_specularPower = m_initMaterials[matIdx].m_specularPower;
-			m_mulMaterialFactors[matIdx].m_ambient = m_initMaterials[matIdx].m_ambient;
-
-			m_addMaterialFactors[matIdx] = initAdd;
+		// 前回触れたマテリアルは EndMorphMaterial で元に戻すか再計算する
+		for (auto matIdx : m_materialTouchIndices)
+		{
+			m_materialTouchFlags[matIdx] = 0;
 		}
+		std::swap(m_materialTouchIndices, m_prevMaterialTouchIndices);
+		m_materialTouchIndices.clear();
 	}
 
 	void PMXModel::EndMorphMaterial()
 	{
-		size_t matCount = m_materials.size();
-		for (size_t matIdx = 0; matIdx < matCount; matIdx++)
-		{
-			MaterialFactor matFactor = m_mulMaterialFactors[matIdx];
-			matFactor.Add(m_addMaterialFactors[matIdx], 1.0f);
-
-			m_materials[matIdx].m_diffuse = matFactor.m_diffuse;
-			m_materials[matIdx].m_alpha = matFactor.m_alpha;
-			m_materials[matIdx].m_specular = matFactor.m_specular;
-			m_materials[matIdx].m_specularPower = matFactor.m_specularPower;
-			m_materials[matIdx].m_ambient = matFactor.m_ambient;
-			m_materials[matIdx].m_textureMulFactor = m_mulMaterialFactors[matIdx].m_textureFactor;
-			m_materials[matIdx].m_textureAddFactor = m_addMaterialFactors[matIdx].m_textureFactor;
-			m_materials[matIdx].m_spTextureMulFactor = m_mulMaterialFactors[matIdx].m_spTextureFactor;
-			m_materials[matIdx].m_spTextureAddFactor = m_addMaterialFactors[matIdx].m_spTextureFactor;
-			m_materials[matIdx].m_toonTextureMulFactor = m_mulMaterialFactors[matIdx].m_toonTextureFactor;
-			m_materials[matIdx].m_toonTextureAddFactor = m_addMaterialFactors[matIdx].m_toonTextureFactor;
+		for (auto matIdx : m_materialTouchIndices)
+		{
+			ApplyMaterialFactor(matIdx);
+			m_materialsDirty = true;
 		}
+
+		// 今回 Morph が無かったマテリアルを元に戻す
+		for (auto matIdx : m_prevMaterialTouchIndices)
+		{
+			if (m_materialTouchFlags[matIdx] == 0)
+			{
+				ResetMaterialFactor(matIdx);
+				ApplyMaterialFactor(matIdx);
+				m_materialsDirty = true;
+			}
+		}
+		m_prevMaterialTouchIndices.clear();
+	}
+
+	void PMXModel::TouchMaterial(size_t matIdx)
+	{
+		if (m_materialTouchFlags[matIdx] == 0)
+		{
+			m_materialTouchFlags[matIdx] = 1;
+			m_materialTouchIndices.push_back(matIdx);
+			ResetMaterialFactor(matIdx);
+		}
+	}
+
+	void PMXModel::ResetMaterialFactor(size_t matIdx)
+	{
+		const auto& initMat = m_initMaterials[matIdx];
+
+		auto& mul = m_mulMaterialFactors[matIdx];
+		mul.m_diffuse = initMat.m_diffuse;
+		mul.m_alpha = initMat.m_alpha;
+		mul.m_specular = initMat.m_specular;
+		mul.m_specularPower = initMat.m_specularPower;
+		mul.m_ambient = initMat.m_ambient;
+		mul.m_edgeColor = glm::vec4(1);
+		mul.m_edgeSize = 1;
+		mul.m_textureFactor = glm::vec4(1);
+		mul.m_spTextureFactor = glm::vec4(1);
+		mul.m_toonTextureFactor = glm::vec4(1);
+
+		auto& add = m_addMaterialFactors[matIdx];
+		add.m_diffuse = glm::vec3(0);
+		add.m_alpha = 0;
+		add.m_specular = glm::vec3(0);
+		add.m_specularPower = 0;
+		add.m_ambient = glm::vec3(0);
+		add.m_edgeColor = glm::vec4(0);
+		add.m_edgeSize = 0;
+		add.m_textureFactor = glm::vec4(0);
+		add.m_spTextureFactor = glm::vec4(0);
+		add.m_toonTextureFactor = glm::vec4(0);
+	}
+
+	void PMXModel::ApplyMaterialFactor(size_t matIdx)
+	{
+		MaterialFactor matFactor = m_mulMaterialFactors[matIdx];
+		matFactor.Add(m_addMaterialFactors[matIdx], 1.0f);
+
+		m_materials[matIdx].m_diffuse = matFactor.m_diffuse;
+		m_materials[matIdx].m_alpha = matFactor.m_alpha;
+		m_materials[matIdx].m_specular = matFactor.m_specular;
+		m_materials[matIdx].m_specularPower = matFactor.m_specularPower;
+		m_materials[matIdx].m_ambient = matFactor.m_ambient;
+		m_materials[matIdx].m_textureMulFactor = m_mulMaterialFactors[matIdx].m_textureFactor;
+		m_materials[matIdx].m_textureAddFactor = m_addMaterialFactors[matIdx].m_textureFactor;
+		m_materials[matIdx].m_spTextureMulFactor = m_mulMaterialFactors[matIdx].m_spTextureFactor;
+		m_materials[matIdx].m_spTextureAddFactor = m_addMaterialFactors[matIdx].m_spTextureFactor;
+		m_materials[matIdx].m_toonTextureMulFactor = m_mulMaterialFactors[matIdx].m_toonTextureFactor;
+		m_materials[matIdx].m_toonTextureAddFactor = m_addMaterialFactors[matIdx].m_toonTextureFactor;
 	}
 
 	void PMXModel::MorphMaterial(const MaterialMorphData & morphData, float weight)
@@ -1113,7 +1799,7 @@ namespace saba
 			if (matMorph.m_materialIndex != -1)
 			{
 				auto mi = matMorph.m_materialIndex;
-				auto& mat = m_materials[mi];
+				TouchMaterial(mi);
 				switch (matMorph.m_opType)
 				{
 				case saba::PMXMorph::MaterialMorph::OpType::Mul:
@@ -1139,6 +1825,7 @@ namespace saba
 				case saba::PMXMorph::MaterialMorph::OpType::Mul:
 					for (size_t i = 0; i < m_materials.size(); i++)
 					{
+						TouchMaterial(i);
 						m_mulMaterialFactors[i].Mul(
 							MaterialFactor(matMorph),
 							weight
@@ -1148,6 +1835,7 @@ namespace saba
 				case saba::PMXMorph::MaterialMorph::OpType::Add:
 					for (size_t i = 0; i < m_materials.size(); i++)
 					{
+						TouchMaterial(i);
 						m_addMaterialFactors[i].Add(
 							MaterialFactor(matMorph),
 							weight
@@ -1279,7 +1967,7 @@ namespace saba
 
 		glm::vec3 s = GetScale();
 
-		m_local = glm::translate(glm::mat4(), t)
+		*m_local = glm::translate(glm::mat4(), t)
 			* glm::mat4_cast(r)
 			* glm::scale(glm::mat4(), s);
 	}
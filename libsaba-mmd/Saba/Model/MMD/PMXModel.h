@@ -18,9 +18,13 @@
 #include <string>
 #include <algorithm>
 #include <future>
+#include <functional>
 
 namespace saba
 {
+	class MMDModelCacheReader;
+	class MMDModelCacheWriter;
+
 	class PMXNode : public MMDNode
 	{
 	public:
@@ -90,6 +94,7 @@ namespace saba
 		const glm::vec3* GetUpdatePositions() const override { return m_updatePositions.data(); }
 		const glm::vec3* GetUpdateNormals() const override { return m_updateNormals.data(); }
 		const glm::vec2* GetUpdateUVs() const override { return m_updateUVs.data(); }
+		bool HasUVMorph() const override { return !m_uvMorphDatas.empty(); }
 
 		size_t GetIndexElementSize() const override { return m_indexElementSize; }
 		size_t GetIndexCount() const override { return m_indexCount; }
@@ -97,6 +102,8 @@ namespace saba
 
 		size_t GetMaterialCount() const override { return m_materials.size(); }
 		const MMDMaterial* GetMaterials() const override { return &m_materials[0]; }
+		bool MaterialsDirty() const override { return m_materialsDirty; }
+		void ClearMaterialsDirty() override { m_materialsDirty = false; }
 
 		size_t GetSubMeshCount() const override { return m_subMeshes.size(); }
 		const MMDSubMesh* GetSubMeshes() const override { return &m_subMeshes[0]; }
@@ -117,6 +124,9 @@ namespace saba
 		// 頂点データーを更新する
 		void Update() override;
 		void SetParallelUpdateHint(uint32_t parallelCount) override;
+		// 同じ変形階層の独立した付与/IKを並列に更新する
+		void EnableParallelNodeUpdate(bool enable) { m_parallelNodeUpdate = enable; }
+		bool IsParallelNodeUpdateEnabled() const { return m_parallelNodeUpdate; }
 
 		bool Load(const std::string& filepath, const std::string& mmdDataDir);
 		void Destroy();
@@ -202,6 +212,8 @@ namespace saba
 		struct GroupMorphData
 		{
 			std::vector<saba::PMXMorph::GroupMorph>		m_groupMorphs;
+			// ロード時に展開した末端の Morph と係数 (同じ Morph は1つにまとめる)
+			std::vector<saba::PMXMorph::GroupMorph>		m_flatMorphs;
 		};
 
 		enum class MorphType
@@ -221,24 +233,58 @@ namespace saba
 			size_t		m_dataIndex;
 		};
 
+		// 同時に更新しても依存しない付与/IKのノード
+		struct NodeUpdateBatch
+		{
+			std::vector<PMXNode*>	m_nodes;
+		};
+
 		struct UpdateRange
 		{
 			size_t	m_vertexOffset;
 			size_t	m_vertexCount;
+
+			// この範囲の頂点だけを持つ Morph (m_positionMorphDatas, m_uvMorphDatas と同じ並び)
+			std::vector<PositionMorphData>	m_positionMorphDatas;
+			std::vector<UVMorphData>		m_uvMorphDatas;
+			// 前回の Update で Morph を適用した頂点
+			std::vector<uint32_t>			m_morphTouchIndices;
 		};
 
 	private:
+		bool SetupMesh(const PMXFile& pmx, const std::string& dirPath, const std::string& mmdDataDir);
+		bool Setup(const PMXFile& pmx);
+		void WriteCache(MMDModelCacheWriter* cache, const PMXFile& pmx) const;
+		bool ReadCache(MMDModelCacheReader* cache, PMXFile* pmx);
+
 		void SetupParallelUpdate();
-		void Update(const UpdateRange& range);
+		void SetupNodeUpdateBatches();
+		void SetupNodeUpdateBatches(bool afterPhysicsAnim, std::vector<NodeUpdateBatch>* batches);
+		void UpdateNodeTransform(PMXNode* node);
+		void ParallelNodeUpdate(size_t count, const std::function<void(size_t, size_t)>& func);
+		void SetupMorphRanges();
+		void Update(UpdateRange& range);
+
+		void SetupGroupMorphs();
+		void FlattenGroupMorph(
+			size_t morphIdx,
+			float weight,
+			std::vector<uint8_t>* visiting,
+			std::vector<saba::PMXMorph::GroupMorph>* flatMorphs
+		);
 
 		void Morph(PMXMorph* morph, float weight);
 
-		void MorphPosition(const PositionMorphData& morphData, float weight);
-
-		void MorphUV(const UVMorphData& morphData, float weight);
+		void ResetMorphVertices(UpdateRange& range);
+		void TouchMorphVertex(UpdateRange& range, uint32_t vtxIdx);
+		void MorphPosition(UpdateRange& range);
+		void MorphUV(UpdateRange& range);
 
 		void BeginMorphMaterial();
 		void EndMorphMaterial();
+		void TouchMaterial(size_t matIdx);
+		void ResetMaterialFactor(size_t matIdx);
+		void ApplyMaterialFactor(size_t matIdx);
 		void MorphMaterial(const MaterialMorphData& morphData, float weight);
 
 		void MorphBone(const BoneMorphData& morphData, float weight);
@@ -262,15 +308,26 @@ namespace saba
 		std::vector<MaterialMorphData>	m_materialMorphDatas;
 		std::vector<BoneMorphData>		m_boneMorphDatas;
 		std::vector<GroupMorphData>		m_groupMorphDatas;
+		// Group Morph を展開した後の Morph ごとの重み
+		std::vector<float>				m_morphWeights;
 
-		// PositionMorph用
+		// PositionMorph用 (Morph 適用後の頂点位置)
+		// 前回 Morph が触れた頂点だけを元に戻す
 		std::vector<glm::vec3>	m_morphPositions;
-		std::vector<glm::vec4>	m_morphUVs;
+		std::vector<uint8_t>	m_morphTouchFlags;
+		// Position/UV Morph の重み (Update の各範囲で適用する)
+		std::vector<float>		m_positionMorphWeights;
+		std::vector<float>		m_uvMorphWeights;
 
 		// マテリアルMorph用
 		std::vector<MMDMaterial>	m_initMaterials;
 		std::vector<MaterialFactor>	m_mulMaterialFactors;
 		std::vector<MaterialFactor>	m_addMaterialFactors;
+		// Material Morph が触れたマテリアル (今回と前回)
+		std::vector<uint8_t>		m_materialTouchFlags;
+		std::vector<size_t>			m_materialTouchIndices;
+		std::vector<size_t>			m_prevMaterialTouchIndices;
+		bool						m_materialsDirty;
 
 		glm::vec3		m_bboxMin;
 		glm::vec3		m_bboxMax;
@@ -278,6 +335,10 @@ namespace saba
 		std::vector<MMDMaterial>	m_materials;
 		std::vector<MMDSubMesh>		m_subMeshes;
 		std::vector<PMXNode*>		m_sortedNodes;
+		std::vector<NodeUpdateBatch>	m_nodeUpdateBatches;
+		std::vector<NodeUpdateBatch>	m_afterPhysicsNodeUpdateBatches;
+		bool							m_parallelNodeUpdate;
+		std::vector<std::future<void>>	m_nodeUpdateFutures;
 
 		MMDNodeManagerT<PMXNode>	m_nodeMan;
 		MMDIKManagerT<MMDIkSolver>	m_ikSolverMan;
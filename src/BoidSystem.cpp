@@ -0,0 +1,206 @@
+// This file is part of dexvt-lite.
+// -- 3D Inverse Kinematics (Cyclic Coordinate Descent) with Constraints
+// Copyright (C) 2018 onlyuser <mailto:onlyuser@gmail.com>
+//
+// dexvt-lite is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// dexvt-lite is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with dexvt-lite.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <BoidSystem.h>
+#include <TransformObject.h>
+#include <Util.h>
+#include <glm/glm.hpp>
+#include <vector>
+#include <algorithm>
+
+#define MIN_BOID_COUNT_PER_TASK 256
+
+namespace vt {
+
+BoidSystem::BoidSystem(float neighbor_radius,
+                       float separation_radius,
+                       float max_speed)
+    : m_neighbor_radius(neighbor_radius),
+      m_separation_radius(separation_radius),
+      m_max_speed(max_speed),
+      m_separation_weight(1),
+      m_alignment_weight(1),
+      m_cohesion_weight(1),
+      m_target(glm::vec3(0)),
+      m_seek_weight(0)
+{
+}
+
+BoidSystem::~BoidSystem()
+{
+}
+
+void BoidSystem::add_boid(TransformObject* object, glm::vec3 velocity)
+{
+    if(!object) {
+        return;
+    }
+    m_objects.push_back(object);
+    m_positions.push_back(object->get_origin());
+    m_velocities.push_back(velocity);
+}
+
+void BoidSystem::clear()
+{
+    m_objects.clear();
+    m_positions.clear();
+    m_velocities.clear();
+    m_new_velocities.clear();
+}
+
+void BoidSystem::set_neighbor_radius(float neighbor_radius)
+{
+    if(neighbor_radius <= 0) {
+        return;
+    }
+    m_neighbor_radius = neighbor_radius;
+}
+
+// picks up origins changed outside the simulation
+void BoidSystem::read_objects()
+{
+    for(int i = 0; i < static_cast<int>(m_objects.size()); i++) {
+        m_positions[i] = m_objects[i]->get_origin();
+    }
+}
+
+void BoidSystem::update(float delta_time)
+{
+    int n = m_objects.size();
+    if(!n) {
+        return;
+    }
+    update_spatial_hash();
+    m_new_velocities.resize(n);
+    parallel_for(n, MIN_BOID_COUNT_PER_TASK, [this, delta_time](int start_index, int end_index) {
+        update_velocities(start_index, end_index, delta_time);
+    });
+    m_velocities.swap(m_new_velocities);
+    for(int i = 0; i < n; i++) {
+        m_positions[i] += m_velocities[i] * delta_time;
+    }
+}
+
+void BoidSystem::write_objects() const
+{
+    for(int i = 0; i < static_cast<int>(m_objects.size()); i++) {
+        TransformObject* object = m_objects[i];
+        object->set_origin(m_positions[i]);
+        if(glm::length(m_velocities[i]) > EPSILON) {
+            object->point_at_local(m_velocities[i]);
+        }
+    }
+}
+
+glm::ivec3 BoidSystem::get_cell(glm::vec3 pos) const
+{
+    return glm::ivec3(glm::floor(pos / m_neighbor_radius));
+}
+
+// http://www.beosil.com/download/CollisionDetectionHashing_VMV03.pdf
+int BoidSystem::get_bucket(glm::ivec3 cell) const
+{
+    unsigned int hash = (static_cast<unsigned int>(cell.x) * 73856093u) ^
+                        (static_cast<unsigned int>(cell.y) * 19349663u) ^
+                        (static_cast<unsigned int>(cell.z) * 83492791u);
+    return hash & (m_bucket_start.size() - 2); // bucket count is a power of two
+}
+
+// counting sort of boids into hash buckets
+void BoidSystem::update_spatial_hash()
+{
+    int n = m_objects.size();
+    int num_buckets = 1;
+    while(num_buckets < n * 2) {
+        num_buckets <<= 1;
+    }
+    m_bucket_start.assign(num_buckets + 1, 0);
+    m_boid_buckets.resize(n);
+    m_sorted_boids.resize(n);
+    for(int i = 0; i < n; i++) {
+        m_boid_buckets[i] = get_bucket(get_cell(m_positions[i]));
+        m_bucket_start[m_boid_buckets[i] + 1]++;
+    }
+    for(int j = 0; j < num_buckets; j++) {
+        m_bucket_start[j + 1] += m_bucket_start[j];
+    }
+    std::vector<int> bucket_fill(m_bucket_start.begin(), m_bucket_start.end() - 1);
+    for(int k = 0; k < n; k++) {
+        m_sorted_boids[bucket_fill[m_boid_buckets[k]]++] = k;
+    }
+}
+
+void BoidSystem::update_velocities(int start_index, int end_index, float delta_time)
+{
+    float neighbor_radius_squared   = m_neighbor_radius * m_neighbor_radius;
+    float separation_radius_squared = m_separation_radius * m_separation_radius;
+    for(int i = start_index; i < end_index; i++) {
+        glm::vec3  pos  = m_positions[i];
+        glm::ivec3 cell = get_cell(pos);
+        glm::vec3  separation(0);
+        glm::vec3  sum_velocity(0);
+        glm::vec3  sum_position(0);
+        int        num_neighbors = 0;
+        int        visited_buckets[27];
+        int        num_visited_buckets = 0;
+        for(int dx = -1; dx <= 1; dx++) {
+            for(int dy = -1; dy <= 1; dy++) {
+                for(int dz = -1; dz <= 1; dz++) {
+                    int bucket = get_bucket(cell + glm::ivec3(dx, dy, dz));
+
+                    // neighboring cells may collide into the same bucket
+                    if(std::find(visited_buckets, visited_buckets + num_visited_buckets, bucket) != visited_buckets + num_visited_buckets) {
+                        continue;
+                    }
+                    visited_buckets[num_visited_buckets++] = bucket;
+                    for(int p = m_bucket_start[bucket]; p < m_bucket_start[bucket + 1]; p++) {
+                        int j = m_sorted_boids[p];
+                        if(j == i) {
+                            continue;
+                        }
+                        glm::vec3 offset = pos - m_positions[j];
+                        float distance_squared = glm::dot(offset, offset);
+                        if(distance_squared > neighbor_radius_squared) {
+                            continue;
+                        }
+                        if(distance_squared < separation_radius_squared && distance_squared > EPSILON) {
+                            separation += offset / distance_squared;
+                        }
+                        sum_velocity += m_velocities[j];
+                        sum_position += m_positions[j];
+                        num_neighbors++;
+                    }
+                }
+            }
+        }
+        glm::vec3 velocity = m_velocities[i];
+        glm::vec3 accel    = separation * m_separation_weight;
+        if(num_neighbors) {
+            accel += (sum_velocity / static_cast<float>(num_neighbors) - velocity) * m_alignment_weight;
+            accel += (sum_position / static_cast<float>(num_neighbors) - pos) * m_cohesion_weight;
+        }
+        accel += (m_target - pos) * m_seek_weight;
+        velocity += accel * delta_time;
+        float speed = glm::length(velocity);
+        if(speed > m_max_speed) {
+            velocity *= m_max_speed / speed;
+        }
+        m_new_velocities[i] = velocity;
+    }
+}
+
+}
@@ -21,8 +21,14 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <vector>
 #include <string>
+#include <algorithm>
+#include <iostream>
 #include <stdint.h>
 #include <stdio.h>
+#include <string.h>
+
+#define CHUNK_HEADER_SIZE (sizeof(uint16_t) + sizeof(uint32_t))
+#define FACE_SIZE         (sizeof(uint16_t) * 4) // 3 indices + flags
 
 namespace vt {
 
@@ -32,14 +38,6 @@ class Mesh;
 
 Mesh* cast_mesh(MeshBase* mesh);
 
-static void read_string(FILE* stream, char* buf)
-{
-    int i = 0;
-    do {
-        buf[i] = fgetc(stream);
-    } while(buf[i++]);
-}
-
 bool File3ds::load3ds(std::string filename, int index, std::vector<Mesh*>* meshes)
 {
     std::vector<MeshBase*> meshes_iface;
@@ -52,53 +50,46 @@ bool File3ds::load3ds(std::string filename, int index, std::vector<Mesh*>* meshe
     return true;
 }
 
+// NOTE: whole file is read in one go and parsed with a cursor
 bool File3ds::load3ds_impl(std::string filename, int index, std::vector<MeshBase*>* meshes)
 {
     if(!meshes) {
         return false;
     }
     FILE* stream = fopen(filename.c_str(), "rb");
-    if(stream) {
-        glm::vec3 global_min, global_max;
-        bool init_global_bbox = false;
-        fseek(stream, 0, SEEK_END);
-        uint32_t size = ftell(stream);
-        rewind(stream);
-        uint32_t main_end = enter_chunk(stream, MAIN3DS, size);
-        uint32_t edit_end = enter_chunk(stream, EDIT3DS, main_end);
-        int count = 0;
-        while(ftell(stream) < edit_end) {
-            uint32_t object_end = enter_chunk(stream, EDIT_OBJECT, edit_end);
-            char buf[80];
-            read_string(stream, buf); // read object name
-            int object_type = read_short(stream);
-            fseek(stream, -sizeof(uint16_t), SEEK_CUR); // rewind
-            if(object_type == OBJ_TRIMESH) {
-                if(count != index && index != -1) {
-                    break;
-                }
-                uint32_t mesh_end = enter_chunk(stream, OBJ_TRIMESH, object_end);
-                if(mesh_end) {
-                    uint32_t mesh_base = ftell(stream);
-
-                    enter_chunk(stream, TRI_VERTEXL, mesh_end);
-                    int num_vertex = read_short(stream);
-                    fseek(stream, mesh_base, SEEK_SET);
-
-                    enter_chunk(stream, TRI_FACEL, mesh_end);
-                    int num_tri = read_short(stream);
-                    fseek(stream, mesh_base, SEEK_SET);
-
-                    MeshBase* mesh = alloc_mesh_base(buf, num_vertex, num_tri);
-
-                    enter_chunk(stream, TRI_VERTEXL, mesh_end);
-                    read_vertices(stream, mesh);
-                    fseek(stream, mesh_base, SEEK_SET);
-
-                    enter_chunk(stream, TRI_FACEL, mesh_end);
-                    read_faces(stream, mesh);
-                    fseek(stream, mesh_base, SEEK_SET);
-
+    if(!stream) {
+        return true;
+    }
+    fseek(stream, 0, SEEK_END);
+    uint32_t size = ftell(stream);
+    rewind(stream);
+    std::vector<uint8_t> file_data(size);
+    size_t bytes_read = size ? fread(&file_data[0], 1, size, stream) : 0;
+    fclose(stream);
+    if(bytes_read != size) {
+        return false;
+    }
+    const uint8_t* buf = size ? &file_data[0] : NULL;
+    glm::vec3 global_min, global_max;
+    bool init_global_bbox = false;
+    uint32_t pos      = 0;
+    uint32_t main_end = enter_chunk(buf, &pos, MAIN3DS, size);
+    uint32_t edit_end = main_end ? enter_chunk(buf, &pos, EDIT3DS, main_end) : 0;
+    int count = 0;
+    while(pos < edit_end) {
+        uint32_t object_end = enter_chunk(buf, &pos, EDIT_OBJECT, edit_end);
+        if(!object_end) {
+            break;
+        }
+        const char* name = reinterpret_cast<const char*>(&buf[pos]);
+        size_t name_length = strnlen(name, object_end - pos);
+        std::string object_name(name, name_length);
+        pos += name_length + 1;
+        if(pos + sizeof(uint16_t) <= object_end && read_short(&buf[pos]) == OBJ_TRIMESH) {
+            if(index == -1 || count == index) {
+                uint32_t mesh_end = enter_chunk(buf, &pos, OBJ_TRIMESH, object_end);
+                MeshBase* mesh = mesh_end ? read_trimesh(buf, pos, mesh_end, object_name) : NULL;
+                if(mesh) {
                     mesh->update_bbox();
                     glm::vec3 local_min, local_max;
                     mesh->get_min_max(&local_min, &local_max);
@@ -112,77 +103,113 @@ bool File3ds::load3ds_impl(std::string filename, int index, std::vector<MeshBase
                     }
                     meshes->push_back(mesh);
                 }
-                fseek(stream, mesh_end, SEEK_SET);
-                count++;
             }
-            fseek(stream, object_end, SEEK_SET);
-        }
-        fclose(stream);
-        glm::vec3 global_center = (global_min + global_max) * 0.5f;
-        for(std::vector<MeshBase*>::iterator p = meshes->begin(); p != meshes->end(); p++) {
-            (*p)->set_axis(global_center);
-            (*p)->update_normals_and_tangents();
-            (*p)->update_bbox();
+            count++;
         }
+        pos = object_end;
+    }
+    glm::vec3 global_center = (global_min + global_max) * 0.5f;
+    for(std::vector<MeshBase*>::iterator p = meshes->begin(); p != meshes->end(); p++) {
+        (*p)->set_axis(global_center);
+        (*p)->update_normals_and_tangents();
+        (*p)->update_bbox();
     }
     return true;
 }
 
-uint32_t File3ds::enter_chunk(FILE* stream, uint32_t chunk_id, uint32_t chunk_end)
+// finds chunk_id among sibling chunks in [pos, chunk_end), moves pos past its header and returns its end (0 if not found)
+uint32_t File3ds::enter_chunk(const uint8_t* buf, uint32_t* pos, uint32_t chunk_id, uint32_t chunk_end)
 {
-    uint32_t offset = 0;
-    while(ftell(stream) < chunk_end) {
-        uint32_t _chunk_id = read_short(stream);
-        uint32_t chunk_size = read_long(stream);
-        if(_chunk_id == chunk_id) {
-            offset = -(sizeof(uint16_t)+sizeof(uint32_t))+chunk_size;
+    while(*pos + CHUNK_HEADER_SIZE <= chunk_end) {
+        uint32_t _chunk_id  = read_short(&buf[*pos]);
+        uint32_t chunk_size = read_long(&buf[*pos + sizeof(uint16_t)]);
+        if(chunk_size < CHUNK_HEADER_SIZE || chunk_size > chunk_end - *pos) { // corrupt
             break;
-        } else {
-            fseek(stream, -(sizeof(uint16_t)+sizeof(uint32_t)), SEEK_CUR); // rewind
-            fseek(stream, chunk_size, SEEK_CUR); // skip this chunk
         }
+        if(_chunk_id == chunk_id) {
+            uint32_t end = *pos + chunk_size;
+            *pos += CHUNK_HEADER_SIZE;
+            return end;
+        }
+        *pos += chunk_size; // skip this chunk
     }
-    return ftell(stream)+offset;
+    return 0;
 }
 
-void File3ds::read_vertices(FILE* stream, MeshBase* mesh)
+// bulk-copies vertex, face and uv arrays straight into mesh storage
+MeshBase* File3ds::read_trimesh(const uint8_t* buf, uint32_t pos, uint32_t mesh_end, std::string name)
 {
-    float* vert_coord = new float[3];
-    fseek(stream, sizeof(uint16_t), SEEK_CUR); // skip list size
-    size_t num_vertex = mesh->get_num_vertex();
-    for(int i = 0; i < static_cast<int>(num_vertex); i++) {
-        fread(vert_coord, sizeof(float), 3, stream);
-        mesh->set_vert_coord(i, glm::vec3(vert_coord[0], vert_coord[2], vert_coord[1]));
+    uint32_t vertex_pos = 0;
+    uint32_t face_pos   = 0;
+    uint32_t uv_pos     = 0;
+    while(pos + CHUNK_HEADER_SIZE <= mesh_end) {
+        uint32_t chunk_id   = read_short(&buf[pos]);
+        uint32_t chunk_size = read_long(&buf[pos + sizeof(uint16_t)]);
+        if(chunk_size < CHUNK_HEADER_SIZE + sizeof(uint16_t) || chunk_size > mesh_end - pos) {
+            break;
+        }
+        switch(chunk_id) {
+            case TRI_VERTEXL:      vertex_pos = pos + CHUNK_HEADER_SIZE; break;
+            case TRI_FACEL:        face_pos   = pos + CHUNK_HEADER_SIZE; break;
+            case TRI_MAPPINGCOORS: uv_pos     = pos + CHUNK_HEADER_SIZE; break;
+            default:
+                break;
+        }
+        pos += chunk_size;
+    }
+    if(!vertex_pos || !face_pos) {
+        return NULL;
+    }
+    size_t num_vertex = read_short(&buf[vertex_pos]);
+    size_t num_tri    = read_short(&buf[face_pos]);
+    if(!num_vertex || !num_tri ||
+       vertex_pos + sizeof(uint16_t) + num_vertex * sizeof(glm::vec3) > mesh_end ||
+       face_pos   + sizeof(uint16_t) + num_tri    * FACE_SIZE         > mesh_end)
+    {
+        return NULL;
     }
-    delete[] vert_coord;
-}
 
-void File3ds::read_faces(FILE* stream, MeshBase* mesh)
-{
-    uint16_t* tri_indices = new uint16_t[3];
-    fseek(stream, sizeof(uint16_t), SEEK_CUR); // skip list size
-    size_t num_tri = mesh->get_num_tri();
-    for(int i = 0; i < static_cast<int>(num_tri); i++) {
-        fread(tri_indices, sizeof(uint16_t), 3, stream);
-        mesh->set_tri_indices(i, glm::ivec3(tri_indices[0], tri_indices[2], tri_indices[1]));
-        fseek(stream, sizeof(uint16_t), SEEK_CUR); // skip tri_indices info
+    // out of range indices would corrupt the vertex-to-triangle adjacency later on
+    std::vector<uint16_t> faces(num_tri * 4);
+    memcpy(&faces[0], &buf[face_pos + sizeof(uint16_t)], num_tri * FACE_SIZE);
+    std::vector<glm::ivec3> tri_indices(num_tri);
+    for(int j = 0; j < static_cast<int>(num_tri); j++) {
+        if(faces[j * 4 + 0] >= num_vertex || faces[j * 4 + 1] >= num_vertex || faces[j * 4 + 2] >= num_vertex) {
+            std::cout << "Error: face " << j << " of mesh \"" << name << "\" indexes past its " << num_vertex << " vertices" << std::endl;
+            return NULL;
+        }
+        tri_indices[j] = glm::ivec3(faces[j * 4 + 0], faces[j * 4 + 2], faces[j * 4 + 1]); // flip winding with axes
+    }
+    MeshBase* mesh = alloc_mesh_base(name, num_vertex, num_tri);
+
+    std::vector<glm::vec3> vert_coords(num_vertex);
+    memcpy(&vert_coords[0], &buf[vertex_pos + sizeof(uint16_t)], num_vertex * sizeof(glm::vec3));
+    for(int i = 0; i < static_cast<int>(num_vertex); i++) {
+        std::swap(vert_coords[i].y, vert_coords[i].z); // z-up to y-up
+    }
+    mesh->set_vert_coords(&vert_coords[0]);
+    mesh->set_tri_indices(&tri_indices[0]);
+
+    std::vector<glm::vec2> tex_coords(num_vertex, glm::vec2(0));
+    if(uv_pos &&
+       read_short(&buf[uv_pos]) == num_vertex &&
+       uv_pos + sizeof(uint16_t) + num_vertex * sizeof(glm::vec2) <= mesh_end)
+    {
+        memcpy(&tex_coords[0], &buf[uv_pos + sizeof(uint16_t)], num_vertex * sizeof(glm::vec2));
     }
-    delete[] tri_indices;
+    mesh->set_tex_coords(&tex_coords[0]);
+    return mesh;
 }
 
-uint16_t File3ds::read_short(FILE* stream)
+uint16_t File3ds::read_short(const uint8_t* buf)
 {
-    uint8_t lo_byte;
-    uint8_t hi_byte;
-    fread(&lo_byte, sizeof(uint8_t), 1, stream);
-    fread(&hi_byte, sizeof(uint8_t), 1, stream);
-    return MAKEWORD(lo_byte, hi_byte);
+    return MAKEWORD(buf[0], buf[1]);
 }
 
-uint32_t File3ds::read_long(FILE* stream)
+uint32_t File3ds::read_long(const uint8_t* buf)
 {
-    uint16_t lo_word = read_short(stream);
-    uint16_t hi_word = read_short(stream);
+    uint16_t lo_word = read_short(&buf[0]);
+    uint16_t hi_word = read_short(&buf[sizeof(uint16_t)]);
     return MAKELONG(lo_word, hi_word);
 }
 
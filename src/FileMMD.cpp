@@ -260,6 +260,9 @@ bool FileMMD::set_anim_time_impl(std::vector<MeshBase*>* meshes,
                                  glm::vec3*              global_min,
                                  glm::vec3*              global_max)
 {
+    if(!meshAnimContext || !meshAnimContext->m_mmdModel || !meshAnimContext->m_vmdAnim) {
+        return false; // nothing loaded (or not an mmd model)
+    }
     std::shared_ptr<saba::MMDModel> mmdModel = meshAnimContext->m_mmdModel;
     auto vmdAnim                             = std::move(meshAnimContext->m_vmdAnim);
     std::vector<size_t> &indices             = meshAnimContext->m_indices;
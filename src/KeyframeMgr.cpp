@@ -20,6 +20,7 @@
 #include <glm/glm.hpp>
 #include <map>
 #include <vector>
+#include <algorithm>
 #include <limits.h>
 
 namespace vt {
@@ -126,7 +127,7 @@ bool MotionTrack::interpolate_frame_value(int frame_number, glm::vec3* value, bo
         *value = (*(--p)).second->get_value();
         return true;
     }
-    if((*p).first == frame_number) {
+    if((*p).first == frame_number || p == m_keyframes.begin()) { // clamp frames before first keyframe
         *value = (*p).second->get_value();
         return true;
     }
@@ -150,6 +151,67 @@ bool MotionTrack::interpolate_frame_value(int frame_number, glm::vec3* value, bo
     return true;
 }
 
+// fills frames [start_frame_number, end_frame_number), visiting each segment once
+bool MotionTrack::export_frame_values(int start_frame_number, int end_frame_number, glm::vec3* frame_values, bool is_smooth) const
+{
+    if(!frame_values) {
+        return false;
+    }
+    keyframes_t::const_iterator p = m_keyframes.begin();
+    while(p != m_keyframes.end() && !(*p).second) { // skip erased
+        p++;
+    }
+    if(p == m_keyframes.end()) {
+        return false;
+    }
+    int frame_number = start_frame_number;
+
+    // clamp frames before first keyframe
+    for(; frame_number < end_frame_number && frame_number < (*p).first; frame_number++) {
+        frame_values[frame_number - start_frame_number] = (*p).second->get_value();
+    }
+    keyframes_t::const_iterator q = p;
+    for(q++; q != m_keyframes.end() && frame_number < end_frame_number; q++) {
+        if(!(*q).second) { // skip erased
+            continue;
+        }
+        int segment_start_frame_number = (*p).first;
+        int segment_end_frame_number   = (*q).first;
+        int n = std::min(segment_end_frame_number, end_frame_number) - frame_number;
+        if(n > 0) {
+            float alpha_step  = 1.0f / static_cast<float>(segment_end_frame_number - segment_start_frame_number);
+            float start_alpha = static_cast<float>(frame_number - segment_start_frame_number) * alpha_step;
+            glm::vec3* segment_values = &frame_values[frame_number - start_frame_number];
+            if(is_smooth) {
+                // bezier interpolation
+                bezier_interpolate_n((*p).second->get_value(),
+                                     (*p).second->get_control_point2(),
+                                     (*q).second->get_control_point1(),
+                                     (*q).second->get_value(),
+                                     start_alpha,
+                                     alpha_step,
+                                     n,
+                                     segment_values);
+            } else {
+                // linear interpolation
+                glm::vec3 start_frame_value = (*p).second->get_value();
+                glm::vec3 delta             = (*q).second->get_value() - start_frame_value;
+                for(int i = 0; i < n; i++) {
+                    segment_values[i] = start_frame_value + delta * (start_alpha + alpha_step * i);
+                }
+            }
+            frame_number += n;
+        }
+        p = q;
+    }
+
+    // clamp frames after last keyframe
+    for(; frame_number < end_frame_number; frame_number++) {
+        frame_values[frame_number - start_frame_number] = (*p).second->get_value();
+    }
+    return true;
+}
+
 bool MotionTrack::get_frame_number_range(int* start_frame_number, int* end_frame_number) const
 {
     if(!start_frame_number && !end_frame_number) {
@@ -280,6 +342,26 @@ bool ObjectScript::interpolate_frame_value_for_motion_track(MotionTrack::motion_
     return motion_track->interpolate_frame_value(frame_number, value, is_smooth);
 }
 
+bool ObjectScript::export_frame_values_for_motion_track(MotionTrack::motion_type_t motion_type,
+                                                        int                        start_frame_number,
+                                                        int                        end_frame_number,
+                                                        glm::vec3*                 frame_values,
+                                                        bool                       is_smooth) const
+{
+    if(!frame_values) {
+        return false;
+    }
+    motion_tracks_t::const_iterator p = m_motion_tracks.find(motion_type);
+    if(p == m_motion_tracks.end()) {
+        return false;
+    }
+    MotionTrack* motion_track = (*p).second;
+    if(!motion_track) {
+        return false;
+    }
+    return motion_track->export_frame_values(start_frame_number, end_frame_number, frame_values, is_smooth);
+}
+
 bool ObjectScript::get_frame_number_range(int* start_frame_number, int* end_frame_number) const
 {
     if(!start_frame_number && !end_frame_number) {
@@ -322,6 +404,11 @@ void ObjectScript::update_control_points(float control_point_scale)
     }
 }
 
+KeyframeMgr::KeyframeMgr()
+    : m_is_compiled(false)
+{
+}
+
 KeyframeMgr::~KeyframeMgr()
 {
     clear();
@@ -339,6 +426,7 @@ bool KeyframeMgr::insert_keyframe(long object_id, MotionTrack::motion_type_t mot
         return false;
     }
     object_script->insert_keyframe(motion_type, frame_number, keyframe);
+    m_is_compiled = false;
     return true;
 }
 
@@ -352,6 +440,7 @@ bool KeyframeMgr::erase_keyframe(long object_id, unsigned char motion_types, int
     if(!object_script) {
         return false;
     }
+    m_is_compiled = false;
     if(frame_number == -1) {
         delete object_script;
         m_script.erase(p);
@@ -462,6 +551,7 @@ void KeyframeMgr::update_control_points(float control_point_scale)
         }
         object_script->update_control_points(control_point_scale);
     }
+    m_is_compiled = false;
 }
 
 bool KeyframeMgr::export_frame_values_for_object(long                    object_id,
@@ -478,22 +568,61 @@ bool KeyframeMgr::export_frame_values_for_object(long                    object_
     if(!get_frame_number_range(object_id, &start_frame_number, &end_frame_number)) {
         return false;
     }
-    for(int frame_number = start_frame_number; frame_number != end_frame_number; frame_number++) {
-        glm::vec3 origin;
-        glm::vec3 euler;
-        glm::vec3 scale;
-        if(!interpolate_frame_value_for_object(object_id, frame_number, &origin, &euler, &scale, is_smooth)) {
-            continue;
-        }
-        if(origin_frame_values) {
-            origin_frame_values->push_back(origin);
-        }
-        if(euler_frame_values) {
-            euler_frame_values->push_back(euler);
-        }
-        if(scale_frame_values) {
-            scale_frame_values->push_back(scale);
-        }
+    if(end_frame_number <= start_frame_number) {
+        return true;
+    }
+    size_t n = end_frame_number - start_frame_number;
+    glm::vec3* origin_values = NULL;
+    glm::vec3* euler_values  = NULL;
+    glm::vec3* scale_values  = NULL;
+    if(origin_frame_values) {
+        origin_frame_values->resize(origin_frame_values->size() + n, glm::vec3(0));
+        origin_values = &(*origin_frame_values)[origin_frame_values->size() - n];
+    }
+    if(euler_frame_values) {
+        euler_frame_values->resize(euler_frame_values->size() + n, glm::vec3(0));
+        euler_values = &(*euler_frame_values)[euler_frame_values->size() - n];
+    }
+    if(scale_frame_values) {
+        scale_frame_values->resize(scale_frame_values->size() + n, glm::vec3(0));
+        scale_values = &(*scale_frame_values)[scale_frame_values->size() - n];
+    }
+    return export_frame_values_for_object(object_id,
+                                          start_frame_number,
+                                          end_frame_number,
+                                          origin_values,
+                                          euler_values,
+                                          scale_values,
+                                          is_smooth);
+}
+
+bool KeyframeMgr::export_frame_values_for_object(long       object_id,
+                                                 int        start_frame_number,
+                                                 int        end_frame_number,
+                                                 glm::vec3* origin_frame_values,
+                                                 glm::vec3* euler_frame_values,
+                                                 glm::vec3* scale_frame_values,
+                                                 bool       is_smooth) const
+{
+    if(!origin_frame_values && !euler_frame_values && !scale_frame_values) {
+        return false;
+    }
+    script_t::const_iterator p = m_script.find(object_id);
+    if(p == m_script.end()) {
+        return false;
+    }
+    ObjectScript* object_script = (*p).second;
+    if(!object_script) {
+        return false;
+    }
+    if(origin_frame_values) {
+        object_script->export_frame_values_for_motion_track(MotionTrack::MOTION_TYPE_ORIGIN, start_frame_number, end_frame_number, origin_frame_values, is_smooth);
+    }
+    if(euler_frame_values) {
+        object_script->export_frame_values_for_motion_track(MotionTrack::MOTION_TYPE_EULER, start_frame_number, end_frame_number, euler_frame_values, is_smooth);
+    }
+    if(scale_frame_values) {
+        object_script->export_frame_values_for_motion_track(MotionTrack::MOTION_TYPE_SCALE, start_frame_number, end_frame_number, scale_frame_values, is_smooth);
     }
     return true;
 }
@@ -508,6 +637,130 @@ void KeyframeMgr::clear()
         delete object_script;
     }
     m_script.clear();
+    m_is_compiled = false;
+}
+
+bool KeyframeMgr::compile()
+{
+    m_compiled_object_ids.clear();
+    m_compiled_tracks.clear();
+    m_compiled_frame_numbers.clear();
+    m_compiled_values.clear();
+    for(script_t::const_iterator p = m_script.begin(); p != m_script.end(); p++) {
+        ObjectScript* object_script = (*p).second;
+        if(!object_script) {
+            continue;
+        }
+        ObjectScript::motion_tracks_t motion_tracks = object_script->get_motion_track();
+        m_compiled_object_ids.push_back((*p).first);
+        compile_motion_track(motion_tracks[MotionTrack::MOTION_TYPE_ORIGIN]);
+        compile_motion_track(motion_tracks[MotionTrack::MOTION_TYPE_EULER]);
+        compile_motion_track(motion_tracks[MotionTrack::MOTION_TYPE_SCALE]);
+    }
+    m_is_compiled = true;
+    return true;
+}
+
+long KeyframeMgr::get_compiled_object_id(int index) const
+{
+    if(index < 0 || index >= static_cast<int>(m_compiled_object_ids.size())) {
+        return -1;
+    }
+    return m_compiled_object_ids[index];
+}
+
+bool KeyframeMgr::interpolate_all_objects(int        frame_number,
+                                          glm::vec3* origins,
+                                          glm::vec3* eulers,
+                                          glm::vec3* scales,
+                                          bool       is_smooth)
+{
+    if(!origins && !eulers && !scales) {
+        return false;
+    }
+    if(!m_is_compiled) {
+        compile();
+    }
+    for(int i = 0; i < static_cast<int>(m_compiled_object_ids.size()); i++) {
+        compiled_track_t* tracks = &m_compiled_tracks[i * 3];
+        if(origins) {
+            interpolate_compiled_track(&tracks[0], frame_number, &origins[i], is_smooth);
+        }
+        if(eulers) {
+            interpolate_compiled_track(&tracks[1], frame_number, &eulers[i], is_smooth);
+        }
+        if(scales) {
+            interpolate_compiled_track(&tracks[2], frame_number, &scales[i], is_smooth);
+        }
+    }
+    return true;
+}
+
+void KeyframeMgr::compile_motion_track(const MotionTrack* motion_track)
+{
+    compiled_track_t track;
+    track.m_start  = m_compiled_frame_numbers.size();
+    track.m_count  = 0;
+    track.m_cursor = 0;
+    if(motion_track) {
+        MotionTrack::keyframes_t keyframes = motion_track->get_keyframes();
+        for(MotionTrack::keyframes_t::const_iterator p = keyframes.begin(); p != keyframes.end(); p++) {
+            Keyframe* keyframe = (*p).second;
+            if(!keyframe) { // erased
+                continue;
+            }
+            m_compiled_frame_numbers.push_back((*p).first);
+            m_compiled_values.push_back(keyframe->get_value());
+            m_compiled_values.push_back(keyframe->get_control_point1());
+            m_compiled_values.push_back(keyframe->get_control_point2());
+            track.m_count++;
+        }
+    }
+    m_compiled_tracks.push_back(track);
+}
+
+bool KeyframeMgr::interpolate_compiled_track(compiled_track_t* track, int frame_number, glm::vec3* value, bool is_smooth) const
+{
+    if(!track->m_count) {
+        return false;
+    }
+    const int*       frame_numbers = &m_compiled_frame_numbers[track->m_start];
+    const glm::vec3* values        = &m_compiled_values[track->m_start * 3];
+    int last = track->m_count - 1;
+    if(frame_number <= frame_numbers[0]) {
+        *value = values[0];
+        return true;
+    }
+    if(frame_number >= frame_numbers[last]) {
+        *value = values[last * 3];
+        return true;
+    }
+
+    // find segment [i, i + 1] enclosing frame number, trying cursor and its successor first
+    int i = track->m_cursor;
+    if(frame_number < frame_numbers[i] || frame_number >= frame_numbers[i + 1]) {
+        if(i + 2 <= last && frame_number >= frame_numbers[i + 1] && frame_number < frame_numbers[i + 2]) {
+            i++;
+        } else {
+            i = std::upper_bound(frame_numbers, frame_numbers + track->m_count, frame_number) - frame_numbers - 1;
+        }
+        track->m_cursor = i;
+    }
+    if(frame_number == frame_numbers[i]) {
+        *value = values[i * 3];
+        return true;
+    }
+    const glm::vec3* start_frame = &values[i * 3];
+    const glm::vec3* end_frame   = &values[(i + 1) * 3];
+    float alpha = static_cast<float>(frame_number - frame_numbers[i]) / static_cast<float>(frame_numbers[i + 1] - frame_numbers[i]);
+    if(is_smooth) {
+        // bezier interpolation
+        *value = bezier_interpolate(start_frame[0], start_frame[2], end_frame[1], end_frame[0], alpha);
+    } else {
+        // linear interpolation
+        *value = LERP(start_frame[0], end_frame[0], alpha);
+    }
+    return true;
 }
 
 }
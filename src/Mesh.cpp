@@ -24,10 +24,29 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <string>
+#include <vector>
 #include <iostream>
+#include <algorithm>
+#include <float.h>
+#include <math.h>
+#include <memory.h>
+#include <mutex>
+
+#define MIN_TRI_COUNT_PER_TASK    4096
+#define MIN_VERTEX_COUNT_PER_TASK 4096
+#define MAX_NUM_VERTEX            0x10000 // triangle indices are GLushort
+#define RIPPLE_BATCH_SIZE         8
 
 namespace vt {
 
+// parabolic sine approximation with one refinement step (max error ~0.001), branch-free so batches vectorize
+static inline float fast_sin(float x)
+{
+    x -= floorf(x * (0.5f / PI) + 0.5f) * (PI * 2); // wrap to [-pi, pi]
+    float y = x * (4 / PI) - x * fabsf(x) * (4 / (PI * PI));
+    return y + 0.225f * (y * fabsf(y) - y);
+}
+
 Mesh::Mesh(std::string name,
            size_t      num_vertex,
            size_t      num_tri)
@@ -53,7 +72,14 @@ Mesh::Mesh(std::string name,
       m_env_map_texture_index(-1),
       m_random_texture_index(-1),
       m_frontface_depth_overlay_texture_index(-1),
-      m_reflect_to_refract_ratio(1)
+      m_reflect_to_refract_ratio(1),
+      m_ripple_origin(0),
+      m_ripple_amplitude(0),
+      m_ripple_wavelength(1),
+      m_ripple_phase(0),
+      m_is_dirty_world_bbox(true),
+      m_world_bbox_transform_generation(0),
+      m_is_dirty_vert_tri_adjacency(true)
 {
     m_vert_coords   = new GLfloat[ num_vertex * 3];
     m_vert_normal   = new GLfloat[ num_vertex * 3];
@@ -134,6 +160,7 @@ void Mesh::resize(size_t num_vertex, size_t num_tri, bool preserve_mesh_geometry
     m_num_vertex   = num_vertex;
     m_num_tri      = num_tri;
     m_buffers_already_init = false;
+    m_is_dirty_vert_tri_adjacency = true;
     if(preserve_mesh_geometry) {
         if(new_vert_coord && new_vert_normal && new_vert_tangent && new_tex_coord) {
             for(int i = 0; i < static_cast<int>(num_vertex); i++) {
@@ -158,28 +185,110 @@ void Mesh::resize(size_t num_vertex, size_t num_tri, bool preserve_mesh_geometry
 
 void Mesh::merge(const MeshBase* other, bool copy_tex_coords)
 {
-    size_t prev_num_vertex  = get_num_vertex();
-    size_t prev_num_tri     = get_num_tri();
-    size_t other_num_vertex = other->get_num_vertex();
-    size_t other_num_tri    = other->get_num_tri();
-    resize(prev_num_vertex + other_num_vertex,
-           prev_num_tri    + other_num_tri,
-           true);
-    for(int i = 0; i < static_cast<int>(other_num_vertex); i++) {
-        set_vert_coord(prev_num_vertex + i,   other->get_vert_coord(i));
-        set_vert_normal(prev_num_vertex + i,  other->get_vert_normal(i));
-        set_vert_tangent(prev_num_vertex + i, other->get_vert_tangent(i));
-    }
-    if(copy_tex_coords) {
-        for(int j = 0; j < static_cast<int>(other_num_vertex); j++) {
-            set_tex_coord(prev_num_vertex + j, other->get_tex_coord(j));
+    merge_all(std::vector<const MeshBase*>(1, other), copy_tex_coords);
+}
+
+// sizes arrays once for all meshes, so merging n meshes is linear in total geometry
+void Mesh::merge_all(const std::vector<const MeshBase*> &others, bool copy_tex_coords)
+{
+    size_t prev_num_vertex = m_num_vertex;
+    size_t prev_num_tri    = m_num_tri;
+    size_t num_vertex      = prev_num_vertex;
+    size_t num_tri         = prev_num_tri;
+
+    // counts taken before resize, others may include this mesh
+    std::vector<size_t> other_num_vertices(others.size(), 0);
+    std::vector<size_t> other_num_tris(others.size(), 0);
+    for(int i = 0; i < static_cast<int>(others.size()); i++) {
+        if(!others[i]) {
+            continue;
         }
+        other_num_vertices[i] = others[i]->get_num_vertex();
+        other_num_tris[i]     = others[i]->get_num_tri();
+        num_vertex += other_num_vertices[i];
+        num_tri    += other_num_tris[i];
     }
-    for(int k = 0; k < static_cast<int>(other_num_tri); k++) {
-        glm::ivec3 prev_tri_indices = glm::ivec3(prev_num_vertex, prev_num_vertex, prev_num_vertex);
-        set_tri_indices(prev_num_tri + k, prev_tri_indices + other->get_tri_indices(k));
+    if(num_vertex == prev_num_vertex && num_tri == prev_num_tri) {
+        return;
     }
-    update_bbox();
+    if(num_vertex > MAX_NUM_VERTEX) {
+        std::cout << "Error: Cannot merge into mesh \"" << m_name << "\", too many vertices (" << num_vertex << ")" << std::endl;
+        return;
+    }
+
+    // take ownership of previous arrays so resize doesn't free them
+    GLfloat*  prev_vert_coords  = m_vert_coords;
+    GLfloat*  prev_vert_normal  = m_vert_normal;
+    GLfloat*  prev_vert_tangent = m_vert_tangent;
+    GLfloat*  prev_tex_coords   = m_tex_coords;
+    GLushort* prev_tri_indices  = m_tri_indices;
+    m_vert_coords  = NULL;
+    m_vert_normal  = NULL;
+    m_vert_tangent = NULL;
+    m_tex_coords   = NULL;
+    m_tri_indices  = NULL;
+    resize(num_vertex, num_tri);
+    memcpy(m_vert_coords,  prev_vert_coords,  sizeof(GLfloat)  * prev_num_vertex * 3);
+    memcpy(m_vert_normal,  prev_vert_normal,  sizeof(GLfloat)  * prev_num_vertex * 3);
+    memcpy(m_vert_tangent, prev_vert_tangent, sizeof(GLfloat)  * prev_num_vertex * 3);
+    memcpy(m_tex_coords,   prev_tex_coords,   sizeof(GLfloat)  * prev_num_vertex * 2);
+    memcpy(m_tri_indices,  prev_tri_indices,  sizeof(GLushort) * prev_num_tri    * 3);
+    delete[] prev_vert_coords;
+    delete[] prev_vert_normal;
+    delete[] prev_vert_tangent;
+    delete[] prev_tex_coords;
+    delete[] prev_tri_indices;
+
+    bool has_bbox = (prev_num_vertex != 0);
+    size_t vert_offset = prev_num_vertex;
+    size_t tri_offset  = prev_num_tri;
+    for(int j = 0; j < static_cast<int>(others.size()); j++) {
+        const MeshBase* other = others[j];
+        if(!other) {
+            continue;
+        }
+        size_t other_num_vertex = other_num_vertices[j];
+        size_t other_num_tri    = other_num_tris[j];
+        const Mesh* other_mesh = dynamic_cast<const Mesh*>(other);
+        if(other_mesh) {
+            memcpy(&m_vert_coords[vert_offset * 3],  other_mesh->m_vert_coords,  sizeof(GLfloat) * other_num_vertex * 3);
+            memcpy(&m_vert_normal[vert_offset * 3],  other_mesh->m_vert_normal,  sizeof(GLfloat) * other_num_vertex * 3);
+            memcpy(&m_vert_tangent[vert_offset * 3], other_mesh->m_vert_tangent, sizeof(GLfloat) * other_num_vertex * 3);
+            if(copy_tex_coords) {
+                memcpy(&m_tex_coords[vert_offset * 2], other_mesh->m_tex_coords, sizeof(GLfloat) * other_num_vertex * 2);
+            }
+            const GLushort* other_tri_indices = other_mesh->m_tri_indices;
+            GLushort*       tri_indices       = &m_tri_indices[tri_offset * 3];
+            GLushort        index_offset      = vert_offset;
+            for(int i = 0; i < static_cast<int>(other_num_tri * 3); i++) {
+                tri_indices[i] = other_tri_indices[i] + index_offset;
+            }
+        } else {
+            for(int i = 0; i < static_cast<int>(other_num_vertex); i++) {
+                set_vert_coord(vert_offset + i,   other->get_vert_coord(i));
+                set_vert_normal(vert_offset + i,  other->get_vert_normal(i));
+                set_vert_tangent(vert_offset + i, other->get_vert_tangent(i));
+            }
+            if(copy_tex_coords) {
+                for(int j = 0; j < static_cast<int>(other_num_vertex); j++) {
+                    set_tex_coord(vert_offset + j, other->get_tex_coord(j));
+                }
+            }
+            for(int k = 0; k < static_cast<int>(other_num_tri); k++) {
+                set_tri_indices(tri_offset + k, glm::ivec3(vert_offset) + other->get_tri_indices(k));
+            }
+        }
+        if(other_num_vertex) {
+            glm::vec3 other_min, other_max;
+            other->get_min_max(&other_min, &other_max);
+            m_min = has_bbox ? glm::min(m_min, other_min) : other_min;
+            m_max = has_bbox ? glm::max(m_max, other_max) : other_max;
+            has_bbox = true;
+        }
+        vert_offset += other_num_vertex;
+        tri_offset  += other_num_tri;
+    }
+    m_is_dirty_world_bbox = true;
 }
 
 glm::vec3 Mesh::get_vert_coord(int index) const
@@ -259,73 +368,254 @@ void Mesh::set_tri_indices(int index, glm::ivec3 indices)
     m_tri_indices[offset + 0] = indices[0];
     m_tri_indices[offset + 1] = indices[1];
     m_tri_indices[offset + 2] = indices[2];
+    m_is_dirty_vert_tri_adjacency = true;
+}
+
+void Mesh::set_vert_coords(const glm::vec3* coords)
+{
+    for(int i = 0; i < static_cast<int>(m_num_vertex); i++) {
+        m_vert_coords[i * 3 + 0] = coords[i].x;
+        m_vert_coords[i * 3 + 1] = coords[i].y;
+        m_vert_coords[i * 3 + 2] = coords[i].z;
+    }
+}
+
+void Mesh::set_tex_coords(const glm::vec2* coords)
+{
+    for(int i = 0; i < static_cast<int>(m_num_vertex); i++) {
+        m_tex_coords[i * 2 + 0] = coords[i].x;
+        m_tex_coords[i * 2 + 1] = coords[i].y;
+    }
+}
+
+void Mesh::set_tri_indices(const glm::ivec3* indices)
+{
+    for(int i = 0; i < static_cast<int>(m_num_tri); i++) {
+        m_tri_indices[i * 3 + 0] = indices[i].x;
+        m_tri_indices[i * 3 + 1] = indices[i].y;
+        m_tri_indices[i * 3 + 2] = indices[i].z;
+    }
+    m_is_dirty_vert_tri_adjacency = true;
 }
 
 void Mesh::update_bbox()
 {
-#if 1
-    glm::ivec3 tri_indices = get_tri_indices(0);
-    m_min = m_max = get_vert_coord(tri_indices[0]);
-    m_min = m_max = get_vert_coord(tri_indices[1]);
-    m_min = m_max = get_vert_coord(tri_indices[2]);
-    for(int i = 1; i < static_cast<int>(m_num_tri); i++) {
-        glm::ivec3 tri_indices = get_tri_indices(i);
-        glm::vec3 p0 = get_vert_coord(tri_indices[0]);
-        glm::vec3 p1 = get_vert_coord(tri_indices[1]);
-        glm::vec3 p2 = get_vert_coord(tri_indices[2]);
-        m_max = glm::max(m_max, p0);
-        m_min = glm::min(m_min, p0);
-        m_max = glm::max(m_max, p1);
-        m_min = glm::min(m_min, p1);
-        m_max = glm::max(m_max, p2);
-        m_min = glm::min(m_min, p2);
-    }
-#else
-    m_min = m_max = get_vert_coord(0);
-    for(int i = 1; i < static_cast<int>(m_num_vertex); i++) {
-        glm::vec3 cur = get_vert_coord(i);
-        m_max = glm::max(m_max, cur);
-        m_min = glm::min(m_min, cur);
-    }
-#endif
+    update_vertices(NULL);
 }
 
 void Mesh::update_normals_and_tangents()
 {
-    if(m_smooth) {
-        for(int i = 0; i < static_cast<int>(m_num_tri); i++) {
-            glm::ivec3 tri_indices = get_tri_indices(i);
-            glm::vec3 p0 = get_vert_coord(tri_indices[0]);
-            glm::vec3 p1 = get_vert_coord(tri_indices[1]);
-            glm::vec3 p2 = get_vert_coord(tri_indices[2]);
-            glm::vec3 e1 = glm::normalize(p1 - p0);
-            glm::vec3 e2 = glm::normalize(p2 - p0);
-            glm::vec3 n = glm::normalize(glm::cross(e1, e2));
-            for(int j = 0; j < 3; j++) {
-                int vert_index = tri_indices[j];
-                set_vert_normal( vert_index, get_vert_normal(vert_index) + n);
-                set_vert_tangent(vert_index, glm::vec3(0));
+    if(!m_num_vertex || !m_num_tri) {
+        return;
+    }
+    if(m_is_dirty_vert_tri_adjacency) {
+        update_vert_tri_adjacency();
+    }
+    m_tri_normals.resize(m_num_tri);
+    m_tri_tangents.resize(m_num_tri);
+    parallel_for(m_num_tri, MIN_TRI_COUNT_PER_TASK, [this](int start_index, int end_index) {
+        update_tri_normals_and_tangents(start_index, end_index);
+    });
+    parallel_for(m_num_vertex, MIN_VERTEX_COUNT_PER_TASK, [this](int start_index, int end_index) {
+        update_vert_normals_and_tangents(start_index, end_index);
+    });
+}
+
+// displaces vertices in place, normals and bbox left to the caller
+void Mesh::apply_ripple(glm::vec3 origin, float amplitude, float wavelength, float phase)
+{
+    float wave_number = PI * 2 / wavelength;
+    parallel_for(m_num_vertex, MIN_VERTEX_COUNT_PER_TASK, [this, origin, amplitude, wave_number, phase](int start_index, int end_index) {
+        apply_ripple_range(start_index, end_index, origin, amplitude, wave_number, phase);
+    });
+}
+
+void Mesh::apply_ripple_range(int start_index, int end_index, glm::vec3 origin, float amplitude, float wave_number, float phase)
+{
+    for(int i = start_index; i < end_index; i += RIPPLE_BATCH_SIZE) {
+        int batch_size = std::min(RIPPLE_BATCH_SIZE, end_index - i);
+        GLfloat* vert_coords = &m_vert_coords[i * 3];
+        float x[RIPPLE_BATCH_SIZE] = {0};
+        float y[RIPPLE_BATCH_SIZE];
+        float z[RIPPLE_BATCH_SIZE] = {0};
+        for(int j = 0; j < batch_size; j++) {
+            x[j] = vert_coords[j * 3 + 0];
+            z[j] = vert_coords[j * 3 + 2];
+        }
+        // fixed trip count so the compiler can keep the whole batch in SIMD registers
+        for(int j = 0; j < RIPPLE_BATCH_SIZE; j++) {
+            float dx = x[j] - origin.x;
+            float dz = z[j] - origin.z;
+            y[j] = origin.y + fast_sin(sqrtf(dx * dx + dz * dz) * wave_number + phase) * amplitude;
+        }
+        for(int j = 0; j < batch_size; j++) {
+            vert_coords[j * 3 + 1] = y[j];
+        }
+    }
+}
+
+// ripple applied on GPU by *_ripple vertex shaders, zero amplitude disables
+void Mesh::set_ripple(glm::vec3 origin, float amplitude, float wavelength, float phase)
+{
+    // widened bbox depends only on amplitude and origin, so animating phase stays free
+    bool bbox_changed = (amplitude != m_ripple_amplitude || origin != m_ripple_origin);
+    m_ripple_origin     = origin;
+    m_ripple_amplitude  = amplitude;
+    m_ripple_wavelength = wavelength;
+    m_ripple_phase      = phase;
+    if(bbox_changed) {
+        update_bbox(); // widen to cover displacement for culling
+    }
+}
+
+// transforms vertices (if transform given) and updates bbox in the same pass
+void Mesh::update_vertices(const glm::mat4* transform)
+{
+    if(m_is_dirty_vert_tri_adjacency) {
+        update_vert_tri_adjacency();
+    }
+    glm::vec3 min(FLT_MAX);
+    glm::vec3 max(-FLT_MAX);
+    std::mutex mutex;
+    parallel_for(m_num_vertex, MIN_VERTEX_COUNT_PER_TASK, [this, transform, &min, &max, &mutex](int start_index, int end_index) {
+        glm::vec3 range_min, range_max;
+        update_vertex_range(start_index, end_index, transform, &range_min, &range_max);
+        std::lock_guard<std::mutex> lock(mutex);
+        min = glm::min(min, range_min);
+        max = glm::max(max, range_max);
+    });
+    if(min.x > max.x) { // no referenced vertices
+        min = max = glm::vec3(0);
+    }
+    if(m_ripple_amplitude) { // displaced on GPU
+        min.y = std::min(min.y, m_ripple_origin.y - glm::abs(m_ripple_amplitude));
+        max.y = std::max(max.y, m_ripple_origin.y + glm::abs(m_ripple_amplitude));
+    }
+    m_min = min;
+    m_max = max;
+    m_is_dirty_world_bbox = true;
+}
+
+// NOTE: bbox only includes vertices referenced by triangles
+void Mesh::update_vertex_range(int start_index, int end_index, const glm::mat4* transform, glm::vec3* min, glm::vec3* max)
+{
+    glm::vec3 range_min(FLT_MAX);
+    glm::vec3 range_max(-FLT_MAX);
+    if(transform) {
+        glm::mat3 tangent_transform(*transform);
+        glm::mat3 normal_transform = glm::transpose(glm::inverse(tangent_transform)); // normals are directions, so w=0
+        for(int i = start_index; i < end_index; i++) {
+            GLfloat* vert_coord   = &m_vert_coords[i * 3];
+            GLfloat* vert_normal  = &m_vert_normal[i * 3];
+            GLfloat* vert_tangent = &m_vert_tangent[i * 3];
+            glm::vec3 pos     = glm::vec3(*transform * glm::vec4(vert_coord[0], vert_coord[1], vert_coord[2], 1));
+            glm::vec3 normal  = normal_transform  * glm::vec3(vert_normal[0],  vert_normal[1],  vert_normal[2]);
+            glm::vec3 tangent = tangent_transform * glm::vec3(vert_tangent[0], vert_tangent[1], vert_tangent[2]);
+            normal  *= glm::inversesqrt(std::max(glm::dot(normal, normal), FLT_MIN));
+            tangent *= glm::inversesqrt(std::max(glm::dot(tangent, tangent), FLT_MIN));
+            vert_coord[0]   = pos.x;
+            vert_coord[1]   = pos.y;
+            vert_coord[2]   = pos.z;
+            vert_normal[0]  = normal.x;
+            vert_normal[1]  = normal.y;
+            vert_normal[2]  = normal.z;
+            vert_tangent[0] = tangent.x;
+            vert_tangent[1] = tangent.y;
+            vert_tangent[2] = tangent.z;
+            if(m_vert_tri_offsets[i] != m_vert_tri_offsets[i + 1]) {
+                range_min = glm::min(range_min, pos);
+                range_max = glm::max(range_max, pos);
             }
         }
-        for(int k = 0; k < static_cast<int>(m_num_vertex); k++) {
-            set_vert_normal(k, glm::normalize(get_vert_normal(k)));
+    } else {
+        for(int i = start_index; i < end_index; i++) {
+            const GLfloat* vert_coord = &m_vert_coords[i * 3];
+            glm::vec3 pos(vert_coord[0], vert_coord[1], vert_coord[2]);
+            if(m_vert_tri_offsets[i] != m_vert_tri_offsets[i + 1]) {
+                range_min = glm::min(range_min, pos);
+                range_max = glm::max(range_max, pos);
+            }
         }
-        resize(m_num_vertex, m_num_tri, true);
-        return;
     }
-    for(int i = 0; i < static_cast<int>(m_num_tri); i++) {
-        glm::ivec3 tri_indices = get_tri_indices(i);
-        glm::vec3 p0 = get_vert_coord(tri_indices[0]);
-        glm::vec3 p1 = get_vert_coord(tri_indices[1]);
-        glm::vec3 p2 = get_vert_coord(tri_indices[2]);
-        glm::vec3 e1 = glm::normalize(p1 - p0);
-        glm::vec3 e2 = glm::normalize(p2 - p0);
-        glm::vec3 n = glm::normalize(glm::cross(e1, e2));
-        for(int j = 0; j < 3; j++) {
-            int vert_index = tri_indices[j];
-            set_vert_normal( vert_index, n);
-            set_vert_tangent(vert_index, e1);
+    *min = range_min;
+    *max = range_max;
+}
+
+// counting sort of triangle corners by vertex, keeps triangles of each vertex in ascending order
+void Mesh::update_vert_tri_adjacency()
+{
+    int num_corners = m_num_tri * 3;
+    m_vert_tri_offsets.assign(m_num_vertex + 1, 0);
+    m_vert_tris.resize(num_corners);
+    for(int i = 0; i < num_corners; i++) {
+        m_vert_tri_offsets[m_tri_indices[i] + 1]++;
+    }
+    for(int j = 0; j < static_cast<int>(m_num_vertex); j++) {
+        m_vert_tri_offsets[j + 1] += m_vert_tri_offsets[j];
+    }
+    std::vector<int> vert_tri_fill(m_vert_tri_offsets.begin(), m_vert_tri_offsets.end() - 1);
+    for(int k = 0; k < num_corners; k++) {
+        m_vert_tris[vert_tri_fill[m_tri_indices[k]]++] = k / 3;
+    }
+    m_is_dirty_vert_tri_adjacency = false;
+}
+
+// http://www.terathon.com/code/tangent.html
+void Mesh::update_tri_normals_and_tangents(int start_index, int end_index)
+{
+    for(int i = start_index; i < end_index; i++) {
+        const GLushort* tri_indices = &m_tri_indices[i * 3];
+        const GLfloat*  v0 = &m_vert_coords[tri_indices[0] * 3];
+        const GLfloat*  v1 = &m_vert_coords[tri_indices[1] * 3];
+        const GLfloat*  v2 = &m_vert_coords[tri_indices[2] * 3];
+        const GLfloat*  t0 = &m_tex_coords[tri_indices[0] * 2];
+        const GLfloat*  t1 = &m_tex_coords[tri_indices[1] * 2];
+        const GLfloat*  t2 = &m_tex_coords[tri_indices[2] * 2];
+        glm::vec3 e1(v1[0] - v0[0], v1[1] - v0[1], v1[2] - v0[2]);
+        glm::vec3 e2(v2[0] - v0[0], v2[1] - v0[1], v2[2] - v0[2]);
+        glm::vec2 duv1(t1[0] - t0[0], t1[1] - t0[1]);
+        glm::vec2 duv2(t2[0] - t0[0], t2[1] - t0[1]);
+        m_tri_normals[i] = glm::cross(e1, e2); // length is twice the area
+
+        // fall back to first edge if tex coords are degenerate
+        float uv_det  = duv1.x * duv2.y - duv2.x * duv1.y;
+        float has_uv  = static_cast<float>(uv_det != 0);
+        float inv_det = has_uv / (uv_det + (1 - has_uv));
+        m_tri_tangents[i] = (e1 * duv2.y - e2 * duv1.y) * inv_det + e1 * (1 - has_uv);
+    }
+}
+
+void Mesh::update_vert_normals_and_tangents(int start_index, int end_index)
+{
+    for(int i = start_index; i < end_index; i++) {
+        int start_offset = m_vert_tri_offsets[i];
+        int end_offset   = m_vert_tri_offsets[i + 1];
+        if(start_offset == end_offset) { // unreferenced vertex
+            continue;
         }
+        glm::vec3 normal(0);
+        glm::vec3 tangent(0);
+        if(m_smooth) {
+            for(int j = start_offset; j < end_offset; j++) {
+                normal  += m_tri_normals[ m_vert_tris[j]];
+                tangent += m_tri_tangents[m_vert_tris[j]];
+            }
+        } else {
+            // last triangle wins, same as writing triangles in order
+            normal  = m_tri_normals[ m_vert_tris[end_offset - 1]];
+            tangent = m_tri_tangents[m_vert_tris[end_offset - 1]];
+        }
+        normal  *= glm::inversesqrt(std::max(glm::dot(normal, normal), FLT_MIN));
+        tangent -= normal * glm::dot(normal, tangent); // Gram-Schmidt orthogonalize
+        tangent *= glm::inversesqrt(std::max(glm::dot(tangent, tangent), FLT_MIN));
+        GLfloat* vert_normal  = &m_vert_normal[i * 3];
+        GLfloat* vert_tangent = &m_vert_tangent[i * 3];
+        vert_normal[0]  = normal.x;
+        vert_normal[1]  = normal.y;
+        vert_normal[2]  = normal.z;
+        vert_tangent[0] = tangent.x;
+        vert_tangent[1] = tangent.y;
+        vert_tangent[2] = tangent.z;
     }
 }
 
@@ -335,6 +625,39 @@ void Mesh::get_min_max(glm::vec3* min, glm::vec3* max) const
     BBoxObject::get_min_max(min, max);
 }
 
+void Mesh::get_world_center_extent(glm::vec3* center, glm::vec3* extent)
+{
+    if(!center || !extent) {
+        return;
+    }
+    unsigned long transform_generation = get_transform_generation();
+    if(m_is_dirty_world_bbox || m_world_bbox_transform_generation != transform_generation) {
+        glm::mat4 transform = get_transform();
+
+        // center-extent form avoids transforming all 8 corners
+        glm::mat3 abs_basis(glm::abs(glm::vec3(transform[0])),
+                            glm::abs(glm::vec3(transform[1])),
+                            glm::abs(glm::vec3(transform[2])));
+        m_world_center = glm::vec3(transform * glm::vec4(get_center(), 1));
+        m_world_extent = abs_basis * ((m_max - m_min) * 0.5f);
+        m_is_dirty_world_bbox             = false;
+        m_world_bbox_transform_generation = transform_generation;
+    }
+    *center = m_world_center;
+    *extent = m_world_extent;
+}
+
+void Mesh::get_world_min_max(glm::vec3* min, glm::vec3* max)
+{
+    if(!min || !max) {
+        return;
+    }
+    glm::vec3 center, extent;
+    get_world_center_extent(&center, &extent);
+    *min = center - extent;
+    *max = center + extent;
+}
+
 // NOTE: required by base class pure virtual despite being defined in another base class
 glm::vec3 Mesh::in_abs_system(glm::vec3 local_point)
 {
@@ -489,13 +812,7 @@ void Mesh::set_ambient_color(glm::vec3 ambient_color)
 
 void Mesh::transform_vertices(glm::mat4 transform)
 {
-    glm::mat4 normal_transform = glm::transpose(glm::inverse(transform));
-    for(int i = 0; i < static_cast<int>(m_num_vertex); i++) {
-        set_vert_coord(i,   glm::vec3(transform        * glm::vec4(get_vert_coord(i),   1)));
-        set_vert_normal(i,  glm::vec3(normal_transform * glm::vec4(get_vert_normal(i),  1)));
-        set_vert_tangent(i, glm::vec3(normal_transform * glm::vec4(get_vert_tangent(i), 1)));
-    }
-    update_bbox();
+    update_vertices(&transform);
 }
 
 void Mesh::flatten(glm::mat4* basis)
@@ -20,7 +20,14 @@
 #include <Scene.h>
 #include <Util.h>
 #include <glm/glm.hpp>
-#include <map>
+#include <vector>
+#include <algorithm>
+#include <iostream>
+#include <stdint.h>
+
+#define EMPTY_EDGE_KEY     0xFFFFFFFF
+#define MAX_NUM_VERTEX     0x10000 // triangle indices are GLushort
+#define MIN_COUNT_PER_TASK 4096
 
 namespace vt {
 
@@ -35,17 +42,14 @@ void mesh_attach(Scene* scene, MeshBase* mesh1, MeshBase* mesh2)
     scene->remove_mesh(cast_mesh(mesh1));
 }
 
-void mesh_apply_ripple(MeshBase* mesh, glm::vec3 origin, float amplitude, float wavelength, float phase, bool smooth)
+void mesh_apply_ripple(MeshBase* mesh, glm::vec3 origin, float amplitude, float wavelength, float phase, bool smooth, ripple_mode_t ripple_mode)
 {
-    size_t num_vertex = mesh->get_num_vertex();
-    for(int i = 0; i < static_cast<int>(num_vertex); i++) {
-        glm::vec3 pos = mesh->get_vert_coord(i);
-        glm::vec2 p1(origin.x, origin.z);
-        glm::vec2 p2(pos.x, pos.z);
-        float radius = glm::distance(p1, p2);
-        pos.y = origin.y + static_cast<float>(sin(radius / (wavelength / (PI * 2)) + phase)) * amplitude;
-        mesh->set_vert_coord(i, pos);
+    if(ripple_mode == RIPPLE_MODE_GPU) {
+        // displacement and normals are computed by the *_ripple vertex shaders, so no re-upload
+        mesh->set_ripple(origin, amplitude, wavelength, phase);
+        return;
     }
+    mesh->apply_ripple(origin, amplitude, wavelength, phase);
     if(smooth) {
         mesh->set_smooth(true);
     }
@@ -53,136 +57,150 @@ void mesh_apply_ripple(MeshBase* mesh, glm::vec3 origin, float amplitude, float
     mesh->update_bbox();
 }
 
-void mesh_tessellate(MeshBase* mesh, tessellation_type_t tessellation_type, bool smooth)
+// open addressing hash of edges keyed by packed vertex index pair, returns index of edge
+static int find_or_insert_edge(std::vector<uint32_t>*   edge_keys,
+                               std::vector<int>*        edge_indices,
+                               std::vector<glm::ivec2>* edges,
+                               int                      vert_index1,
+                               int                      vert_index2)
 {
-    size_t prev_num_vert = mesh->get_num_vertex();
-    size_t prev_num_tri  = mesh->get_num_tri();
-    switch(tessellation_type) {
-        case TESSELLATION_TYPE_EDGE_CENTER:
-            {
-                size_t new_num_vertex = prev_num_vert + prev_num_tri * 3;
-                size_t new_num_tri    = prev_num_tri * 4;
-                glm::vec3  new_vert_coord[new_num_vertex];
-                glm::vec2  new_tex_coord[new_num_vertex];
-                glm::ivec3 new_tri_indices[new_num_tri];
-                for(int i = 0; i < static_cast<int>(prev_num_vert); i++) {
-                    new_vert_coord[i] = mesh->get_vert_coord(i);
-                    new_tex_coord[i]  = mesh->get_tex_coord(i);
-                }
+    uint32_t key  = MAKELONG(std::min(vert_index1, vert_index2), std::max(vert_index1, vert_index2));
+    uint32_t mask = edge_keys->size() - 1;
+    uint32_t slot = (key * 2654435761u) & mask; // Knuth multiplicative hash
+    while((*edge_keys)[slot] != EMPTY_EDGE_KEY) {
+        if((*edge_keys)[slot] == key) {
+            return (*edge_indices)[slot];
+        }
+        slot = (slot + 1) & mask;
+    }
+    int edge_index = edges->size();
+    (*edge_keys)[slot]    = key;
+    (*edge_indices)[slot] = edge_index;
+    edges->push_back(glm::ivec2(vert_index1, vert_index2));
+    return edge_index;
+}
 
-                int current_vert_index = prev_num_vert;
-                int current_face_index = 0;
-                std::map<uint32_t, int> shared_vert_map;
-                for(int j = 0; j < static_cast<int>(prev_num_tri); j++) {
-                    glm::ivec3 tri_indices = mesh->get_tri_indices(j);
-                    glm::vec3 vert_a_coord = mesh->get_vert_coord(tri_indices[0]);
-                    glm::vec3 vert_b_coord = mesh->get_vert_coord(tri_indices[1]);
-                    glm::vec3 vert_c_coord = mesh->get_vert_coord(tri_indices[2]);
-                    glm::vec2 tex_a_coord  = mesh->get_tex_coord(tri_indices[0]);
-                    glm::vec2 tex_b_coord  = mesh->get_tex_coord(tri_indices[1]);
-                    glm::vec2 tex_c_coord  = mesh->get_tex_coord(tri_indices[2]);
+void mesh_tessellate(MeshBase* mesh, tessellation_type_t tessellation_type, bool smooth, int levels)
+{
+    size_t num_vertex = mesh->get_num_vertex();
+    size_t num_tri    = mesh->get_num_tri();
+    if(!num_tri) {
+        return;
+    }
+    std::vector<glm::vec3>  vert_coord(num_vertex);
+    std::vector<glm::vec2>  tex_coord(num_vertex);
+    std::vector<glm::ivec3> tri_indices(num_tri);
+    for(int i = 0; i < static_cast<int>(num_vertex); i++) {
+        vert_coord[i] = mesh->get_vert_coord(i);
+        tex_coord[i]  = mesh->get_tex_coord(i);
+    }
+    for(int j = 0; j < static_cast<int>(num_tri); j++) {
+        tri_indices[j] = mesh->get_tri_indices(j);
+    }
 
-                    uint32_t new_vert_shared_ab_key = MAKELONG(std::min(tri_indices[0], tri_indices[1]), std::max(tri_indices[0], tri_indices[1]));
-                    int new_vert_shared_ab_index = 0;
-                    std::map<uint32_t, int>::iterator p = shared_vert_map.find(new_vert_shared_ab_key);
-                    if(p == shared_vert_map.end()) {
-                        new_vert_shared_ab_index = current_vert_index++;
-                        shared_vert_map.insert(std::pair<uint32_t, int>(new_vert_shared_ab_key, new_vert_shared_ab_index));
-                    } else {
-                        new_vert_shared_ab_index = (*p).second;
+    // reused across levels
+    std::vector<glm::vec3>  new_vert_coord;
+    std::vector<glm::vec2>  new_tex_coord;
+    std::vector<glm::ivec3> new_tri_indices;
+    std::vector<uint32_t>   edge_keys;
+    std::vector<int>        edge_indices;
+    std::vector<glm::ivec2> edges;
+    std::vector<glm::ivec3> tri_edges;
+    for(int level = 0; level < levels; level++) {
+        switch(tessellation_type) {
+            case TESSELLATION_TYPE_EDGE_CENTER:
+                {
+                    // number edges in order of first appearance
+                    size_t capacity = 1;
+                    while(capacity < num_tri * 3 * 2) {
+                        capacity <<= 1;
                     }
-                    new_vert_coord[new_vert_shared_ab_index] = (vert_a_coord + vert_b_coord) * 0.5f;
-                    new_tex_coord[new_vert_shared_ab_index]  = (tex_a_coord + tex_b_coord) * 0.5f;
-
-                    uint32_t new_vert_shared_bc_key = MAKELONG(std::min(tri_indices[1], tri_indices[2]), std::max(tri_indices[1], tri_indices[2]));
-                    int new_vert_shared_bc_index = 0;
-                    std::map<uint32_t, int>::iterator q = shared_vert_map.find(new_vert_shared_bc_key);
-                    if(q == shared_vert_map.end()) {
-                        new_vert_shared_bc_index = current_vert_index++;
-                        shared_vert_map.insert(std::pair<uint32_t, int>(new_vert_shared_bc_key, new_vert_shared_bc_index));
-                    } else {
-                        new_vert_shared_bc_index = (*q).second;
+                    edge_keys.assign(capacity, EMPTY_EDGE_KEY);
+                    edge_indices.resize(capacity);
+                    edges.clear();
+                    tri_edges.resize(num_tri);
+                    for(int j = 0; j < static_cast<int>(num_tri); j++) {
+                        glm::ivec3 tri = tri_indices[j];
+                        // separate statements so edges are numbered in a fixed order
+                        int ab = find_or_insert_edge(&edge_keys, &edge_indices, &edges, tri[0], tri[1]);
+                        int bc = find_or_insert_edge(&edge_keys, &edge_indices, &edges, tri[1], tri[2]);
+                        int ca = find_or_insert_edge(&edge_keys, &edge_indices, &edges, tri[2], tri[0]);
+                        tri_edges[j] = glm::ivec3(ab, bc, ca);
                     }
-                    new_vert_coord[new_vert_shared_bc_index] = (vert_b_coord + vert_c_coord) * 0.5f;
-                    new_tex_coord[new_vert_shared_bc_index]  = (tex_b_coord + tex_c_coord) * 0.5f;
-
-                    uint32_t new_vert_shared_ca_key = MAKELONG(std::min(tri_indices[2], tri_indices[0]), std::max(tri_indices[2], tri_indices[0]));
-                    int new_vert_shared_ca_index = 0;
-                    std::map<uint32_t, int>::iterator r = shared_vert_map.find(new_vert_shared_ca_key);
-                    if(r == shared_vert_map.end()) {
-                        new_vert_shared_ca_index = current_vert_index++;
-                        shared_vert_map.insert(std::pair<uint32_t, int>(new_vert_shared_ca_key, new_vert_shared_ca_index));
-                    } else {
-                        new_vert_shared_ca_index = (*r).second;
+                    size_t new_num_vertex = num_vertex + edges.size();
+                    size_t new_num_tri    = num_tri * 4;
+                    if(new_num_vertex > MAX_NUM_VERTEX) {
+                        std::cout << "Warning: Tessellation stopped at level " << level << ", too many vertices" << std::endl;
+                        level = levels;
+                        break;
                     }
-                    new_vert_coord[new_vert_shared_ca_index] = (vert_c_coord + vert_a_coord) * 0.5f;
-                    new_tex_coord[new_vert_shared_ca_index]  = (tex_c_coord + tex_a_coord) * 0.5f;
-
-                    new_tri_indices[current_face_index++] = glm::ivec3(tri_indices[0], new_vert_shared_ab_index, new_vert_shared_ca_index);
-                    new_tri_indices[current_face_index++] = glm::ivec3(tri_indices[1], new_vert_shared_bc_index, new_vert_shared_ab_index);
-                    new_tri_indices[current_face_index++] = glm::ivec3(tri_indices[2], new_vert_shared_ca_index, new_vert_shared_bc_index);
-                    new_tri_indices[current_face_index++] = glm::ivec3(new_vert_shared_ab_index, new_vert_shared_bc_index, new_vert_shared_ca_index);
-                }
-
-                new_num_vertex = current_vert_index;
-                new_num_tri    = current_face_index;
-                mesh->resize(new_num_vertex, new_num_tri);
-                for(int k = 0; k < static_cast<int>(new_num_vertex); k++) {
-                    mesh->set_vert_coord(k, new_vert_coord[k]);
-                    mesh->set_tex_coord(k,  new_tex_coord[k]);
+                    new_vert_coord.resize(new_num_vertex);
+                    new_tex_coord.resize(new_num_vertex);
+                    new_tri_indices.resize(new_num_tri);
+                    std::copy(vert_coord.begin(), vert_coord.end(), new_vert_coord.begin());
+                    std::copy(tex_coord.begin(),  tex_coord.end(),  new_tex_coord.begin());
+                    parallel_for(edges.size(), MIN_COUNT_PER_TASK, [&](int start_index, int end_index) {
+                        for(int k = start_index; k < end_index; k++) {
+                            glm::ivec2 edge = edges[k];
+                            new_vert_coord[num_vertex + k] = (vert_coord[edge[0]] + vert_coord[edge[1]]) * 0.5f;
+                            new_tex_coord[num_vertex + k]  = (tex_coord[edge[0]]  + tex_coord[edge[1]])  * 0.5f;
+                        }
+                    });
+                    parallel_for(num_tri, MIN_COUNT_PER_TASK, [&](int start_index, int end_index) {
+                        for(int t = start_index; t < end_index; t++) {
+                            glm::ivec3 tri = tri_indices[t];
+                            glm::ivec3 mid = tri_edges[t] + glm::ivec3(num_vertex);
+                            new_tri_indices[t * 4 + 0] = glm::ivec3(tri[0], mid[0], mid[2]);
+                            new_tri_indices[t * 4 + 1] = glm::ivec3(tri[1], mid[1], mid[0]);
+                            new_tri_indices[t * 4 + 2] = glm::ivec3(tri[2], mid[2], mid[1]);
+                            new_tri_indices[t * 4 + 3] = glm::ivec3(mid[0], mid[1], mid[2]);
+                        }
+                    });
+                    num_vertex = new_num_vertex;
+                    num_tri    = new_num_tri;
+                    vert_coord.swap(new_vert_coord);
+                    tex_coord.swap(new_tex_coord);
+                    tri_indices.swap(new_tri_indices);
                 }
-                for(int t = 0; t < static_cast<int>(new_num_tri); t++) {
-                    mesh->set_tri_indices(t, new_tri_indices[t]);
-                }
-            }
-            break;
-        case TESSELLATION_TYPE_TRI_CENTER:
-            {
-                size_t new_num_vertex = prev_num_vert + prev_num_tri;
-                size_t new_num_tri    = prev_num_tri * 3;
-                glm::vec3  new_vert_coord[new_num_vertex];
-                glm::vec2  new_tex_coord[new_num_vertex];
-                glm::ivec3 new_tri_indices[new_num_tri];
-                for(int i = 0; i < static_cast<int>(prev_num_vert); i++) {
-                    new_vert_coord[i] = mesh->get_vert_coord(i);
-                    new_tex_coord[i]  = mesh->get_tex_coord(i);
-                }
-
-                int current_vert_index = prev_num_vert;
-                int current_face_index = 0;
-                std::map<uint32_t, int> shared_vert_map;
-                for(int j = 0; j < static_cast<int>(prev_num_tri); j++) {
-                    glm::ivec3 tri_indices = mesh->get_tri_indices(j);
-                    glm::vec3 vert_a_coord = mesh->get_vert_coord(tri_indices[0]);
-                    glm::vec3 vert_b_coord = mesh->get_vert_coord(tri_indices[1]);
-                    glm::vec3 vert_c_coord = mesh->get_vert_coord(tri_indices[2]);
-                    glm::vec2 tex_a_coord  = mesh->get_tex_coord(tri_indices[0]);
-                    glm::vec2 tex_b_coord  = mesh->get_tex_coord(tri_indices[1]);
-                    glm::vec2 tex_c_coord  = mesh->get_tex_coord(tri_indices[2]);
-
-                    int new_vert_index = current_vert_index;
-                    new_vert_coord[new_vert_index] = (vert_a_coord + vert_b_coord + vert_c_coord) * (1.0f / 3);
-                    new_tex_coord[new_vert_index]  = (tex_a_coord + tex_b_coord + tex_c_coord) * (1.0f / 3);
-                    current_vert_index++;
-
-                    new_tri_indices[current_face_index++] = glm::ivec3(tri_indices[0], tri_indices[1], new_vert_index);
-                    new_tri_indices[current_face_index++] = glm::ivec3(tri_indices[1], tri_indices[2], new_vert_index);
-                    new_tri_indices[current_face_index++] = glm::ivec3(tri_indices[2], tri_indices[0], new_vert_index);
-                }
-
-                new_num_vertex = current_vert_index;
-                new_num_tri    = current_face_index;
-                mesh->resize(new_num_vertex, new_num_tri);
-                for(int k = 0; k < static_cast<int>(new_num_vertex); k++) {
-                    mesh->set_vert_coord(k, new_vert_coord[k]);
-                    mesh->set_tex_coord(k,  new_tex_coord[k]);
-                }
-                for(int t = 0; t < static_cast<int>(new_num_tri); t++) {
-                    mesh->set_tri_indices(t, new_tri_indices[t]);
+                break;
+            case TESSELLATION_TYPE_TRI_CENTER:
+                {
+                    size_t new_num_vertex = num_vertex + num_tri;
+                    size_t new_num_tri    = num_tri * 3;
+                    if(new_num_vertex > MAX_NUM_VERTEX) {
+                        std::cout << "Warning: Tessellation stopped at level " << level << ", too many vertices" << std::endl;
+                        level = levels;
+                        break;
+                    }
+                    new_vert_coord.resize(new_num_vertex);
+                    new_tex_coord.resize(new_num_vertex);
+                    new_tri_indices.resize(new_num_tri);
+                    std::copy(vert_coord.begin(), vert_coord.end(), new_vert_coord.begin());
+                    std::copy(tex_coord.begin(),  tex_coord.end(),  new_tex_coord.begin());
+                    parallel_for(num_tri, MIN_COUNT_PER_TASK, [&](int start_index, int end_index) {
+                        for(int t = start_index; t < end_index; t++) {
+                            glm::ivec3 tri = tri_indices[t];
+                            int new_vert_index = num_vertex + t;
+                            new_vert_coord[new_vert_index] = (vert_coord[tri[0]] + vert_coord[tri[1]] + vert_coord[tri[2]]) * (1.0f / 3);
+                            new_tex_coord[new_vert_index]  = (tex_coord[tri[0]]  + tex_coord[tri[1]]  + tex_coord[tri[2]])  * (1.0f / 3);
+                            new_tri_indices[t * 3 + 0] = glm::ivec3(tri[0], tri[1], new_vert_index);
+                            new_tri_indices[t * 3 + 1] = glm::ivec3(tri[1], tri[2], new_vert_index);
+                            new_tri_indices[t * 3 + 2] = glm::ivec3(tri[2], tri[0], new_vert_index);
+                        }
+                    });
+                    num_vertex = new_num_vertex;
+                    num_tri    = new_num_tri;
+                    vert_coord.swap(new_vert_coord);
+                    tex_coord.swap(new_tex_coord);
+                    tri_indices.swap(new_tri_indices);
                 }
-            }
-            break;
+                break;
+        }
     }
+    mesh->resize(num_vertex, num_tri);
+    mesh->set_vert_coords(&vert_coord[0]);
+    mesh->set_tex_coords(&tex_coord[0]);
+    mesh->set_tri_indices(&tri_indices[0]);
     if(smooth) {
         mesh->set_smooth(true);
     }
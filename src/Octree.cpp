@@ -16,6 +16,13 @@
 // along with dexvt-lite.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <Octree.h>
+#include <Util.h>
+#include <glm/glm.hpp>
+#include <vector>
+#include <map>
+#include <queue>
+#include <functional>
+#include <utility>
 #include "memory.h"
 
 namespace vt {
@@ -69,6 +76,15 @@ bool Octree::encloses(glm::vec3 pos) const
            pos.z >= min.z && pos.z < max.z;
 }
 
+bool Octree::encloses(glm::vec3 min, glm::vec3 max) const
+{
+    glm::vec3 node_min = m_origin;
+    glm::vec3 node_max = m_origin + m_dim;
+    return min.x >= node_min.x && max.x <= node_max.x &&
+           min.y >= node_min.y && max.y <= node_max.y &&
+           min.z >= node_min.z && max.z <= node_max.z;
+}
+
 const Octree* Octree::downtrace_leaf_enclosing(glm::vec3 pos) const
 {
     if(m_depth + 1 == m_max_depth) {
@@ -80,28 +96,278 @@ const Octree* Octree::downtrace_leaf_enclosing(glm::vec3 pos) const
     return m_nodes[x_index * 4 + y_index * 2 + z_index]->downtrace_leaf_enclosing(pos);
 }
 
+// deepest node that fully encloses the box (or this node if the box straddles its center)
+Octree* Octree::downtrace_node_enclosing(glm::vec3 min, glm::vec3 max)
+{
+    if(is_leaf()) {
+        return this;
+    }
+    int x_index = min.x > m_center.x;
+    int y_index = min.y > m_center.y;
+    int z_index = min.z > m_center.z;
+    if(x_index != (max.x > m_center.x) ||
+       y_index != (max.y > m_center.y) ||
+       z_index != (max.z > m_center.z))
+    {
+        return this;
+    }
+    return m_nodes[x_index * 4 + y_index * 2 + z_index]->downtrace_node_enclosing(min, max);
+}
+
 Octree* Octree::uptrace_parent_enclosing(glm::vec3 pos) const
 {
-    return NULL;
+    return uptrace_parent_enclosing(pos, pos);
+}
+
+// nearest node up the tree (starting with this node) that fully encloses the box
+Octree* Octree::uptrace_parent_enclosing(glm::vec3 min, glm::vec3 max) const
+{
+    const Octree* node = this;
+    while(node->m_parent && !node->encloses(min, max)) {
+        node = node->m_parent;
+    }
+    return const_cast<Octree*>(node);
 }
 
 bool Octree::add_object(long id, glm::vec3* pos)
 {
-    std::map<long, glm::vec3*>::iterator p = m_objects.find(id);
-    if(p != m_objects.end()) {
+    if(!pos || has_object(id)) {
+        return false;
+    }
+    object_t object;
+    object.m_pos = pos;
+    object.m_min = *pos;
+    object.m_max = *pos;
+    insert_object(id, object, this);
+    return true;
+}
+
+bool Octree::add_object(long id, glm::vec3 min, glm::vec3 max)
+{
+    if(has_object(id)) {
         return false;
     }
-    m_objects[id] = pos;
+    object_t object;
+    object.m_pos = NULL;
+    object.m_min = min;
+    object.m_max = max;
+    insert_object(id, object, this);
     return true;
 }
 
+bool Octree::update_object(long id, glm::vec3 min, glm::vec3 max)
+{
+    object_nodes_t::iterator p = m_object_nodes.find(id);
+    if(p == m_object_nodes.end()) {
+        return add_object(id, min, max);
+    }
+    Octree* node = (*p).second;
+    objects_t::iterator q = node->m_objects.find(id);
+    object_t object = (*q).second;
+    object.m_min = min;
+    object.m_max = max;
+
+    // only re-insert if object left its node, or now fits in a child node
+    Octree* start_node = node->uptrace_parent_enclosing(min, max);
+    if(start_node == node && start_node->downtrace_node_enclosing(min, max) == node) {
+        (*q).second = object;
+        return true;
+    }
+    node->m_objects.erase(q);
+    insert_object(id, object, start_node);
+    return true;
+}
+
+bool Octree::remove_object(long id)
+{
+    object_nodes_t::iterator p = m_object_nodes.find(id);
+    if(p == m_object_nodes.end()) {
+        return false;
+    }
+    (*p).second->m_objects.erase(id);
+    m_object_nodes.erase(p);
+    return true;
+}
+
+bool Octree::has_object(long id) const
+{
+    return m_object_nodes.find(id) != m_object_nodes.end();
+}
+
+void Octree::clear_objects()
+{
+    m_objects.clear();
+    m_object_nodes.clear();
+    if(is_leaf()) {
+        return;
+    }
+    for(int i = 0; i < 8; i++) {
+        m_nodes[i]->clear_objects();
+    }
+}
+
+void Octree::insert_object(long id, const object_t& object, Octree* start_node)
+{
+    // objects not enclosed by the root stay in the root
+    Octree* node = start_node;
+    if(node->encloses(object.m_min, object.m_max)) {
+        node = node->downtrace_node_enclosing(object.m_min, object.m_max);
+    }
+    node->m_objects[id] = object;
+    m_object_nodes[id] = node;
+}
+
+void Octree::collect_objects(std::vector<long>* ids) const
+{
+    for(objects_t::const_iterator p = m_objects.begin(); p != m_objects.end(); p++) {
+        ids->push_back((*p).first);
+    }
+    if(is_leaf()) {
+        return;
+    }
+    for(int i = 0; i < 8; i++) {
+        m_nodes[i]->collect_objects(ids);
+    }
+}
+
+static float box_distance2(glm::vec3 pos, glm::vec3 min, glm::vec3 max)
+{
+    glm::vec3 offset = glm::max(glm::max(min - pos, pos - max), glm::vec3(0));
+    return glm::dot(offset, offset);
+}
+
 int Octree::find_k_nearest(int k, glm::vec3 pos, std::vector<long>* k_nearest) const
 {
-    return 0;
+    if(!k_nearest || k <= 0) {
+        return 0;
+    }
+    typedef std::pair<float, const Octree*> node_entry_t;
+    typedef std::pair<float, long>          object_entry_t;
+
+    // best-first traversal: nearest node first, nearest k objects in max-heap
+    std::priority_queue<node_entry_t, std::vector<node_entry_t>, std::greater<node_entry_t> > node_queue;
+    std::priority_queue<object_entry_t> nearest;
+    node_queue.push(node_entry_t(0, this));
+    while(!node_queue.empty()) {
+        node_entry_t node_entry = node_queue.top();
+        node_queue.pop();
+        if(static_cast<int>(nearest.size()) == k && node_entry.first > nearest.top().first) {
+            break;
+        }
+        const Octree* node = node_entry.second;
+        for(objects_t::const_iterator p = node->m_objects.begin(); p != node->m_objects.end(); p++) {
+            float distance2 = box_distance2(pos, (*p).second.m_min, (*p).second.m_max);
+            if(static_cast<int>(nearest.size()) < k) {
+                nearest.push(object_entry_t(distance2, (*p).first));
+            } else if(distance2 < nearest.top().first) {
+                nearest.pop();
+                nearest.push(object_entry_t(distance2, (*p).first));
+            }
+        }
+        if(node->is_leaf()) {
+            continue;
+        }
+        for(int i = 0; i < 8; i++) {
+            const Octree* child_node = node->m_nodes[i];
+            float distance2 = box_distance2(pos, child_node->m_origin, child_node->m_origin + child_node->m_dim);
+            if(static_cast<int>(nearest.size()) == k && distance2 > nearest.top().first) {
+                continue;
+            }
+            node_queue.push(node_entry_t(distance2, child_node));
+        }
+    }
+    int n = nearest.size();
+    size_t offset = k_nearest->size();
+    k_nearest->resize(offset + n);
+    for(int j = n - 1; j >= 0; j--) {
+        (*k_nearest)[offset + j] = nearest.top().second;
+        nearest.pop();
+    }
+    return n;
+}
+
+int Octree::find_within_radius(glm::vec3 pos, float radius, std::vector<long>* ids) const
+{
+    if(!ids) {
+        return 0;
+    }
+    float radius2 = radius * radius;
+    int n = 0;
+    std::vector<const Octree*> node_stack;
+    node_stack.push_back(this);
+    while(!node_stack.empty()) {
+        const Octree* node = node_stack.back();
+        node_stack.pop_back();
+        for(objects_t::const_iterator p = node->m_objects.begin(); p != node->m_objects.end(); p++) {
+            if(box_distance2(pos, (*p).second.m_min, (*p).second.m_max) <= radius2) {
+                ids->push_back((*p).first);
+                n++;
+            }
+        }
+        if(node->is_leaf()) {
+            continue;
+        }
+        for(int i = 0; i < 8; i++) {
+            const Octree* child_node = node->m_nodes[i];
+            if(box_distance2(pos, child_node->m_origin, child_node->m_origin + child_node->m_dim) <= radius2) {
+                node_stack.push_back(child_node);
+            }
+        }
+    }
+    return n;
+}
+
+int Octree::find_in_frustum(glm::mat4 view_proj_transform, std::vector<long>* ids) const
+{
+    if(!ids) {
+        return 0;
+    }
+    glm::vec4 planes[6];
+    extract_frustum_planes(view_proj_transform, planes);
+    size_t prev_size = ids->size();
+    find_in_frustum_impl(planes, ids);
+    return ids->size() - prev_size;
+}
+
+void Octree::find_in_frustum_impl(const glm::vec4* planes, std::vector<long>* ids) const
+{
+    // the root also holds objects that stick out of it, so never cull it as a whole
+    if(m_parent) {
+        frustum_test_t node_test = frustum_test_aabb(planes, m_origin, m_origin + m_dim);
+        if(node_test == FRUSTUM_OUTSIDE) {
+            return;
+        }
+        if(node_test == FRUSTUM_INSIDE) {
+            collect_objects(ids);
+            return;
+        }
+    }
+    for(objects_t::const_iterator p = m_objects.begin(); p != m_objects.end(); p++) {
+        if(frustum_test_aabb(planes, (*p).second.m_min, (*p).second.m_max) != FRUSTUM_OUTSIDE) {
+            ids->push_back((*p).first);
+        }
+    }
+    if(is_leaf()) {
+        return;
+    }
+    for(int i = 0; i < 8; i++) {
+        m_nodes[i]->find_in_frustum_impl(planes, ids);
+    }
 }
 
-void Octree::Octree::update()
+// re-insert point objects whose tracked position has moved
+void Octree::update()
 {
+    std::vector<std::pair<long, glm::vec3> > moved;
+    for(object_nodes_t::iterator p = m_object_nodes.begin(); p != m_object_nodes.end(); p++) {
+        const object_t& object = (*p).second->m_objects[(*p).first];
+        if(object.m_pos && *object.m_pos != object.m_min) {
+            moved.push_back(std::make_pair((*p).first, *object.m_pos));
+        }
+    }
+    for(std::vector<std::pair<long, glm::vec3> >::iterator q = moved.begin(); q != moved.end(); q++) {
+        update_object((*q).first, (*q).second, (*q).second);
+    }
 }
 
 }
@@ -67,6 +67,10 @@ Program::var_uniform_type_to_name_table_t Program::m_var_uniform_type_to_name_ta
         {Program::var_uniform_type_normal_transform,                "normal_transform"},
         {Program::var_uniform_type_random_texture,                  "random_texture"},
         {Program::var_uniform_type_reflect_to_refract_ratio,        "reflect_to_refract_ratio"},
+        {Program::var_uniform_type_ripple_amplitude,                "ripple_amplitude"},
+        {Program::var_uniform_type_ripple_origin,                   "ripple_origin"},
+        {Program::var_uniform_type_ripple_phase,                    "ripple_phase"},
+        {Program::var_uniform_type_ripple_wavelength,               "ripple_wavelength"},
         {Program::var_uniform_type_ssao_sample_kernel_pos,          "ssao_sample_kernel_pos"},
         {Program::var_uniform_type_viewport_dim,                    "viewport_dim"},
         {Program::var_uniform_type_view_proj_transform,             "view_proj_transform"},
@@ -69,7 +69,10 @@ Scene::Scene()
       m_overlay(NULL),
       m_normal_material(NULL),
       m_wireframe_material(NULL),
-      m_ssao_material(NULL)
+      m_ssao_material(NULL),
+      m_frustum_culling(true),
+      m_num_culled_meshes(0),
+      m_num_drawn_meshes(0)
 {
     //const int bloom_kernel_row[BLOOM_KERNEL_SIZE] = {1, 4, 6, 4, 1};
     const int bloom_kernel_row[BLOOM_KERNEL_SIZE] = {1, 6, 15, 20, 15, 6, 1};
@@ -150,6 +153,9 @@ void Scene::reset()
     m_camera = NULL;
     m_lights.clear();
     m_meshes.clear();
+    if(m_oct_tree) {
+        m_oct_tree->clear_objects();
+    }
     m_materials.clear();
     m_textures.clear();
 }
@@ -200,6 +206,10 @@ void Scene::remove_mesh(Mesh* mesh)
     (*p)->link_parent(NULL);
     (*p)->unlink_children();
     m_meshes.erase(p);
+    if(m_oct_tree) {
+        // mesh indices have shifted
+        m_oct_tree->clear_objects();
+    }
 }
 
 Material* Scene::find_material(std::string name)
@@ -344,11 +354,38 @@ void Scene::render(bool                clear_canvas,
     if(frame_buffer) {
         texture = frame_buffer->get_texture();
     }
+    glm::mat4 vp_transform = m_camera->get_projection_transform()*m_camera->get_transform();
+    if(m_frustum_culling && m_oct_tree) {
+        update_oct_tree();
+        m_oct_tree_query_ids.clear();
+        m_oct_tree->find_in_frustum(vp_transform, &m_oct_tree_query_ids);
+        m_mesh_in_frustum.assign(m_meshes.size(), false);
+        for(std::vector<long>::const_iterator r = m_oct_tree_query_ids.begin(); r != m_oct_tree_query_ids.end(); r++) {
+            m_mesh_in_frustum[*r] = true;
+        }
+    } else if(m_frustum_culling) {
+        extract_frustum_planes_soa(vp_transform, m_frustum_planes_soa);
+    }
+    m_num_culled_meshes = 0;
+    m_num_drawn_meshes  = 0;
     for(meshes_t::const_iterator q = m_meshes.begin(); q != m_meshes.end(); q++) {
         Mesh* mesh = (*q);
         if(!mesh->is_visible()) {
             continue;
         }
+        if(m_frustum_culling && m_oct_tree) {
+            if(!m_mesh_in_frustum[q - m_meshes.begin()]) {
+                m_num_culled_meshes++;
+                continue;
+            }
+        } else if(m_frustum_culling) {
+            glm::vec3 world_center, world_extent;
+            mesh->get_world_center_extent(&world_center, &world_extent);
+            if(!frustum_test_center_extent(m_frustum_planes_soa, world_center, world_extent)) {
+                m_num_culled_meshes++;
+                continue;
+            }
+        }
         ShaderContext* shader_context = NULL;
         switch(use_material_type) {
             case use_material_type_t::USE_MESH_MATERIAL:
@@ -376,7 +413,6 @@ void Scene::render(bool                clear_canvas,
             continue;
         }
         program->use();
-        glm::mat4 vp_transform = m_camera->get_projection_transform()*m_camera->get_transform();
         if(program->has_var(Program::VAR_TYPE_UNIFORM, Program::var_uniform_type_ambient_color)) {
             shader_context->set_ambient_color(glm::value_ptr(mesh->get_ambient_color()));
         }
@@ -455,6 +491,18 @@ void Scene::render(bool                clear_canvas,
         if(program->has_var(Program::VAR_TYPE_UNIFORM, Program::var_uniform_type_reflect_to_refract_ratio)) {
             shader_context->set_reflect_to_refract_ratio(mesh->get_reflect_to_refract_ratio());
         }
+        if(program->has_var(Program::VAR_TYPE_UNIFORM, Program::var_uniform_type_ripple_amplitude)) {
+            shader_context->set_ripple_amplitude(mesh->get_ripple_amplitude());
+        }
+        if(program->has_var(Program::VAR_TYPE_UNIFORM, Program::var_uniform_type_ripple_origin)) {
+            shader_context->set_ripple_origin(glm::value_ptr(mesh->get_ripple_origin()));
+        }
+        if(program->has_var(Program::VAR_TYPE_UNIFORM, Program::var_uniform_type_ripple_phase)) {
+            shader_context->set_ripple_phase(mesh->get_ripple_phase());
+        }
+        if(program->has_var(Program::VAR_TYPE_UNIFORM, Program::var_uniform_type_ripple_wavelength)) {
+            shader_context->set_ripple_wavelength(mesh->get_ripple_wavelength());
+        }
         if(program->has_var(Program::VAR_TYPE_UNIFORM, Program::var_uniform_type_ssao_sample_kernel_pos)) {
             shader_context->set_ssao_sample_kernel_pos(NUM_SSAO_SAMPLE_KERNELS, m_ssao_sample_kernel_pos);
         }
@@ -478,6 +526,7 @@ void Scene::render(bool                clear_canvas,
             }
         }
         shader_context->render();
+        m_num_drawn_meshes++;
     }
 }
 
@@ -541,6 +590,18 @@ void Scene::render_oct_tree(Octree* node, glm::mat4 camera_transform) const
     }
 }
 
+void Scene::update_oct_tree()
+{
+    if(!m_oct_tree) {
+        return;
+    }
+    for(int i = 0; i < static_cast<int>(m_meshes.size()); i++) {
+        glm::vec3 world_min, world_max;
+        m_meshes[i]->get_world_min_max(&world_min, &world_max);
+        m_oct_tree->update_object(i, world_min, world_max);
+    }
+}
+
 void Scene::render_lines_and_text(bool  draw_guide_wires,
                                   bool  draw_paths,
                                   bool  draw_axis,
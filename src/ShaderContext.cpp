@@ -273,6 +273,26 @@ void ShaderContext::set_reflect_to_refract_ratio(GLfloat reflect_to_refract_rati
     m_var_uniforms[Program::var_uniform_type_reflect_to_refract_ratio]->uniform_1f(reflect_to_refract_ratio);
 }
 
+void ShaderContext::set_ripple_amplitude(GLfloat ripple_amplitude)
+{
+    m_var_uniforms[Program::var_uniform_type_ripple_amplitude]->uniform_1f(ripple_amplitude);
+}
+
+void ShaderContext::set_ripple_origin(const float* ripple_origin_arr)
+{
+    m_var_uniforms[Program::var_uniform_type_ripple_origin]->uniform_3fv(1, ripple_origin_arr);
+}
+
+void ShaderContext::set_ripple_phase(GLfloat ripple_phase)
+{
+    m_var_uniforms[Program::var_uniform_type_ripple_phase]->uniform_1f(ripple_phase);
+}
+
+void ShaderContext::set_ripple_wavelength(GLfloat ripple_wavelength)
+{
+    m_var_uniforms[Program::var_uniform_type_ripple_wavelength]->uniform_1f(ripple_wavelength);
+}
+
 void ShaderContext::set_ssao_sample_kernel_pos(size_t num_kernels, const float* kernel_pos_arr)
 {
     m_var_uniforms[Program::var_uniform_type_ssao_sample_kernel_pos]->uniform_3fv(num_kernels, kernel_pos_arr);
@@ -21,11 +21,19 @@
 #include <Util.h>
 #include <GL/glew.h>
 #include <glm/glm.hpp>
+#include <gli/load.hpp>
+#include <gli/texture2d.hpp>
+#include <gli/gl.hpp>
+#include <gli/core/flip.hpp>
 #include <string>
 #include <iostream>
+#include <vector>
+#include <algorithm>
 #include <memory.h>
 #include <unistd.h>
 
+#define MIN_MIPMAP_ROW_COUNT_PER_TASK 64
+
 namespace vt {
 
 Texture::Texture(std::string          name,
@@ -33,10 +41,12 @@ Texture::Texture(std::string          name,
                  glm::ivec2           dim,
                  bool                 smooth,
                  format_t             format,
-                 const unsigned char* pixels)
+                 const unsigned char* pixels,
+                 bool                 trilinear)
     : NamedObject(name),
       FrameObject(glm::ivec2(0), dim),
       m_skybox(false),
+      m_trilinear(trilinear),
       m_internal_format(internal_format),
       m_pixels(NULL),
       m_pixels_pos_x(NULL),
@@ -78,11 +88,13 @@ Texture::Texture(std::string          name,
 }
 
 Texture::Texture(std::string name,
-                 std::string png_filename,
-                 bool        smooth)
+                 std::string image_filename,
+                 bool        smooth,
+                 bool        trilinear)
     : NamedObject(name),
       FrameObject(glm::ivec2(0), glm::ivec2(0)),
       m_skybox(false),
+      m_trilinear(trilinear),
       m_internal_format(Texture::RGBA),
       m_pixels(NULL),
       m_pixels_pos_x(NULL),
@@ -92,10 +104,14 @@ Texture::Texture(std::string name,
       m_pixels_pos_z(NULL),
       m_pixels_neg_z(NULL)
 {
+    std::string ext = get_file_extension(image_filename);
+    if((ext == "dds" || ext == "ktx") && alloc_compressed(image_filename, smooth)) {
+        return;
+    }
     unsigned char* pixels = NULL;
     size_t width  = 0;
     size_t height = 0;
-    if(!read_png(png_filename, (void**)&pixels, &width, &height) || !pixels) {
+    if(!read_image(image_filename, (void**)&pixels, &width, &height) || !pixels) {
         return;
     }
     alloc(Texture::RGBA,
@@ -118,6 +134,7 @@ Texture::Texture(std::string name,
     : NamedObject(name),
       FrameObject(glm::ivec2(0), glm::ivec2(0)),
       m_skybox(true),
+      m_trilinear(false),
       m_internal_format(Texture::RGBA),
       m_pixels(NULL),
       m_pixels_pos_x(NULL),
@@ -153,27 +170,27 @@ Texture::Texture(std::string name,
     unsigned char* pixels_neg_y = NULL;
     unsigned char* pixels_pos_z = NULL;
     unsigned char* pixels_neg_z = NULL;
-    if(!read_png(png_filename_pos_x, (void**)&pixels_pos_x, &width, &height) || !pixels_pos_x) {
+    if(!read_image(png_filename_pos_x, (void**)&pixels_pos_x, &width, &height) || !pixels_pos_x) {
         std::cout << "failed to load cube map positive x" << std::endl;
         return;
     }
-    if(!read_png(png_filename_neg_x, (void**)&pixels_neg_x, &width, &height) || !pixels_neg_x) {
+    if(!read_image(png_filename_neg_x, (void**)&pixels_neg_x, &width, &height) || !pixels_neg_x) {
         std::cout << "failed to load cube map negative x" << std::endl;
         return;
     }
-    if(!read_png(png_filename_pos_y, (void**)&pixels_pos_y, &width, &height) || !pixels_pos_y) {
+    if(!read_image(png_filename_pos_y, (void**)&pixels_pos_y, &width, &height) || !pixels_pos_y) {
         std::cout << "failed to load cube map positive y" << std::endl;
         return;
     }
-    if(!read_png(png_filename_neg_y, (void**)&pixels_neg_y, &width, &height) || !pixels_neg_y) {
+    if(!read_image(png_filename_neg_y, (void**)&pixels_neg_y, &width, &height) || !pixels_neg_y) {
         std::cout << "failed to load cube map negative y" << std::endl;
         return;
     }
-    if(!read_png(png_filename_pos_z, (void**)&pixels_pos_z, &width, &height) || !pixels_pos_z) {
+    if(!read_image(png_filename_pos_z, (void**)&pixels_pos_z, &width, &height) || !pixels_pos_z) {
         std::cout << "failed to load cube map positive z" << std::endl;
         return;
     }
-    if(!read_png(png_filename_neg_z, (void**)&pixels_neg_z, &width, &height) || !pixels_neg_z) {
+    if(!read_image(png_filename_neg_z, (void**)&pixels_neg_z, &width, &height) || !pixels_neg_z) {
         std::cout << "failed to load cube map negative z" << std::endl;
         return;
     }
@@ -248,7 +265,7 @@ void Texture::alloc(format_t    internal_format,
         return;
     }
     glBindTexture(GL_TEXTURE_2D, m_id);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, m_trilinear ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, smooth ? GL_LINEAR : GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
@@ -324,6 +341,107 @@ void Texture::alloc(glm::ivec2  dim,
     update();
 }
 
+// uploads pre-compressed blocks (and any mip levels in the file) as-is, returns false if gpu lacks the format
+bool Texture::alloc_compressed(std::string image_filename, bool smooth)
+{
+    gli::texture2d texture(gli::load(image_filename));
+    if(texture.empty() || !gli::is_compressed(texture.format())) {
+        return false;
+    }
+    if(is_s3tc_format(texture.format())) {
+        if(!GLEW_EXT_texture_compression_s3tc) {
+            return false;
+        }
+        if(get_file_extension(image_filename) == "dds") {
+            texture = gli::flip(texture); // dds rows are top-down
+        }
+    } else if(!GLEW_ARB_ES3_compatibility || // etc2/eac
+              texture.format() < gli::FORMAT_RGB_ETC2_UNORM_BLOCK8 ||
+              texture.format() > gli::FORMAT_RG_EAC_SNORM_BLOCK16 ||
+              get_file_extension(image_filename) != "ktx")
+    {
+        return false;
+    }
+    gli::gl gl(gli::gl::PROFILE_GL33);
+    gli::gl::format gl_format = gl.translate(texture.format(), texture.swizzles());
+    glGenTextures(1, &m_id);
+    if(!m_id) {
+        return false;
+    }
+    int num_levels = texture.levels();
+    glBindTexture(GL_TEXTURE_2D, m_id);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, (m_trilinear && num_levels > 1) ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, smooth ? GL_LINEAR : GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, num_levels - 1);
+    for(int level = 0; level < num_levels; level++) {
+        gli::extent2d extent = texture.extent(level);
+        glCompressedTexImage2D(GL_TEXTURE_2D,            // target
+                               level,                    // level
+                               gl_format.Internal,       // internal format
+                               extent.x,                 // width
+                               extent.y,                 // height
+                               0,                        // border, always 0 in OpenGL ES
+                               texture.size(level),      // image size
+                               texture[level].data());
+    }
+    m_dim             = glm::ivec2(texture.extent().x, texture.extent().y);
+    m_skybox          = false;
+    m_internal_format = Texture::RGBA;
+    m_trilinear       = (m_trilinear && num_levels > 1);
+    return true; // NOTE: m_pixels stays NULL, no cpu copy of compressed textures
+}
+
+// NOTE: texture must be bound and level 0 uploaded
+void Texture::update_mipmaps()
+{
+    if(m_internal_format != Texture::RGBA || !m_pixels) {
+        return;
+    }
+    if(GLEW_VERSION_3_0 || GLEW_ARB_framebuffer_object) {
+        glGenerateMipmap(GL_TEXTURE_2D);
+        return;
+    }
+
+    // fallback: 2x2 box filter on cpu, rows in parallel
+    std::vector<unsigned char> levels[2];
+    const unsigned char* src = m_pixels;
+    glm::ivec2 src_dim = m_dim;
+    for(int level = 1; src_dim.x > 1 || src_dim.y > 1; level++) {
+        glm::ivec2 dest_dim = glm::max(src_dim / 2, glm::ivec2(1));
+        std::vector<unsigned char> &dest_level = levels[level % 2];
+        dest_level.resize(dest_dim.x * dest_dim.y * 4);
+        unsigned char* dest = &dest_level[0];
+        parallel_for(dest_dim.y, MIN_MIPMAP_ROW_COUNT_PER_TASK, [src, src_dim, dest, dest_dim](int start_row, int end_row) {
+            for(int y = start_row; y < end_row; y++) {
+                const unsigned char* src_row0 = &src[std::min(y * 2,     src_dim.y - 1) * src_dim.x * 4];
+                const unsigned char* src_row1 = &src[std::min(y * 2 + 1, src_dim.y - 1) * src_dim.x * 4];
+                unsigned char*       dest_row = &dest[y * dest_dim.x * 4];
+                for(int x = 0; x < dest_dim.x; x++) {
+                    int src_offset0 = std::min(x * 2,     src_dim.x - 1) * 4;
+                    int src_offset1 = std::min(x * 2 + 1, src_dim.x - 1) * 4;
+                    for(int c = 0; c < 4; c++) {
+                        dest_row[x * 4 + c] = (src_row0[src_offset0 + c] + src_row0[src_offset1 + c] +
+                                               src_row1[src_offset0 + c] + src_row1[src_offset1 + c] + 2) >> 2;
+                    }
+                }
+            }
+        });
+        glTexImage2D(GL_TEXTURE_2D,    // target
+                     level,            // level
+                     GL_RGBA,          // internal format
+                     dest_dim.x,       // width
+                     dest_dim.y,       // height
+                     0,                // border, always 0 in OpenGL ES
+                     GL_RGBA,          // format
+                     GL_UNSIGNED_BYTE, // type
+                     dest);
+        src     = dest;
+        src_dim = dest_dim;
+    }
+}
+
 size_t Texture::size() const
 {
     if(m_skybox) {
@@ -585,6 +703,22 @@ void Texture::set_color_r32f(float color)
 // core functionality
 //===================
 
+void Texture::set_trilinear(bool trilinear)
+{
+    if(m_skybox || !m_pixels || trilinear == m_trilinear) {
+        return;
+    }
+    m_trilinear = trilinear;
+    if(!m_id) {
+        return;
+    }
+    bind();
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, m_trilinear ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+    if(m_trilinear) {
+        update_mipmaps();
+    }
+}
+
 // NOTE: upload to gpu
 void Texture::update()
 {
@@ -669,6 +803,9 @@ void Texture::update()
                          GL_RGBA,          // format
                          GL_UNSIGNED_BYTE, // type
                          m_pixels);
+            if(m_trilinear) {
+                update_mipmaps();
+            }
             break;
         case Texture::RGB:
             assert(false);
@@ -42,7 +42,9 @@ TransformObject::TransformObject(std::string name,
       m_joint_constraints_max_deviation(glm::vec3(0)),
       m_hinge_type(EULER_INDEX_UNDEF),
       m_is_dirty_transform(true),
-      m_is_dirty_normal_transform(true)
+      m_generation(0),
+      m_parent_generation(0),
+      m_normal_transform_generation(0)
 {
 }
 
@@ -528,45 +530,53 @@ void TransformObject::update_boid(glm::vec3 target,
 // core functionality
 //===================
 
-const glm::mat4 &TransformObject::get_transform(bool trace_down)
+// only the leaf-to-root lineage is validated; a node is recomputed if its local
+// components changed or its parent was recomputed since it was last computed
+const glm::mat4 &TransformObject::get_transform()
 {
-    if(trace_down) {
-        update_transform_hier();
-        return m_transform;
+    unsigned long parent_generation = 0;
+    if(m_parent) {
+        m_parent->get_transform();
+        parent_generation = m_parent->m_generation;
     }
-    if(m_is_dirty_transform) {
+    if(m_is_dirty_transform || m_parent_generation != parent_generation) {
         update_transform();
         if(m_parent) {
-            m_transform = m_parent->get_transform(false) * m_transform;
+            m_transform = m_parent->m_transform * m_transform;
         }
         m_is_dirty_transform = false;
+        m_parent_generation  = parent_generation;
+        m_generation         = next_generation();
     }
     return m_transform;
 }
 
 const glm::mat4 &TransformObject::get_normal_transform()
 {
-    if(m_is_dirty_normal_transform) {
+    get_transform();
+    if(m_normal_transform_generation != m_generation) {
         update_normal_transform();
-        m_is_dirty_normal_transform = false;
+        m_normal_transform_generation = m_generation;
     }
     return m_normal_transform;
 }
 
+unsigned long TransformObject::get_transform_generation()
+{
+    get_transform();
+    return m_generation;
+}
+
 glm::mat4 TransformObject::get_local_rotation_transform() const
 {
     return GLM_EULER_TRANSFORM(EULER_YAW(m_euler), EULER_PITCH(m_euler), EULER_ROLL(m_euler));
 }
 
-void TransformObject::update_transform_hier()
+// generations are unique across all objects, so a stale parent generation never matches by accident
+unsigned long TransformObject::next_generation()
 {
-    for(std::set<TransformObject*>::iterator p = m_children.begin(); p != m_children.end(); p++) {
-        (*p)->mark_dirty_transform(); // mark entire subtree dirty
-        (*p)->update_transform_hier();
-    }
-    if(m_children.empty()) {
-        get_transform(false); // update entire leaf-to-root lineage for all leaf nodes
-    }
+    static unsigned long generation = 0;
+    return ++generation;
 }
 
 void TransformObject::update_normal_transform()
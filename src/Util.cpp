@@ -23,12 +23,22 @@
 #include <vector>
 #include <string>
 #include <iostream>
+#include <functional>
+#include <future>
+#include <thread>
+#include <algorithm>
 #include <regex.h>
 #include <math.h>
 #include <stdarg.h>
 #include <GL/glut.h>
-#include <png.h>
+#include <gli/load.hpp>
+#include <gli/texture2d.hpp>
 #include <memory.h>
+#include <ctype.h>
+#include <stdint.h>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
 
 namespace vt {
 
@@ -165,6 +175,95 @@ glm::vec3 nearest_point_on_plane(glm::vec3 plane_origin, glm::vec3 plane_normal,
     return point - plane_normal * (glm::dot(point, plane_normal) - glm::dot(plane_origin, plane_normal));
 }
 
+// http://www8.cs.umu.se/kurser/5DV051/HT12/lab/plane_extraction.pdf
+void extract_frustum_planes(glm::mat4  view_proj_transform,
+                            glm::vec4* planes)
+{
+    if(!planes) {
+        return;
+    }
+    glm::vec4 row[4];
+    for(int i = 0; i < 4; i++) {
+        row[i] = glm::vec4(view_proj_transform[0][i],
+                           view_proj_transform[1][i],
+                           view_proj_transform[2][i],
+                           view_proj_transform[3][i]);
+    }
+    planes[0] = row[3] + row[0]; // left
+    planes[1] = row[3] - row[0]; // right
+    planes[2] = row[3] + row[1]; // bottom
+    planes[3] = row[3] - row[1]; // top
+    planes[4] = row[3] + row[2]; // near
+    planes[5] = row[3] - row[2]; // far
+    for(int j = 0; j < 6; j++) {
+        planes[j] /= glm::length(glm::vec3(planes[j]));
+    }
+}
+
+frustum_test_t frustum_test_aabb(const glm::vec4* planes, glm::vec3 min, glm::vec3 max)
+{
+    frustum_test_t result = FRUSTUM_INSIDE;
+    for(int i = 0; i < 6; i++) {
+        glm::vec3 normal(planes[i]);
+
+        // corner furthest along plane normal
+        glm::vec3 p_vertex(normal.x >= 0 ? max.x : min.x,
+                           normal.y >= 0 ? max.y : min.y,
+                           normal.z >= 0 ? max.z : min.z);
+        if(glm::dot(normal, p_vertex) + planes[i].w < 0) {
+            return FRUSTUM_OUTSIDE;
+        }
+
+        // corner furthest against plane normal
+        glm::vec3 n_vertex(normal.x >= 0 ? min.x : max.x,
+                           normal.y >= 0 ? min.y : max.y,
+                           normal.z >= 0 ? min.z : max.z);
+        if(glm::dot(normal, n_vertex) + planes[i].w < 0) {
+            result = FRUSTUM_INTERSECT;
+        }
+    }
+    return result;
+}
+
+// planes stored as two groups of four, each group transposed into x, y, z and w
+// vectors so a box is tested against four planes per vector operation
+void extract_frustum_planes_soa(glm::mat4  view_proj_transform,
+                                glm::vec4* planes_soa)
+{
+    if(!planes_soa) {
+        return;
+    }
+    glm::vec4 planes[8];
+    extract_frustum_planes(view_proj_transform, planes);
+    planes[6] = planes[7] = planes[5]; // pad with a duplicate plane
+    for(int i = 0; i < 2; i++) {
+        for(int j = 0; j < 4; j++) {
+            planes_soa[i * 4 + j] = glm::vec4(planes[i * 4 + 0][j],
+                                              planes[i * 4 + 1][j],
+                                              planes[i * 4 + 2][j],
+                                              planes[i * 4 + 3][j]);
+        }
+    }
+}
+
+// https://fgiesen.wordpress.com/2010/10/17/view-frustum-culling/
+bool frustum_test_center_extent(const glm::vec4* planes_soa, glm::vec3 center, glm::vec3 extent)
+{
+    for(int i = 0; i < 8; i += 4) {
+        glm::vec4 dist = planes_soa[i + 0] * center.x +
+                         planes_soa[i + 1] * center.y +
+                         planes_soa[i + 2] * center.z +
+                         planes_soa[i + 3];
+        glm::vec4 radius = glm::abs(planes_soa[i + 0]) * extent.x +
+                           glm::abs(planes_soa[i + 1]) * extent.y +
+                           glm::abs(planes_soa[i + 2]) * extent.z;
+        if(glm::any(glm::lessThan(dist + radius, glm::vec4(0)))) {
+            return false;
+        }
+    }
+    return true;
+}
+
 // https://en.wikipedia.org/wiki/Bernstein_polynomial
 glm::vec3 bezier_interpolate(glm::vec3 p1, glm::vec3 p2, glm::vec3 p3, glm::vec3 p4, float alpha)
 {
@@ -175,6 +274,63 @@ glm::vec3 bezier_interpolate(glm::vec3 p1, glm::vec3 p2, glm::vec3 p3, glm::vec3
     return (p1 * w1) + (p2 * w2) + (p3 * w3) + (p4 * w4);
 }
 
+// https://www.drdobbs.com/forward-difference-calculation-of-bezier/184403417
+void bezier_interpolate_n(glm::vec3  p1,
+                          glm::vec3  p2,
+                          glm::vec3  p3,
+                          glm::vec3  p4,
+                          float      start_alpha,
+                          float      alpha_step,
+                          int        n,
+                          glm::vec3* values)
+{
+    if(!values || n <= 0) {
+        return;
+    }
+
+    // power basis: a*t^3 + b*t^2 + c*t + d
+    glm::vec3 a = -p1 + (p2 - p3) * 3.0f + p4;
+    glm::vec3 b = (p1 - p2 * 2.0f + p3) * 3.0f;
+    glm::vec3 c = (p2 - p1) * 3.0f;
+    glm::vec3 d = p1;
+
+    float t  = start_alpha;
+    float h  = alpha_step;
+    float h2 = h * h;
+    float h3 = h2 * h;
+    glm::vec3 value = ((a * t + b) * t + c) * t + d;
+    glm::vec3 delta1 = a * (3 * t * t * h + 3 * t * h2 + h3) + b * (2 * t * h + h2) + c * h;
+    glm::vec3 delta2 = a * (6 * t * h2 + 6 * h3) + b * (2 * h2);
+    glm::vec3 delta3 = a * (6 * h3);
+    for(int i = 0; i < n; i++) {
+        values[i] = value;
+        value  += delta1;
+        delta1 += delta2;
+        delta2 += delta3;
+    }
+}
+
+// calls func(start, end) on disjoint ranges covering [0, count), one task per hardware thread
+void parallel_for(int count, int min_count_per_task, std::function<void(int, int)> func)
+{
+    int num_tasks = std::min(static_cast<int>(std::thread::hardware_concurrency()), count / std::max(min_count_per_task, 1));
+    if(num_tasks <= 1) {
+        if(count > 0) {
+            func(0, count);
+        }
+        return;
+    }
+    int chunk_size = (count + num_tasks - 1) / num_tasks;
+    std::vector<std::future<void>> futures;
+    for(int start = chunk_size; start < count; start += chunk_size) {
+        futures.push_back(std::async(std::launch::async, func, start, std::min(start + chunk_size, count)));
+    }
+    func(0, chunk_size); // first range on calling thread
+    for(std::vector<std::future<void>>::iterator p = futures.begin(); p != futures.end(); p++) {
+        (*p).wait();
+    }
+}
+
 bool read_file(std::string filename, std::string &s)
 {
     FILE* file = fopen(filename.c_str(), "rb");
@@ -262,185 +418,261 @@ bool regexp(std::string &s, std::string pattern, int nmatch, ...)
     return regexp(s, pattern, args);
 }
 
-bool read_png(std::string png_filename,
-              void**      pixel_data,
-              size_t*     width,
-              size_t*     height)
+// copies decoded rows into RGBA, flipping top-down sources to bottom row first (as glTexImage2D expects)
+static void copy_pixels_to_rgba(const unsigned char* src,
+                                int                  num_components,
+                                bool                 swap_red_blue,
+                                bool                 flip_rows,
+                                int                  width,
+                                int                  height,
+                                unsigned char*       dest)
 {
-    if(!pixel_data || !width || !height) {
-        return false;
-    }
-    unsigned char* src_pixel_data = NULL;
-    size_t src_width  = 0;
-    size_t src_height = 0;
-    int color_type = 0;
-    if(!read_png_impl(png_filename,
-                      reinterpret_cast<void**>(&src_pixel_data),
-                      &src_width,
-                      &src_height,
-                      &color_type) || !src_pixel_data)
-    {
-        return false;
-    }
-    unsigned char* dest_pixel_data = NULL;
-    size_t size_buf = src_width * src_height * sizeof(unsigned char) * 4;
-    dest_pixel_data = new unsigned char[size_buf];
-    if(!dest_pixel_data) {
-        return false;
+    int red_offset  = swap_red_blue ? 2 : 0;
+    int blue_offset = swap_red_blue ? 0 : 2;
+    for(int y = 0; y < height; y++) {
+        const unsigned char* src_row  = &src[(flip_rows ? (height - 1 - y) : y) * width * num_components];
+        unsigned char*       dest_row = &dest[y * width * 4];
+        if(num_components == 4 && !swap_red_blue) {
+            memcpy(dest_row, src_row, width * 4);
+            continue;
+        }
+        // fixed-stride swizzle, vectorizable
+        for(int x = 0; x < width; x++) {
+            dest_row[x * 4 + 0] = src_row[x * num_components + red_offset];
+            dest_row[x * 4 + 1] = src_row[x * num_components + 1];
+            dest_row[x * 4 + 2] = src_row[x * num_components + blue_offset];
+            dest_row[x * 4 + 3] = (num_components == 4) ? src_row[x * num_components + 3] : 255;
+        }
     }
-    switch(color_type) {
-        case PNG_COLOR_MASK_COLOR:
-            for(int y = 0; y < static_cast<int>(src_height); y++) {
-                for(int x = 0; x < static_cast<int>(src_width); x++) {
-                    int src_pixel_offset_scanline_start  = (y * src_width + x) * 3;
-                    int dest_pixel_offset_scanline_start = (y * src_width + x) * 4;
-                    dest_pixel_data[dest_pixel_offset_scanline_start + 0] = src_pixel_data[src_pixel_offset_scanline_start + 0];
-                    dest_pixel_data[dest_pixel_offset_scanline_start + 1] = src_pixel_data[src_pixel_offset_scanline_start + 1];
-                    dest_pixel_data[dest_pixel_offset_scanline_start + 2] = src_pixel_data[src_pixel_offset_scanline_start + 2];
-                    dest_pixel_data[dest_pixel_offset_scanline_start + 3] = 1;
-                }
+}
+
+static glm::ivec3 unpack_rgb565(uint16_t color)
+{
+    return glm::ivec3(((color >> 11) & 0x1F) * 255 / 31,
+                      ((color >> 5)  & 0x3F) * 255 / 63,
+                      ( color        & 0x1F) * 255 / 31);
+}
+
+// decodes one 4x4 DXT1/DXT3/DXT5 block into a top-down RGBA image, clipped at image edges
+static void decode_s3tc_block(const unsigned char* block,
+                              gli::format          format,
+                              int                  block_x,
+                              int                  block_y,
+                              int                  width,
+                              int                  height,
+                              unsigned char*       dest)
+{
+    bool is_dxt1 = (format == gli::FORMAT_RGB_DXT1_UNORM_BLOCK8 || format == gli::FORMAT_RGBA_DXT1_UNORM_BLOCK8);
+    bool is_dxt3 = (format == gli::FORMAT_RGBA_DXT3_UNORM_BLOCK16);
+    unsigned char alphas[16];
+    memset(alphas, 255, sizeof(alphas));
+    if(is_dxt3) {
+        for(int i = 0; i < 16; i++) {
+            alphas[i] = ((block[i / 2] >> ((i % 2) * 4)) & 0xF) * 17;
+        }
+        block += 8;
+    } else if(!is_dxt1) {
+        int alpha_table[8];
+        alpha_table[0] = block[0];
+        alpha_table[1] = block[1];
+        if(alpha_table[0] > alpha_table[1]) {
+            for(int i = 1; i < 7; i++) {
+                alpha_table[i + 1] = ((7 - i) * alpha_table[0] + i * alpha_table[1]) / 7;
             }
-            break;
-        case PNG_COLOR_TYPE_RGB_ALPHA:
-        case PNG_COLOR_TYPE_GRAY:
-            for(int y = 0; y < static_cast<int>(src_height); y++) {
-                for(int x = 0; x < static_cast<int>(src_width); x++) {
-                    int src_pixel_offset_scanline_start  = (y * src_width + x) * 4;
-                    int dest_pixel_offset_scanline_start = (y * src_width + x) * 4;
-                    dest_pixel_data[dest_pixel_offset_scanline_start + 0] = src_pixel_data[src_pixel_offset_scanline_start + 0];
-                    dest_pixel_data[dest_pixel_offset_scanline_start + 1] = src_pixel_data[src_pixel_offset_scanline_start + 1];
-                    dest_pixel_data[dest_pixel_offset_scanline_start + 2] = src_pixel_data[src_pixel_offset_scanline_start + 2];
-                    dest_pixel_data[dest_pixel_offset_scanline_start + 3] = src_pixel_data[src_pixel_offset_scanline_start + 3];
-                }
+        } else {
+            for(int i = 1; i < 5; i++) {
+                alpha_table[i + 1] = ((5 - i) * alpha_table[0] + i * alpha_table[1]) / 5;
             }
-            break;
+            alpha_table[6] = 0;
+            alpha_table[7] = 255;
+        }
+        uint64_t alpha_bits = 0;
+        for(int i = 0; i < 6; i++) {
+            alpha_bits |= static_cast<uint64_t>(block[2 + i]) << (i * 8);
+        }
+        for(int i = 0; i < 16; i++) {
+            alphas[i] = alpha_table[(alpha_bits >> (i * 3)) & 0x7];
+        }
+        block += 8;
+    }
+    uint16_t color0 = block[0] | (block[1] << 8);
+    uint16_t color1 = block[2] | (block[3] << 8);
+    glm::ivec4 color_table[4];
+    color_table[0] = glm::ivec4(unpack_rgb565(color0), 255);
+    color_table[1] = glm::ivec4(unpack_rgb565(color1), 255);
+    if(!is_dxt1 || color0 > color1) {
+        color_table[2] = (color_table[0] * 2 + color_table[1]) / 3;
+        color_table[3] = (color_table[0] + color_table[1] * 2) / 3;
+    } else {
+        color_table[2] = (color_table[0] + color_table[1]) / 2;
+        color_table[3] = glm::ivec4(0, 0, 0, (format == gli::FORMAT_RGBA_DXT1_UNORM_BLOCK8) ? 0 : 255);
+    }
+    uint32_t color_bits = block[4] | (block[5] << 8) | (block[6] << 16) | (static_cast<uint32_t>(block[7]) << 24);
+    for(int i = 0; i < 16; i++) {
+        int x = block_x * 4 + i % 4;
+        int y = block_y * 4 + i / 4;
+        if(x >= width || y >= height) {
+            continue;
+        }
+        glm::ivec4 color = color_table[(color_bits >> (i * 2)) & 0x3];
+        unsigned char* dest_pixel = &dest[(y * width + x) * 4];
+        dest_pixel[0] = color.r;
+        dest_pixel[1] = color.g;
+        dest_pixel[2] = color.b;
+        dest_pixel[3] = std::min(color.a, static_cast<int>(alphas[i]));
     }
-    delete []src_pixel_data;
-    *pixel_data = dest_pixel_data;
-    *width      = src_width;
-    *height     = src_height;
-    return true;
 }
 
-bool read_png_impl(std::string png_filename,
-                   void**      pixel_data,
-                   size_t*     width,
-                   size_t*     height,
-                   int*        color_type)
+bool is_s3tc_format(int format)
 {
-    if(!pixel_data || !width || !height) {
-        return false;
+    switch(format) {
+        case gli::FORMAT_RGB_DXT1_UNORM_BLOCK8:
+        case gli::FORMAT_RGBA_DXT1_UNORM_BLOCK8:
+        case gli::FORMAT_RGBA_DXT3_UNORM_BLOCK16:
+        case gli::FORMAT_RGBA_DXT5_UNORM_BLOCK16:
+            return true;
+        default:
+            break;
     }
+    return false;
+}
 
-    // header for testing if it is a png
-    png_byte header[8];
-
-    // open file as binary
-    FILE* fp = fopen(png_filename.c_str(), "rb");
-    if(!fp) {
-        return false;
+std::string get_file_extension(std::string filename)
+{
+    size_t dot_pos = filename.rfind('.');
+    if(dot_pos == std::string::npos) {
+        return "";
     }
+    std::string ext = filename.substr(dot_pos + 1);
+    std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+    return ext;
+}
 
-    // read the header
-    fread(header, 1, 8, fp);
-
-    // test if png
-    int is_png = !png_sig_cmp(header, 0, 8);
-    if(!is_png) {
-        fclose(fp);
+// NOTE: dds rows are top-down, ktx rows are bottom-up
+static bool read_image_gli(std::string image_filename,
+                           void**      pixel_data,
+                           size_t*     width,
+                           size_t*     height)
+{
+    gli::texture2d texture(gli::load(image_filename));
+    if(texture.empty()) {
         return false;
     }
+    bool flip_rows = (get_file_extension(image_filename) == "dds");
+    gli::extent2d extent = texture.extent();
+    std::vector<unsigned char> decompressed_pixel_data;
+    int  num_components = 4;
+    bool swap_red_blue  = false;
+    if(gli::is_compressed(texture.format())) {
+        if(!is_s3tc_format(texture.format())) {
+            std::cout << "Warning: compressed texture format not supported on cpu: " << image_filename << std::endl;
+            return false;
+        }
 
-    // create png struct
-    png_structp png_ptr = png_create_read_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
-    if(!png_ptr) {
-        fclose(fp);
-        return false;
+        // cpu decompression, for when gpu lacks the compressed format
+        decompressed_pixel_data.resize(extent.x * extent.y * 4);
+        const unsigned char* blocks = static_cast<const unsigned char*>(texture[0].data());
+        size_t block_size = gli::block_size(texture.format());
+        int num_blocks_x = (extent.x + 3) / 4;
+        int num_blocks_y = (extent.y + 3) / 4;
+        for(int block_y = 0; block_y < num_blocks_y; block_y++) {
+            for(int block_x = 0; block_x < num_blocks_x; block_x++) {
+                decode_s3tc_block(&blocks[(block_y * num_blocks_x + block_x) * block_size],
+                                  texture.format(),
+                                  block_x,
+                                  block_y,
+                                  extent.x,
+                                  extent.y,
+                                  &decompressed_pixel_data[0]);
+            }
+        }
+    } else {
+        switch(texture.format()) {
+            case gli::FORMAT_RGBA8_UNORM_PACK8:
+                break;
+            case gli::FORMAT_BGRA8_UNORM_PACK8:
+                swap_red_blue = true;
+                break;
+            case gli::FORMAT_RGB8_UNORM_PACK8:
+                num_components = 3;
+                break;
+            case gli::FORMAT_BGR8_UNORM_PACK8:
+                num_components = 3;
+                swap_red_blue  = true;
+                break;
+            default:
+                // NOTE: gli::convert avoided, it pulls in code that memsets non-trivial gli types
+                std::cout << "Warning: uncompressed texture format not supported on cpu: " << image_filename << std::endl;
+                return false;
+        }
     }
-
-    // create png info struct
-    png_infop info_ptr = png_create_info_struct(png_ptr);
-    if(!info_ptr) {
-        png_destroy_read_struct(&png_ptr, (png_infopp) NULL, (png_infopp) NULL);
-        fclose(fp);
+    unsigned char* dest_pixel_data = new unsigned char[extent.x * extent.y * 4];
+    if(!dest_pixel_data) {
         return false;
     }
+    copy_pixels_to_rgba(decompressed_pixel_data.empty() ? static_cast<const unsigned char*>(texture[0].data()) : &decompressed_pixel_data[0],
+                        num_components,
+                        swap_red_blue,
+                        flip_rows,
+                        extent.x,
+                        extent.y,
+                        dest_pixel_data);
+    *pixel_data = dest_pixel_data;
+    *width      = extent.x;
+    *height     = extent.y;
+    return true;
+}
 
-    // create png info struct
-    png_infop end_info = png_create_info_struct(png_ptr);
-    if(!end_info) {
-        png_destroy_read_struct(&png_ptr, &info_ptr, (png_infopp) NULL);
-        fclose(fp);
+// decodes png/jpg/bmp/tga/psd/gif (stb_image) and dds/ktx (gli) into RGBA
+bool read_image(std::string image_filename,
+                void**      pixel_data,
+                size_t*     width,
+                size_t*     height)
+{
+    if(!pixel_data || !width || !height) {
         return false;
     }
-
-    // png error stuff, not sure libpng man suggests this
-    if(setjmp(png_jmpbuf(png_ptr))) {
-        png_destroy_read_struct(&png_ptr, &info_ptr, &end_info);
-        fclose(fp);
-        return false;
+    std::string ext = get_file_extension(image_filename);
+    if(ext == "dds" || ext == "ktx") {
+        return read_image_gli(image_filename, pixel_data, width, height);
     }
-
-    // init png reading
-    png_init_io(png_ptr, fp);
-
-    // let libpng know you already read the first 8 bytes
-    png_set_sig_bytes(png_ptr, 8);
-
-    // read all the info up to the image data
-    png_read_info(png_ptr, info_ptr);
-
-    // variables to pass to get info
-    int bit_depth;//, color_type;
-    png_uint_32 twidth, theight;
-
-    // get info about png
-    png_get_IHDR(png_ptr, info_ptr, &twidth, &theight, &bit_depth, color_type, NULL, NULL, NULL);
-
-    // update the png info struct.
-    png_read_update_info(png_ptr, info_ptr);
-
-    // row size in bytes.
-    int rowbytes = png_get_rowbytes(png_ptr, info_ptr);
-
-    // allocate the image_data as a big block, to be given to opengl
-    png_byte* image_data = new png_byte[rowbytes * theight];
-    if(!image_data) {
-        // clean up memory and close stuff
-        png_destroy_read_struct(&png_ptr, &info_ptr, &end_info);
-        fclose(fp);
+    int src_width  = 0;
+    int src_height = 0;
+    int src_num_components = 0;
+    unsigned char* src_pixel_data = stbi_load(image_filename.c_str(), &src_width, &src_height, &src_num_components, 4); // force RGBA
+    if(!src_pixel_data) {
         return false;
     }
-
-    // row_pointers is for pointing to image_data for reading the png with libpng
-    png_bytep* row_pointers = new png_bytep[theight];
-    if(!row_pointers) {
-        //clean up memory and close stuff
-        png_destroy_read_struct(&png_ptr, &info_ptr, &end_info);
-        delete[] image_data;
-        fclose(fp);
+    unsigned char* dest_pixel_data = new unsigned char[src_width * src_height * 4];
+    if(!dest_pixel_data) {
+        stbi_image_free(src_pixel_data);
         return false;
     }
-    // set the individual row_pointers to point at the correct offsets of image_data
-    for(int i = 0; i < static_cast<int>(theight); i++) {
-        row_pointers[theight - 1 - i] = image_data + i * rowbytes;
-    }
-
-    // read the png into image_data through row_pointers
-    png_read_image(png_ptr, row_pointers);
-
-    delete[] row_pointers;
-    fclose(fp);
-
-    // clean up memory and close stuff
-    png_destroy_read_struct(&png_ptr, &info_ptr, &end_info);
-
-    // update width and height based on png info
-    *pixel_data = image_data;
-    *width      = twidth;
-    *height     = theight;
-
+    copy_pixels_to_rgba(src_pixel_data, 4, false, true, src_width, src_height, dest_pixel_data);
+    stbi_image_free(src_pixel_data);
+    *pixel_data = dest_pixel_data;
+    *width      = src_width;
+    *height     = src_height;
     return true;
 }
 
+// decodes one image per worker thread
+void read_images(const std::vector<std::string> &image_filenames,
+                 std::vector<unsigned char*>*    pixel_data,
+                 std::vector<glm::ivec2>*        dims)
+{
+    pixel_data->assign(image_filenames.size(), NULL);
+    dims->assign(image_filenames.size(), glm::ivec2(0));
+    parallel_for(image_filenames.size(), 1, [&image_filenames, pixel_data, dims](int start_index, int end_index) {
+        for(int i = start_index; i < end_index; i++) {
+            size_t width  = 0;
+            size_t height = 0;
+            if(!read_image(image_filenames[i], reinterpret_cast<void**>(&(*pixel_data)[i]), &width, &height)) {
+                continue;
+            }
+            (*dims)[i] = glm::ivec2(width, height);
+        }
+    });
+}
+
 }
@@ -0,0 +1,203 @@
+// This file is part of dexvt-lite.
+// -- 3D Inverse Kinematics (Cyclic Coordinate Descent) with Constraints
+// Copyright (C) 2018 onlyuser <mailto:onlyuser@gmail.com>
+//
+// dexvt-lite is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// dexvt-lite is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with dexvt-lite.  If not, see <http://www.gnu.org/licenses/>.
+
+// dxtc -- transcodes textures (or a pmd/pmx model's textures) into mipmapped BC1/BC3 dds files
+// written next to each source as <image filename>.dds, which main picks up at load time
+
+#include <Util.h>
+#include <Saba/Model/MMD/MMDModel.h>
+#include <Saba/Model/MMD/PMDModel.h>
+#include <Saba/Model/MMD/PMXModel.h>
+#include <gli/texture2d.hpp>
+#include <gli/save_dds.hpp>
+#include <glm/glm.hpp>
+#include <vector>
+#include <string>
+#include <memory>
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+#include <memory.h>
+
+#define STB_DXT_IMPLEMENTATION
+#define STBD_MEMSET memset // default in vendored stb_dxt v1.07 takes the wrong arity
+#include <stb_dxt.h>
+
+static void usage()
+{
+    std::cout << "dxtc <image or pmd/pmx file>..." << std::endl;
+}
+
+static bool get_model_texture_filenames(std::string model_filename, std::vector<std::string>* image_filenames)
+{
+    std::shared_ptr<saba::MMDModel> mmd_model;
+    std::string ext = vt::get_file_extension(model_filename);
+    if(ext == "pmd") {
+        std::shared_ptr<saba::PMDModel> pmd_model = std::make_shared<saba::PMDModel>();
+        if(!pmd_model->Load(model_filename, "")) {
+            return false;
+        }
+        mmd_model = pmd_model;
+    } else {
+        std::shared_ptr<saba::PMXModel> pmx_model = std::make_shared<saba::PMXModel>();
+        if(!pmx_model->Load(model_filename, "")) {
+            return false;
+        }
+        mmd_model = pmx_model;
+    }
+    const saba::MMDMaterial* materials = mmd_model->GetMaterials();
+    for(size_t i = 0; i < mmd_model->GetMaterialCount(); i++) {
+        if(materials[i].m_texture.empty()) {
+            continue;
+        }
+        image_filenames->push_back(materials[i].m_texture);
+    }
+    return true;
+}
+
+// 2x2 box filter, edges clamped
+static void downsample(const std::vector<unsigned char> &src, glm::ivec2 src_dim, std::vector<unsigned char>* dest, glm::ivec2 dest_dim)
+{
+    dest->resize(dest_dim.x * dest_dim.y * 4);
+    for(int y = 0; y < dest_dim.y; y++) {
+        const unsigned char* src_row0 = &src[std::min(y * 2,     src_dim.y - 1) * src_dim.x * 4];
+        const unsigned char* src_row1 = &src[std::min(y * 2 + 1, src_dim.y - 1) * src_dim.x * 4];
+        for(int x = 0; x < dest_dim.x; x++) {
+            int src_offset0 = std::min(x * 2,     src_dim.x - 1) * 4;
+            int src_offset1 = std::min(x * 2 + 1, src_dim.x - 1) * 4;
+            for(int c = 0; c < 4; c++) {
+                (*dest)[(y * dest_dim.x + x) * 4 + c] = (src_row0[src_offset0 + c] + src_row0[src_offset1 + c] +
+                                                         src_row1[src_offset0 + c] + src_row1[src_offset1 + c] + 2) >> 2;
+            }
+        }
+    }
+}
+
+static void compress_level(const std::vector<unsigned char> &pixels, glm::ivec2 dim, bool has_alpha, unsigned char* blocks)
+{
+    int num_blocks_x = (dim.x + 3) / 4;
+    int num_blocks_y = (dim.y + 3) / 4;
+    int block_size   = has_alpha ? 16 : 8;
+    for(int block_y = 0; block_y < num_blocks_y; block_y++) {
+        for(int block_x = 0; block_x < num_blocks_x; block_x++) {
+            unsigned char block_pixels[16 * 4];
+            for(int i = 0; i < 16; i++) {
+                int x = std::min(block_x * 4 + i % 4, dim.x - 1);
+                int y = std::min(block_y * 4 + i / 4, dim.y - 1);
+                memcpy(&block_pixels[i * 4], &pixels[(y * dim.x + x) * 4], 4);
+            }
+            stb_compress_dxt_block(&blocks[(block_y * num_blocks_x + block_x) * block_size],
+                                   block_pixels,
+                                   has_alpha,
+                                   STB_DXT_HIGHQUAL);
+        }
+    }
+}
+
+static bool transcode_image(std::string image_filename, std::string* message)
+{
+    unsigned char* pixels = NULL;
+    size_t width  = 0;
+    size_t height = 0;
+    if(!vt::read_image(image_filename, reinterpret_cast<void**>(&pixels), &width, &height) || !pixels) {
+        *message = "failed to read " + image_filename;
+        return false;
+    }
+
+    // read_image returns bottom row first, dds is top-down
+    std::vector<unsigned char> level_pixels(width * height * 4);
+    for(int y = 0; y < static_cast<int>(height); y++) {
+        memcpy(&level_pixels[y * width * 4], &pixels[(height - 1 - y) * width * 4], width * 4);
+    }
+    delete[] pixels;
+    bool has_alpha = false;
+    for(int i = 0; i < static_cast<int>(width * height); i++) {
+        if(level_pixels[i * 4 + 3] != 255) {
+            has_alpha = true;
+            break;
+        }
+    }
+
+    gli::texture2d texture(has_alpha ? gli::FORMAT_RGBA_DXT5_UNORM_BLOCK16 : gli::FORMAT_RGB_DXT1_UNORM_BLOCK8,
+                           gli::extent2d(width, height)); // complete mipmap chain
+    glm::ivec2 dim(width, height);
+    std::vector<unsigned char> next_level_pixels;
+    for(int level = 0; level < static_cast<int>(texture.levels()); level++) {
+        if(level) {
+            glm::ivec2 next_dim = glm::max(dim / 2, glm::ivec2(1));
+            downsample(level_pixels, dim, &next_level_pixels, next_dim);
+            level_pixels.swap(next_level_pixels);
+            dim = next_dim;
+        }
+        compress_level(level_pixels, dim, has_alpha, texture[level].data<unsigned char>());
+    }
+    std::string dds_filename = image_filename + ".dds";
+    if(!gli::save_dds(texture, dds_filename)) {
+        *message = "failed to write " + dds_filename;
+        return false;
+    }
+    std::stringstream ss;
+    ss << dds_filename << " (" << (has_alpha ? "BC3" : "BC1") << ", " << width << "x" << height << ", " << texture.levels() << " levels)";
+    *message = ss.str();
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    if(argc < 2) {
+        usage();
+        return 1;
+    }
+    std::vector<std::string> image_filenames;
+    for(int i = 1; i < argc; i++) {
+        std::string filename = argv[i];
+        std::string ext = vt::get_file_extension(filename);
+        if(ext == "pmd" || ext == "pmx") {
+            if(!get_model_texture_filenames(filename, &image_filenames)) {
+                std::cout << "Error: failed to load model " << filename << std::endl;
+                return 1;
+            }
+            continue;
+        }
+        image_filenames.push_back(filename);
+    }
+    std::sort(image_filenames.begin(), image_filenames.end());
+    image_filenames.erase(std::unique(image_filenames.begin(), image_filenames.end()), image_filenames.end());
+
+    // stb_dxt builds its tables on first use, so do that before going parallel
+    unsigned char dummy_pixels[16 * 4] = {0};
+    unsigned char dummy_block[16];
+    stb_compress_dxt_block(dummy_block, dummy_pixels, 1, STB_DXT_HIGHQUAL);
+
+    std::vector<std::string> messages(image_filenames.size());
+    std::vector<int>         results(image_filenames.size(), 0);
+    vt::parallel_for(image_filenames.size(), 1, [&image_filenames, &messages, &results](int start_index, int end_index) {
+        for(int i = start_index; i < end_index; i++) {
+            results[i] = transcode_image(image_filenames[i], &messages[i]);
+        }
+    });
+    int num_failed = 0;
+    for(int i = 0; i < static_cast<int>(image_filenames.size()); i++) {
+        if(!results[i]) {
+            std::cout << "Error: " << messages[i] << std::endl;
+            num_failed++;
+            continue;
+        }
+        std::cout << "Wrote " << messages[i] << std::endl;
+    }
+    return num_failed ? 1 : 0;
+}
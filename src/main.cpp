@@ -38,17 +38,25 @@
 #include <Util.h>
 #include <VarAttribute.h>
 #include <VarUniform.h>
+#include <Saba/Model/MMD/MMDModelCache.h>
 #include <vector>
+#include <algorithm> // std::find
 #include <iostream> // std::cout
 #include <sstream> // std::stringstream
 #include <iomanip> // std::setprecision
 #include <unistd.h> // access
+#include <sys/stat.h> // stat
 #include <getopt.h> // getopt_long
 
 #define ACCEPT_AVG_ANGLE_DISTANCE    0.001
 #define ACCEPT_END_EFFECTOR_DISTANCE 0.001
 #define IK_ITERS                     1
 #define IK_SEGMENT_COUNT             3
+#define FLOOR_SIZE                   10
+#define FLOOR_GRID_SIZE              100
+#define RIPPLE_AMPLITUDE             0.05
+#define RIPPLE_WAVELENGTH            1
+#define RIPPLE_SPEED                 0.1
 
 const char* DEFAULT_CAPTION = "";
 
@@ -56,6 +64,7 @@ int init_screen_width  = 800,
     init_screen_height = 600;
 vt::Camera  *camera         = NULL;
 vt::Mesh    *mesh_skybox    = NULL;
+vt::Mesh    *mesh_floor     = NULL;
 vt::Light   *light          = NULL,
             *light2         = NULL,
             *light3         = NULL;
@@ -82,6 +91,7 @@ bool show_bbox        = false,
      show_paths       = true,
      show_axis        = false,
      show_axis_labels = false,
+     show_floor       = false,
      do_animation     = true,
      left_key         = false,
      right_key        = false,
@@ -91,6 +101,8 @@ bool show_bbox        = false,
      page_down_key    = false,
      user_input       = true;
 
+float ripple_phase = 0;
+
 float prev_zoom         = 0,
       zoom              = 1,
       ortho_dolly_speed = 0.1;
@@ -125,7 +137,8 @@ bool do_animation_loop = true;
 
 void display_usage()
 {
-    std::cout << "mmd2obj [-p <pmd/pmx file>] [-vmd <vmd file>] [-f <frame>] [-t <animation time (sec)>]" << std::endl;
+    std::cout << "mmd2obj [-p <pmd/pmx/3ds file>] [-vmd <vmd file>] [-f <frame>] [-t <animation time (sec)>] [-c <model cache dir>]" << std::endl;
+    std::cout << "        (-vmd, -f and -t not needed for 3ds, no model cache without -c)" << std::endl;
 }
 
 void show_turn_off_anim_msg()
@@ -137,6 +150,7 @@ struct options_t
 {
     std::string m_modelPath;
     std::string m_vmdPath;
+    std::string m_cacheDir;
     int         m_frame;
     double      m_animTime;
     bool        m_showHelp;
@@ -155,13 +169,14 @@ bool extract_options_from_args(options_t* options, int argc, char** argv)
     }
     int opt = 0;
     int longIndex = 0;
-    static const char *optString = "p:v:f:t:h?";
-    static const struct option longOpts[] = {{ "pmd-pmx", required_argument, NULL, 'p' },
-                                             { "vmd",     required_argument, NULL, 'v' },
-                                             { "frame",   required_argument, NULL, 'f' },
-                                             { "time",    required_argument, NULL, 't' },
-                                             { "help",    no_argument,       NULL, 'h' },
-                                             { NULL,      no_argument,       NULL, 0 }};
+    static const char *optString = "p:v:f:t:c:h?";
+    static const struct option longOpts[] = {{ "pmd-pmx",   required_argument, NULL, 'p' },
+                                             { "vmd",       required_argument, NULL, 'v' },
+                                             { "frame",     required_argument, NULL, 'f' },
+                                             { "time",      required_argument, NULL, 't' },
+                                             { "cache-dir", required_argument, NULL, 'c' },
+                                             { "help",      no_argument,       NULL, 'h' },
+                                             { NULL,        no_argument,       NULL, 0 }};
     opt = getopt_long(argc, argv, optString, longOpts, &longIndex);
     while(opt != -1) {
         switch(opt) {
@@ -169,6 +184,7 @@ bool extract_options_from_args(options_t* options, int argc, char** argv)
             case 'v': options->m_vmdPath   = optarg; break;
             case 'f': options->m_frame     = atoi(optarg); break;
             case 't': options->m_animTime  = atof(optarg); break;
+            case 'c': options->m_cacheDir  = optarg; break;
             case 'h':
             case '?': options->m_showHelp = true; break;
             case 0: // reserved
@@ -177,7 +193,38 @@ bool extract_options_from_args(options_t* options, int argc, char** argv)
         }
         opt = getopt_long(argc, argv, optString, longOpts, &longIndex);
     }
-    return options->m_showHelp || (options->m_modelPath.length() && options->m_vmdPath.length() && options->m_frame != -1 && options->m_animTime != -1);
+    if(options->m_showHelp) {
+        return true;
+    }
+    if(vt::get_file_extension(options->m_modelPath) == "3ds") {
+        return true; // static model, no animation needed
+    }
+    return options->m_modelPath.length() && options->m_vmdPath.length() && options->m_frame != -1 && options->m_animTime != -1;
+}
+
+// <texture filename>.dds from dxtc, unless the source image changed after it was transcoded
+bool has_up_to_date_dds(std::string texture_filename)
+{
+    struct stat dds_stat;
+    struct stat src_stat;
+    if(stat((texture_filename + ".dds").c_str(), &dds_stat) != 0) {
+        return false;
+    }
+    if(stat(texture_filename.c_str(), &src_stat) != 0) {
+        return true; // source missing, dds is all there is
+    }
+    return dds_stat.st_mtime >= src_stat.st_mtime;
+}
+
+// rippling floor under the model, displaced on GPU so its vertices are uploaded once
+void init_floor(vt::Material* material, float floor_height)
+{
+    mesh_floor = vt::PrimitiveFactory::create_grid("floor", FLOOR_GRID_SIZE, FLOOR_GRID_SIZE, FLOOR_SIZE, FLOOR_SIZE);
+    mesh_floor->set_origin(glm::vec3(-FLOOR_SIZE * 0.5, floor_height, -FLOOR_SIZE * 0.5));
+    mesh_floor->set_material(material);
+    mesh_floor->set_ambient_color(glm::vec3(0));
+    mesh_floor->set_visible(show_floor);
+    vt::Scene::instance()->add_mesh(mesh_floor);
 }
 
 int init_resources(const options_t& options)
@@ -209,6 +256,16 @@ int init_resources(const options_t& options)
                                                              "src/shaders/texture_mapped.f.glsl");
     scene->add_material(texture_mapped_material);
 
+    vt::Material* phong_ripple_material = new vt::Material("phong_ripple",
+                                                           "src/shaders/phong_ripple.v.glsl",
+                                                           "src/shaders/phong.f.glsl");
+    scene->add_material(phong_ripple_material);
+
+    vt::Material* texture_mapped_ripple_material = new vt::Material("texture_mapped_ripple",
+                                                                    "src/shaders/texture_mapped_ripple.v.glsl",
+                                                                    "src/shaders/texture_mapped.f.glsl");
+    scene->add_material(texture_mapped_ripple_material);
+
     texture_skybox = new vt::Texture("skybox_texture",
                                      "data/SaintPetersSquare2/posx.png",
                                      "data/SaintPetersSquare2/negx.png",
@@ -234,7 +291,29 @@ int init_resources(const options_t& options)
     dummy->center_axis();
     dummy->set_origin(glm::vec3(0));
     scene->add_mesh(dummy);
-#if 1
+    if(vt::get_file_extension(options.m_modelPath) == "3ds") {
+        if(access(options.m_modelPath.c_str(), F_OK) != -1) {
+            vt::File3ds::load3ds(options.m_modelPath, -1, &meshes_imported);
+        }
+        for(std::vector<vt::Mesh*>::iterator p = meshes_imported.begin(); p != meshes_imported.end(); p++) {
+            (*p)->set_origin(glm::vec3(0));
+            (*p)->set_scale(glm::vec3(0.33, 0.33, 0.33));
+            (*p)->flatten();
+            (*p)->set_material(phong_material);
+            (*p)->set_ambient_color(glm::vec3(0));
+            (*p)->link_parent(dummy);
+            scene->add_mesh(*p);
+        }
+        float floor_height = 0;
+        for(std::vector<vt::Mesh*>::iterator q = meshes_imported.begin(); q != meshes_imported.end(); q++) {
+            glm::vec3 mesh_min, mesh_max;
+            (*q)->get_world_min_max(&mesh_min, &mesh_max);
+            floor_height = (q == meshes_imported.begin()) ? mesh_min.y : std::min(floor_height, mesh_min.y);
+        }
+        init_floor(phong_ripple_material, floor_height);
+        init_multithreading_resources();
+        return 1;
+    }
     std::map<vt::Mesh*, vt::MeshAttributes> mesh2attr_map;
     if(access(options.m_modelPath.c_str(), F_OK) != -1 &&
        access(options.m_vmdPath.c_str(),   F_OK) != -1)
@@ -267,35 +346,67 @@ int init_resources(const options_t& options)
                                &global_min,
                                &global_max);
     dummy->set_origin(-(global_min + global_max) * 0.5f);
+    vt::Texture* floor_texture = new vt::Texture("floor_texture", "data/SaintPetersSquare2/negy.png");
+    scene->add_texture(floor_texture);
+    texture_mapped_ripple_material->add_texture(floor_texture);
+    init_floor(texture_mapped_ripple_material, (global_min.y - global_max.y) * 0.5f);
+    mesh_floor->set_texture_index(texture_mapped_ripple_material->get_texture_index_by_name("floor_texture"));
+    std::vector<std::string> texture_filenames;            // each texture loaded once, decoded in parallel
+    std::vector<std::string> compressed_texture_filenames; // dds/ktx, or transcoded by dxtc (<texture filename>.dds, if not stale)
+    for(std::map<vt::Mesh*, vt::MeshAttributes>::iterator r = mesh2attr_map.begin(); r != mesh2attr_map.end(); r++) {
+        std::string texture_filename = (*r).second.m_texture_filename;
+        if(std::find(texture_filenames.begin(),            texture_filenames.end(),            texture_filename) != texture_filenames.end() ||
+           std::find(compressed_texture_filenames.begin(), compressed_texture_filenames.end(), texture_filename) != compressed_texture_filenames.end())
+        {
+            continue;
+        }
+        std::string ext = vt::get_file_extension(texture_filename);
+        if(ext == "dds" || ext == "ktx" || has_up_to_date_dds(texture_filename)) {
+            compressed_texture_filenames.push_back(texture_filename);
+            continue;
+        }
+        texture_filenames.push_back(texture_filename);
+    }
+    for(std::vector<std::string>::iterator q = compressed_texture_filenames.begin(); q != compressed_texture_filenames.end(); q++) {
+        std::string ext = vt::get_file_extension(*q);
+        vt::Texture* texture = new vt::Texture(*q,
+                                               (ext == "dds" || ext == "ktx") ? *q : (*q + ".dds"),
+                                               false,
+                                               true); // trilinear
+        scene->add_texture(texture);
+        texture_mapped_material->add_texture(texture);
+    }
+    std::vector<unsigned char*> texture_pixels;
+    std::vector<glm::ivec2>     texture_dims;
+    vt::read_images(texture_filenames, &texture_pixels, &texture_dims);
+    for(int i = 0; i < static_cast<int>(texture_filenames.size()); i++) {
+        vt::Texture* texture = NULL;
+        if(texture_pixels[i]) {
+            texture = new vt::Texture(texture_filenames[i],
+                                      vt::Texture::RGBA,
+                                      texture_dims[i],
+                                      false,
+                                      vt::Texture::RGBA,
+                                      texture_pixels[i],
+                                      true); // trilinear
+            delete[] texture_pixels[i];
+        } else {
+            texture = new vt::Texture(texture_filenames[i], texture_filenames[i], false); // unloadable, keeps index valid
+        }
+        scene->add_texture(texture);
+        texture_mapped_material->add_texture(texture);
+    }
     for(std::map<vt::Mesh*, vt::MeshAttributes>::iterator r = mesh2attr_map.begin(); r != mesh2attr_map.end(); r++) {
         vt::Mesh* mesh          = (*r).first;
         vt::MeshAttributes attr = (*r).second;
         mesh->set_material(texture_mapped_material);
         //mesh->set_material(ambient_material);
-        vt::Texture* texture = new vt::Texture(attr.m_texture_filename, attr.m_texture_filename, false);
-        scene->add_texture(texture);
-        texture_mapped_material->add_texture(texture);
         mesh->set_texture_index(mesh->get_material()->get_texture_index_by_name(attr.m_texture_filename));
         mesh->set_ambient_color(attr.m_ambient_color);
         //mesh->set_diffuse_color(attr.m_diffuse_color);
         //mesh->set_specular_color(attr.m_specular_color);
         //mesh->set_alpha(attr.m_alpha);
     }
-#else
-    const char* model_filename = "data/star_wars/TI_Low0.3ds";
-    if(access(model_filename, F_OK) != -1) {
-        vt::File3ds::load3ds(model_filename, -1, &meshes_imported);
-    }
-    for(std::vector<vt::Mesh*>::iterator p = meshes_imported.begin(); p != meshes_imported.end(); p++) {
-        (*p)->set_origin(glm::vec3(0));
-        (*p)->set_scale(glm::vec3(0.33, 0.33, 0.33));
-        (*p)->flatten();
-        (*p)->set_material(phong_material);
-        (*p)->set_ambient_color(glm::vec3(0));
-        (*p)->link_parent(dummy);
-        scene->add_mesh(*p);
-    }
-#endif
 
     init_multithreading_resources();
     return 1;
@@ -415,7 +526,8 @@ void onTick()
         ss << std::setprecision(2) << std::fixed << fps << " FPS, "
             << "Mouse: {" << mouse_drag.x << ", " << mouse_drag.y << "}, "
             << "Yaw=" << EULER_YAW(euler) << ", Pitch=" << EULER_PITCH(euler) << ", Radius=" << orbit_radius << ", "
-            << "Zoom=" << zoom;
+            << "Zoom=" << zoom << ", "
+            << "Drawn=" << vt::Scene::instance()->get_num_drawn_meshes() << ", Culled=" << vt::Scene::instance()->get_num_culled_meshes();
         //ss << "Width=" << camera->get_width() << ", Width=" << camera->get_height();
         glutSetWindowTitle(ss.str().c_str());
     }
@@ -453,6 +565,16 @@ void onTick()
         std::cout << "\r" << std::setw(80) << std::left << ss.str() << std::flush;
         user_input = false;
     }
+    if(show_floor) {
+        ripple_phase -= RIPPLE_SPEED; // waves travel outward from the center
+        vt::mesh_apply_ripple(mesh_floor,
+                              glm::vec3(FLOOR_SIZE * 0.5, 0, FLOOR_SIZE * 0.5),
+                              RIPPLE_AMPLITUDE,
+                              RIPPLE_WAVELENGTH,
+                              ripple_phase,
+                              true,
+                              vt::RIPPLE_MODE_GPU);
+    }
     static int angle = 0;
     angle = (angle + angle_delta) % 360;
 }
@@ -515,6 +637,10 @@ void onKeyboard(unsigned char key, int x, int y)
                 camera->set_projection_mode(vt::Camera::PROJECTION_MODE_PERSPECTIVE);
             }
             break;
+        case 'r': // rippling floor
+            show_floor = !show_floor;
+            mesh_floor->set_visible(show_floor);
+            break;
         case 's': // paths
             show_paths = !show_paths;
             break;
@@ -577,7 +703,6 @@ void onSpecial(int key, int x, int y)
             break;
         case GLUT_KEY_HOME:
             dummy->set_euler(glm::vec3(0));
-            dummy->get_transform(true); // TODO: why is this necessary?
             user_input = true;
             break;
         case GLUT_KEY_LEFT:
@@ -684,6 +809,7 @@ int main(int argc, char* argv[])
     }
 
     DEFAULT_CAPTION = argv[0];
+    saba::SetModelCacheDirectory(options.m_cacheDir);
 
     glutInit(&argc, argv);
     glutInitDisplayMode(GLUT_RGBA | GLUT_ALPHA | GLUT_DOUBLE | GLUT_DEPTH /*| GLUT_STENCIL*/);
@@ -0,0 +1,580 @@
+// This file is part of dexvt-lite.
+// -- 3D Inverse Kinematics (Cyclic Coordinate Descent) with Constraints
+// Copyright (C) 2018 onlyuser <mailto:onlyuser@gmail.com>
+//
+// dexvt-lite is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// dexvt-lite is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with dexvt-lite.  If not, see <http://www.gnu.org/licenses/>.
+
+// mmdbake -- evaluates a pmd/pmx model over a vmd frame range with one persistent model instance
+// and writes every frame either to a binary vertex cache (<output>.vtc) or to numbered obj/ply files
+//
+// vtc layout (little endian):
+//     header    : char[4] "VTC1", uint32 version, uint32 num_vertex, uint32 num_index,
+//                 uint32 num_frame, int32 start_frame, float frames_per_sec, uint32 flags
+//     static    : uint32 indices[num_index], vec2 tex_coords[num_vertex]
+//     per frame : vec3 positions[num_vertex], vec3 normals[num_vertex],
+//                 vec2 tex_coords[num_vertex] (only with VTC_FLAG_FRAME_TEX_COORDS, for uv morphs)
+
+#include <Util.h>
+#include <Saba/Base/Path.h>
+#include <Saba/Model/MMD/MMDModel.h>
+#include <Saba/Model/MMD/MMDModelCache.h>
+#include <Saba/Model/MMD/PMDModel.h>
+#include <Saba/Model/MMD/PMXModel.h>
+#include <Saba/Model/MMD/VMDFile.h>
+#include <Saba/Model/MMD/VMDAnimation.h>
+#include <glm/glm.hpp>
+#include <vector>
+#include <string>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <algorithm>
+#include <iostream>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <getopt.h>
+
+#define VTC_VERSION        2
+#define VTC_FLAG_FRAME_TEX_COORDS 0x1
+#define FRAMES_PER_SEC     30
+#define MAX_QUEUED_FRAMES  8         // bounds memory when writers fall behind evaluation
+#define WRITE_BUFFER_SIZE  (1 << 20)
+#define FLOAT_DECIMALS     6
+#define MAX_FLOAT_CHARS    32
+#define MAX_FIXED_FLOAT    1000000000.0f // beyond this fall back to snprintf
+
+enum output_format_t {
+    OUTPUT_FORMAT_VTC,
+    OUTPUT_FORMAT_OBJ,
+    OUTPUT_FORMAT_PLY
+};
+
+struct options_t
+{
+    std::string     m_model_path;
+    std::string     m_vmd_path;
+    std::string     m_output_path;
+    std::string     m_cache_dir;
+    int             m_start_frame;
+    int             m_end_frame;
+    output_format_t m_format;
+    bool            m_show_help;
+
+    options_t()
+        : m_output_path("output"),
+          m_start_frame(0),
+          m_end_frame(0),
+          m_format(OUTPUT_FORMAT_VTC),
+          m_show_help(false)
+    {}
+};
+
+struct frame_t
+{
+    int                    m_frame;
+    std::vector<glm::vec3> m_positions;
+    std::vector<glm::vec3> m_normals;
+    std::vector<glm::vec2> m_tex_coords; // only filled for models with uv morphs
+};
+
+// bounded queue between the evaluation thread and the writer threads
+struct frame_queue_t
+{
+    std::deque<frame_t*>    m_frames;
+    std::mutex              m_mutex;
+    std::condition_variable m_not_empty;
+    std::condition_variable m_not_full;
+    bool                    m_done;
+
+    frame_queue_t()
+        : m_done(false)
+    {}
+
+    void push(frame_t* frame)
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_not_full.wait(lock, [this]() { return m_frames.size() < MAX_QUEUED_FRAMES; });
+        m_frames.push_back(frame);
+        m_not_empty.notify_one();
+    }
+
+    // returns NULL once the queue is drained and closed
+    frame_t* pop()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_not_empty.wait(lock, [this]() { return !m_frames.empty() || m_done; });
+        if(m_frames.empty()) {
+            return NULL;
+        }
+        frame_t* frame = m_frames.front();
+        m_frames.pop_front();
+        m_not_full.notify_one();
+        return frame;
+    }
+
+    void close()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_done = true;
+        m_not_empty.notify_all();
+    }
+};
+
+// per-model data that does not change between frames
+struct bake_context_t
+{
+    options_t                       m_options;
+    size_t                          m_num_vertex;
+    std::vector<uint32_t>           m_indices;
+    std::vector<glm::vec2>          m_tex_coords;
+    bool                            m_has_uv_morph; // tex coords written per frame instead of once
+    std::vector<int>                m_subMesh_begin_index;
+    std::vector<int>                m_subMesh_index_count;
+    std::vector<int>                m_subMesh_material_id;
+    std::string                     m_static_text; // faces (and tex coords without uv morphs) for obj/ply, formatted once
+    FILE*                           m_vtc_file;
+    std::atomic<int>                m_num_failed;
+};
+
+static void usage()
+{
+    std::cout << "mmdbake -p <pmd/pmx file> -v <vmd file> [-s <start frame>] [-e <end frame>] [-f <vtc/obj/ply>] [-o <output path>] [-c <model cache dir>]" << std::endl;
+}
+
+static bool extract_options_from_args(options_t* options, int argc, char** argv)
+{
+    if(!options) {
+        return false;
+    }
+    int opt = 0;
+    int longIndex = 0;
+    static const char *optString = "p:v:s:e:f:o:c:h?";
+    static const struct option longOpts[] = {{ "pmd-pmx",   required_argument, NULL, 'p' },
+                                             { "vmd",       required_argument, NULL, 'v' },
+                                             { "start",     required_argument, NULL, 's' },
+                                             { "end",       required_argument, NULL, 'e' },
+                                             { "format",    required_argument, NULL, 'f' },
+                                             { "output",    required_argument, NULL, 'o' },
+                                             { "cache-dir", required_argument, NULL, 'c' },
+                                             { "help",      no_argument,       NULL, 'h' },
+                                             { NULL,        no_argument,       NULL, 0 }};
+    std::string format = "vtc";
+    opt = getopt_long(argc, argv, optString, longOpts, &longIndex);
+    while(opt != -1) {
+        switch(opt) {
+            case 'p': options->m_model_path  = optarg; break;
+            case 'v': options->m_vmd_path    = optarg; break;
+            case 's': options->m_start_frame = atoi(optarg); break;
+            case 'e': options->m_end_frame   = atoi(optarg); break;
+            case 'f': format                 = optarg; break;
+            case 'o': options->m_output_path = optarg; break;
+            case 'c': options->m_cache_dir   = optarg; break;
+            case 'h':
+            case '?': options->m_show_help = true; break;
+            case 0: // reserved
+            default:
+                break;
+        }
+        opt = getopt_long(argc, argv, optString, longOpts, &longIndex);
+    }
+    if(format == "vtc") {
+        options->m_format = OUTPUT_FORMAT_VTC;
+    } else if(format == "obj") {
+        options->m_format = OUTPUT_FORMAT_OBJ;
+    } else if(format == "ply") {
+        options->m_format = OUTPUT_FORMAT_PLY;
+    } else {
+        return false;
+    }
+    return !options->m_show_help &&
+           options->m_model_path.length() &&
+           options->m_vmd_path.length() &&
+           options->m_start_frame >= 0 &&
+           options->m_end_frame >= options->m_start_frame;
+}
+
+// writes value with up to FLOAT_DECIMALS decimals (trailing zeros trimmed), returns number of chars written
+// NOTE: std::to_chars needs C++17, this repo builds as C++14
+static int format_float(float value, char* buf)
+{
+    if(!(fabs(value) < MAX_FIXED_FLOAT)) { // also catches nan
+        return snprintf(buf, MAX_FLOAT_CHARS, "%g", value);
+    }
+    char* p = buf;
+    if(value < 0) {
+        *p++ = '-';
+        value = -value;
+    }
+    static const uint32_t scale = 1000000; // 10^FLOAT_DECIMALS
+    uint32_t integer_part  = static_cast<uint32_t>(value);
+    uint32_t fraction_part = static_cast<uint32_t>((value - integer_part) * scale + 0.5f);
+    if(fraction_part >= scale) {
+        integer_part++;
+        fraction_part -= scale;
+    }
+    char digits[16];
+    int num_digits = 0;
+    do {
+        digits[num_digits++] = '0' + integer_part % 10;
+        integer_part /= 10;
+    } while(integer_part);
+    while(num_digits) {
+        *p++ = digits[--num_digits];
+    }
+    if(fraction_part) {
+        *p++ = '.';
+        int num_decimals = FLOAT_DECIMALS;
+        while(!(fraction_part % 10)) {
+            fraction_part /= 10;
+            num_decimals--;
+        }
+        for(int i = num_decimals - 1; i >= 0; i--) {
+            p[i] = '0' + fraction_part % 10;
+            fraction_part /= 10;
+        }
+        p += num_decimals;
+    }
+    if(p - buf == 2 && buf[0] == '-' && buf[1] == '0') { // no "-0"
+        buf[0] = '0';
+        p--;
+    }
+    return p - buf;
+}
+
+static int format_uint(uint32_t value, char* buf)
+{
+    char digits[16];
+    int num_digits = 0;
+    do {
+        digits[num_digits++] = '0' + value % 10;
+        value /= 10;
+    } while(value);
+    for(int i = 0; i < num_digits; i++) {
+        buf[i] = digits[num_digits - 1 - i];
+    }
+    return num_digits;
+}
+
+static void append_floats(std::string* s, const char* prefix, const float* values, int count)
+{
+    char buf[MAX_FLOAT_CHARS * 9]; // up to 8 values plus prefix
+    char* p = buf;
+    for(const char* q = prefix; *q; q++) {
+        *p++ = *q;
+    }
+    for(int i = 0; i < count; i++) {
+        if(i) {
+            *p++ = ' ';
+        }
+        p += format_float(values[i], p);
+    }
+    *p++ = '\n';
+    s->append(buf, p - buf);
+}
+
+static std::shared_ptr<saba::MMDModel> load_model(std::string model_filename)
+{
+    std::string ext = vt::get_file_extension(model_filename);
+    if(ext == "pmd") {
+        std::shared_ptr<saba::PMDModel> pmd_model = std::make_shared<saba::PMDModel>();
+        if(!pmd_model->Load(model_filename, "")) {
+            return NULL;
+        }
+        return pmd_model;
+    }
+    if(ext == "pmx") {
+        std::shared_ptr<saba::PMXModel> pmx_model = std::make_shared<saba::PMXModel>();
+        if(!pmx_model->Load(model_filename, "")) {
+            return NULL;
+        }
+        return pmx_model;
+    }
+    return NULL;
+}
+
+static bool copy_indices(const saba::MMDModel* mmd_model, std::vector<uint32_t>* indices)
+{
+    size_t count = mmd_model->GetIndexCount();
+    indices->resize(count);
+    switch(mmd_model->GetIndexElementSize()) {
+        case 1: std::copy(static_cast<const uint8_t*>(mmd_model->GetIndices()),  static_cast<const uint8_t*>(mmd_model->GetIndices())  + count, indices->begin()); break;
+        case 2: std::copy(static_cast<const uint16_t*>(mmd_model->GetIndices()), static_cast<const uint16_t*>(mmd_model->GetIndices()) + count, indices->begin()); break;
+        case 4: std::copy(static_cast<const uint32_t*>(mmd_model->GetIndices()), static_cast<const uint32_t*>(mmd_model->GetIndices()) + count, indices->begin()); break;
+        default:
+            return false;
+    }
+    return true;
+}
+
+static void build_static_text(bake_context_t* context)
+{
+    std::string &s = context->m_static_text;
+    char buf[MAX_FLOAT_CHARS * 4];
+    if(context->m_options.m_format == OUTPUT_FORMAT_OBJ) {
+        if(!context->m_has_uv_morph) {
+            for(int i = 0; i < static_cast<int>(context->m_num_vertex); i++) {
+                append_floats(&s, "vt ", &context->m_tex_coords[i].x, 2);
+            }
+        }
+        for(int j = 0; j < static_cast<int>(context->m_subMesh_begin_index.size()); j++) {
+            s.append("\nusemtl ");
+            s.append(buf, format_uint(context->m_subMesh_material_id[j], buf));
+            s.append("\n");
+            int begin_index = context->m_subMesh_begin_index[j];
+            int end_index   = begin_index + context->m_subMesh_index_count[j];
+            for(int k = begin_index; k + 2 < end_index; k += 3) {
+                char* p = buf;
+                *p++ = 'f';
+                for(int n = 0; n < 3; n++) {
+                    uint32_t vert_index = context->m_indices[k + n] + 1; // obj is 1-based
+                    *p++ = ' ';
+                    p += format_uint(vert_index, p);
+                    *p++ = '/';
+                    p += format_uint(vert_index, p);
+                    *p++ = '/';
+                    p += format_uint(vert_index, p);
+                }
+                *p++ = '\n';
+                s.append(buf, p - buf);
+            }
+        }
+    } else if(context->m_options.m_format == OUTPUT_FORMAT_PLY) {
+        for(int k = 0; k + 2 < static_cast<int>(context->m_indices.size()); k += 3) {
+            char* p = buf;
+            *p++ = '3';
+            for(int n = 0; n < 3; n++) {
+                *p++ = ' ';
+                p += format_uint(context->m_indices[k + n], p);
+            }
+            *p++ = '\n';
+            s.append(buf, p - buf);
+        }
+    }
+}
+
+static std::string get_frame_filename(const bake_context_t* context, int frame)
+{
+    char buf[16];
+    snprintf(buf, sizeof(buf), "_%05d.", frame);
+    return context->m_options.m_output_path + buf + (context->m_options.m_format == OUTPUT_FORMAT_OBJ ? "obj" : "ply");
+}
+
+static bool write_buffer(std::string filename, const std::string &s)
+{
+    FILE* file = fopen(filename.c_str(), "wb");
+    if(!file) {
+        return false;
+    }
+    bool result = fwrite(s.data(), 1, s.size(), file) == s.size();
+    return (fclose(file) == 0) && result;
+}
+
+static bool write_text_frame(const bake_context_t* context, const frame_t* frame, std::string* s)
+{
+    s->clear();
+    size_t num_vertex = context->m_num_vertex;
+    const glm::vec2* tex_coords = context->m_has_uv_morph ? &frame->m_tex_coords[0] : &context->m_tex_coords[0];
+    if(context->m_options.m_format == OUTPUT_FORMAT_OBJ) {
+        s->append("# mmdbake\nmtllib ");
+        s->append(saba::PathUtil::GetFilename(context->m_options.m_output_path) + ".mtl");
+        s->append("\n");
+        for(int i = 0; i < static_cast<int>(num_vertex); i++) {
+            append_floats(s, "v ", &frame->m_positions[i].x, 3);
+        }
+        for(int i = 0; i < static_cast<int>(num_vertex); i++) {
+            append_floats(s, "vn ", &frame->m_normals[i].x, 3);
+        }
+        if(context->m_has_uv_morph) {
+            for(int i = 0; i < static_cast<int>(num_vertex); i++) {
+                append_floats(s, "vt ", &tex_coords[i].x, 2);
+            }
+        }
+    } else {
+        char buf[MAX_FLOAT_CHARS];
+        s->append("ply\nformat ascii 1.0\ncomment mmdbake\nelement vertex ");
+        s->append(buf, format_uint(num_vertex, buf));
+        s->append("\nproperty float x\nproperty float y\nproperty float z\n"
+                       "property float nx\nproperty float ny\nproperty float nz\n"
+                       "property float s\nproperty float t\nelement face ");
+        s->append(buf, format_uint(context->m_indices.size() / 3, buf));
+        s->append("\nproperty list uchar uint vertex_indices\nend_header\n");
+        for(int i = 0; i < static_cast<int>(num_vertex); i++) {
+            float values[8] = {frame->m_positions[i].x, frame->m_positions[i].y, frame->m_positions[i].z,
+                               frame->m_normals[i].x,   frame->m_normals[i].y,   frame->m_normals[i].z,
+                               tex_coords[i].x,         tex_coords[i].y};
+            append_floats(s, "", values, 8);
+        }
+    }
+    s->append(context->m_static_text);
+    return write_buffer(get_frame_filename(context, frame->m_frame), *s);
+}
+
+static bool write_mtl(const bake_context_t* context, const saba::MMDModel* mmd_model)
+{
+    std::string s = "# mmdbake\n";
+    char buf[MAX_FLOAT_CHARS];
+    const saba::MMDMaterial* materials = mmd_model->GetMaterials();
+    for(int i = 0; i < static_cast<int>(mmd_model->GetMaterialCount()); i++) {
+        const saba::MMDMaterial &m = materials[i];
+        s.append("newmtl ");
+        s.append(buf, format_uint(i, buf));
+        s.append("\n");
+        append_floats(&s, "Ka ", &m.m_ambient.r,  3);
+        append_floats(&s, "Kd ", &m.m_diffuse.r,  3);
+        append_floats(&s, "Ks ", &m.m_specular.r, 3);
+        append_floats(&s, "d ",  &m.m_alpha,      1);
+        s.append("map_Kd " + m.m_texture + "\n\n");
+    }
+    return write_buffer(context->m_options.m_output_path + ".mtl", s);
+}
+
+static bool write_vtc_header(bake_context_t* context)
+{
+    std::string filename = context->m_options.m_output_path + ".vtc";
+    context->m_vtc_file = fopen(filename.c_str(), "wb");
+    if(!context->m_vtc_file) {
+        return false;
+    }
+    setvbuf(context->m_vtc_file, NULL, _IOFBF, WRITE_BUFFER_SIZE);
+    uint32_t header[7] = {VTC_VERSION,
+                          static_cast<uint32_t>(context->m_num_vertex),
+                          static_cast<uint32_t>(context->m_indices.size()),
+                          static_cast<uint32_t>(context->m_options.m_end_frame - context->m_options.m_start_frame + 1),
+                          static_cast<uint32_t>(context->m_options.m_start_frame),
+                          0,
+                          context->m_has_uv_morph ? VTC_FLAG_FRAME_TEX_COORDS : 0u};
+    float frames_per_sec = FRAMES_PER_SEC;
+    memcpy(&header[5], &frames_per_sec, sizeof(float));
+    return fwrite("VTC1", 1, 4, context->m_vtc_file) == 4 &&
+           fwrite(header, sizeof(header), 1, context->m_vtc_file) == 1 &&
+           fwrite(&context->m_indices[0],    sizeof(uint32_t),  context->m_indices.size(), context->m_vtc_file) == context->m_indices.size() &&
+           fwrite(&context->m_tex_coords[0], sizeof(glm::vec2), context->m_num_vertex,     context->m_vtc_file) == context->m_num_vertex;
+}
+
+static bool write_vtc_frame(const bake_context_t* context, const frame_t* frame)
+{
+    size_t num_vertex = context->m_num_vertex;
+    return fwrite(&frame->m_positions[0], sizeof(glm::vec3), num_vertex, context->m_vtc_file) == num_vertex &&
+           fwrite(&frame->m_normals[0],   sizeof(glm::vec3), num_vertex, context->m_vtc_file) == num_vertex &&
+           (!context->m_has_uv_morph ||
+            fwrite(&frame->m_tex_coords[0], sizeof(glm::vec2), num_vertex, context->m_vtc_file) == num_vertex);
+}
+
+// drains the queue; vtc has one writer (frames stay in order), obj/ply have one per core (one file per frame)
+static void writer_loop(bake_context_t* context, frame_queue_t* queue)
+{
+    std::string s;
+    frame_t* frame = NULL;
+    while((frame = queue->pop())) {
+        bool result = (context->m_options.m_format == OUTPUT_FORMAT_VTC) ? write_vtc_frame(context, frame)
+                                                                         : write_text_frame(context, frame, &s);
+        if(!result) {
+            std::cout << "Error: failed to write frame " << frame->m_frame << std::endl;
+            context->m_num_failed++;
+        }
+        delete frame;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    bake_context_t context;
+    if(!extract_options_from_args(&context.m_options, argc, argv)) {
+        usage();
+        return 1;
+    }
+    context.m_vtc_file   = NULL;
+    context.m_num_failed = 0;
+    const options_t &options = context.m_options;
+    saba::SetModelCacheDirectory(options.m_cache_dir);
+
+    std::shared_ptr<saba::MMDModel> mmd_model = load_model(options.m_model_path);
+    if(!mmd_model) {
+        std::cout << "Error: failed to load model " << options.m_model_path << std::endl;
+        return 1;
+    }
+    std::unique_ptr<saba::VMDAnimation> vmd_anim(new saba::VMDAnimation());
+    saba::VMDFile vmd_file;
+    if(!vmd_anim->Create(mmd_model) || !saba::ReadVMDFile(&vmd_file, options.m_vmd_path.c_str()) || !vmd_anim->Add(vmd_file)) {
+        std::cout << "Error: failed to load motion " << options.m_vmd_path << std::endl;
+        return 1;
+    }
+    mmd_model->SetParallelUpdateHint(std::max(std::thread::hardware_concurrency(), 1u));
+
+    context.m_num_vertex = mmd_model->GetVertexCount();
+    if(!copy_indices(mmd_model.get(), &context.m_indices)) {
+        std::cout << "Error: unsupported index size" << std::endl;
+        return 1;
+    }
+    const glm::vec2* uvs = mmd_model->GetUpdateUVs();
+    context.m_tex_coords.assign(uvs, uvs + context.m_num_vertex);
+    context.m_has_uv_morph = mmd_model->HasUVMorph();
+    const saba::MMDSubMesh* subMeshes = mmd_model->GetSubMeshes();
+    for(int i = 0; i < static_cast<int>(mmd_model->GetSubMeshCount()); i++) {
+        context.m_subMesh_begin_index.push_back(subMeshes[i].m_beginIndex);
+        context.m_subMesh_index_count.push_back(subMeshes[i].m_vertexCount);
+        context.m_subMesh_material_id.push_back(subMeshes[i].m_materialID);
+    }
+    build_static_text(&context);
+    if(options.m_format == OUTPUT_FORMAT_VTC && !write_vtc_header(&context)) {
+        std::cout << "Error: failed to write " << options.m_output_path << ".vtc" << std::endl;
+        return 1;
+    }
+    if(options.m_format == OUTPUT_FORMAT_OBJ && !write_mtl(&context, mmd_model.get())) {
+        std::cout << "Error: failed to write " << options.m_output_path << ".mtl" << std::endl;
+        return 1;
+    }
+
+    // formatting and writing overlap with evaluation of the next frames
+    frame_queue_t queue;
+    int num_writers = (options.m_format == OUTPUT_FORMAT_VTC) ? 1 : std::max(static_cast<int>(std::thread::hardware_concurrency()) - 1, 1);
+    std::vector<std::thread> writers;
+    for(int i = 0; i < num_writers; i++) {
+        writers.push_back(std::thread(writer_loop, &context, &queue));
+    }
+
+    // physics settles once at the start frame, then advances one frame step at a time
+    mmd_model->InitializeAnimation();
+    vmd_anim->SyncPhysics(static_cast<float>(options.m_start_frame));
+    for(int frame = options.m_start_frame; frame <= options.m_end_frame; frame++) {
+        mmd_model->BeginAnimation();
+        mmd_model->UpdateAllAnimation(vmd_anim.get(), static_cast<float>(frame), 1.0f / FRAMES_PER_SEC);
+        mmd_model->EndAnimation();
+        mmd_model->Update();
+        frame_t* f = new frame_t;
+        f->m_frame = frame;
+        f->m_positions.assign(mmd_model->GetUpdatePositions(), mmd_model->GetUpdatePositions() + context.m_num_vertex);
+        f->m_normals.assign(mmd_model->GetUpdateNormals(),     mmd_model->GetUpdateNormals()   + context.m_num_vertex);
+        if(context.m_has_uv_morph) {
+            f->m_tex_coords.assign(mmd_model->GetUpdateUVs(), mmd_model->GetUpdateUVs() + context.m_num_vertex);
+        }
+        queue.push(f);
+    }
+    queue.close();
+    for(std::vector<std::thread>::iterator p = writers.begin(); p != writers.end(); p++) {
+        (*p).join();
+    }
+    if(context.m_vtc_file && fclose(context.m_vtc_file) != 0) {
+        context.m_num_failed++;
+    }
+    int num_frame = options.m_end_frame - options.m_start_frame + 1;
+    std::cout << "Baked " << (num_frame - context.m_num_failed) << "/" << num_frame << " frames of " << options.m_model_path << std::endl;
+    return context.m_num_failed ? 1 : 0;
+}
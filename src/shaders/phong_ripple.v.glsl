@@ -0,0 +1,48 @@
+// This file is part of dexvt-lite.
+// -- 3D Inverse Kinematics (Cyclic Coordinate Descent) with Constraints
+// Copyright (C) 2018 onlyuser <mailto:onlyuser@gmail.com>
+//
+// dexvt-lite is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// dexvt-lite is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with dexvt-lite.  If not, see <http://www.gnu.org/licenses/>.
+
+attribute vec3 vertex_position;
+uniform mat4 model_transform;
+uniform mat4 mvp_transform;
+uniform mat4 normal_transform;
+uniform vec3 camera_pos;
+uniform float ripple_amplitude;
+uniform vec3 ripple_origin;
+uniform float ripple_phase;
+uniform float ripple_wavelength;
+varying vec3 lerp_camera_vector;
+varying vec3 lerp_normal;
+varying vec3 lerp_position_world;
+
+void main(void) {
+    // same displacement as mesh_apply_ripple, normal from analytic height gradient
+    vec2 offset = vertex_position.xz - ripple_origin.xz;
+    float radius = length(offset);
+    float wave_number = 6.2831853/ripple_wavelength;
+    float angle = radius*wave_number + ripple_phase;
+    vec3 position = vec3(vertex_position.x, ripple_origin.y + sin(angle)*ripple_amplitude, vertex_position.z);
+    vec2 slope = offset*(cos(angle)*ripple_amplitude*wave_number/max(radius, 0.0001));
+    vec3 normal = normalize(vec3(-slope.x, 1, -slope.y));
+
+    lerp_normal = normalize(vec3(normal_transform*vec4(normal, 0)));
+
+    vec3 vertex_position_world = vec3(model_transform*vec4(position, 1));
+    lerp_position_world = vertex_position_world;
+    lerp_camera_vector = camera_pos - vertex_position_world;
+
+    gl_Position = mvp_transform*vec4(position, 1);
+}
\ No newline at end of file
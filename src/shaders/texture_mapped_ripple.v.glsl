@@ -0,0 +1,17 @@
+attribute vec2 texcoord;
+attribute vec3 vertex_position;
+uniform mat4 mvp_transform;
+uniform float ripple_amplitude;
+uniform vec3 ripple_origin;
+uniform float ripple_phase;
+uniform float ripple_wavelength;
+varying vec2 lerp_texcoord;
+
+void main(void) {
+    // same displacement as mesh_apply_ripple
+    float radius = length(vertex_position.xz - ripple_origin.xz);
+    float angle = radius*6.2831853/ripple_wavelength + ripple_phase;
+    vec3 position = vec3(vertex_position.x, ripple_origin.y + sin(angle)*ripple_amplitude, vertex_position.z);
+    gl_Position = mvp_transform*vec4(position, 1);
+    lerp_texcoord = texcoord;
+}
\ No newline at end of file
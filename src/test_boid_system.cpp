@@ -0,0 +1,192 @@
+// This file is part of dexvt-lite.
+// -- 3D Inverse Kinematics (Cyclic Coordinate Descent) with Constraints
+// Copyright (C) 2018 onlyuser <mailto:onlyuser@gmail.com>
+//
+// dexvt-lite is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// dexvt-lite is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with dexvt-lite.  If not, see <http://www.gnu.org/licenses/>.
+
+// spatial hash flocking checked against an all-pairs update, benchmarked at 1k / 10k / 100k boids
+
+#include <BoidSystem.h>
+#include <Light.h>
+#include <Util.h>
+#include <TestUtil.h>
+#include <glm/glm.hpp>
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <stdlib.h>
+
+#define NEIGHBOR_RADIUS   1
+#define SEPARATION_RADIUS 0.5
+#define MAX_SPEED         2
+#define DELTA_TIME        0.1
+#define NUM_TEST_BOIDS    1000
+#define NUM_TEST_STEPS    5
+#define NUM_BENCH_STEPS   10
+#define TOLERANCE         0.0001
+
+static float frand(float min, float max)
+{
+    return min + (max - min) * (static_cast<float>(rand()) / RAND_MAX);
+}
+
+// boids spread so that each has about density neighbors
+static void add_random_boids(vt::BoidSystem* boid_system, std::vector<vt::Light*>* objects, int n, float density)
+{
+    float world_size = pow(n * 4.19 / density, 1.0 / 3) * NEIGHBOR_RADIUS;
+    for(int i = 0; i < n; i++) {
+        vt::Light* object = new vt::Light("boid", glm::vec3(frand(0, world_size),
+                                                            frand(0, world_size),
+                                                            frand(0, world_size)));
+        objects->push_back(object);
+        boid_system->add_boid(object, glm::vec3(frand(-1, 1), frand(-1, 1), frand(-1, 1)));
+    }
+}
+
+static void delete_objects(std::vector<vt::Light*>* objects)
+{
+    for(std::vector<vt::Light*>::iterator p = objects->begin(); p != objects->end(); p++) {
+        delete *p;
+    }
+    objects->clear();
+}
+
+// same rules as BoidSystem::update_velocities, without the spatial hash
+static void update_all_pairs(std::vector<glm::vec3>* positions,
+                             std::vector<glm::vec3>* velocities,
+                             float                   separation_weight,
+                             float                   alignment_weight,
+                             float                   cohesion_weight,
+                             glm::vec3               target,
+                             float                   seek_weight)
+{
+    int n = positions->size();
+    std::vector<glm::vec3> new_velocities(n);
+    for(int i = 0; i < n; i++) {
+        glm::vec3 pos = (*positions)[i];
+        glm::vec3 separation(0);
+        glm::vec3 sum_velocity(0);
+        glm::vec3 sum_position(0);
+        int       num_neighbors = 0;
+        for(int j = 0; j < n; j++) {
+            if(j == i) {
+                continue;
+            }
+            glm::vec3 offset = pos - (*positions)[j];
+            float distance_squared = glm::dot(offset, offset);
+            if(distance_squared > NEIGHBOR_RADIUS * NEIGHBOR_RADIUS) {
+                continue;
+            }
+            if(distance_squared < SEPARATION_RADIUS * SEPARATION_RADIUS && distance_squared > EPSILON) {
+                separation += offset / distance_squared;
+            }
+            sum_velocity += (*velocities)[j];
+            sum_position += (*positions)[j];
+            num_neighbors++;
+        }
+        glm::vec3 velocity = (*velocities)[i];
+        glm::vec3 accel    = separation * separation_weight;
+        if(num_neighbors) {
+            accel += (sum_velocity / static_cast<float>(num_neighbors) - velocity) * alignment_weight;
+            accel += (sum_position / static_cast<float>(num_neighbors) - pos) * cohesion_weight;
+        }
+        accel += (target - pos) * seek_weight;
+        velocity += accel * static_cast<float>(DELTA_TIME);
+        float speed = glm::length(velocity);
+        if(speed > MAX_SPEED) {
+            velocity *= MAX_SPEED / speed;
+        }
+        new_velocities[i] = velocity;
+    }
+    velocities->swap(new_velocities);
+    for(int i = 0; i < n; i++) {
+        (*positions)[i] += (*velocities)[i] * static_cast<float>(DELTA_TIME);
+    }
+}
+
+static float max_distance(const std::vector<glm::vec3> &values1, const std::vector<glm::vec3> &values2)
+{
+    float result = 0;
+    for(int i = 0; i < static_cast<int>(std::min(values1.size(), values2.size())); i++) {
+        result = std::max(result, glm::distance(values1[i], values2[i]));
+    }
+    return result;
+}
+
+static void test_update()
+{
+    vt::BoidSystem boid_system(NEIGHBOR_RADIUS, SEPARATION_RADIUS, MAX_SPEED);
+    boid_system.set_weights(1.5, 1, 0.5);
+    boid_system.set_target(glm::vec3(5), 0.1);
+    std::vector<vt::Light*> objects;
+    add_random_boids(&boid_system, &objects, NUM_TEST_BOIDS, 8);
+    TEST_CHECK(boid_system.size() == NUM_TEST_BOIDS);
+
+    std::vector<glm::vec3> positions  = boid_system.get_positions();
+    std::vector<glm::vec3> velocities = boid_system.get_velocities();
+    float max_error = 0;
+    for(int step = 0; step < NUM_TEST_STEPS; step++) {
+        boid_system.update(DELTA_TIME);
+        update_all_pairs(&positions, &velocities, 1.5, 1, 0.5, glm::vec3(5), 0.1);
+        max_error = std::max(max_error, max_distance(boid_system.get_positions(), positions));
+        max_error = std::max(max_error, max_distance(boid_system.get_velocities(), velocities));
+    }
+    std::cout << "max error vs all-pairs update: " << max_error << std::endl;
+    TEST_CHECK(max_error < TOLERANCE);
+
+    // write_objects() / read_objects() round trip through the objects' origins
+    boid_system.write_objects();
+    TEST_CHECK(objects[0]->get_origin() == boid_system.get_positions()[0]);
+    objects[0]->set_origin(glm::vec3(-1));
+    boid_system.read_objects();
+    TEST_CHECK(boid_system.get_positions()[0] == glm::vec3(-1));
+
+    boid_system.clear();
+    TEST_CHECK(boid_system.size() == 0);
+    boid_system.update(DELTA_TIME);
+    delete_objects(&objects);
+}
+
+static void bench()
+{
+    int boid_counts[] = {1000, 10000, 100000};
+    for(int i = 0; i < 3; i++) {
+        vt::BoidSystem boid_system(NEIGHBOR_RADIUS, SEPARATION_RADIUS, MAX_SPEED);
+        std::vector<vt::Light*> objects;
+        add_random_boids(&boid_system, &objects, boid_counts[i], 8);
+        double update_ms = 0;
+        double write_ms  = 0;
+        for(int step = 0; step < NUM_BENCH_STEPS; step++) {
+            vt::BenchTimer update_timer;
+            boid_system.update(DELTA_TIME);
+            update_ms += update_timer.get_elapsed_ms();
+            vt::BenchTimer write_timer;
+            boid_system.write_objects();
+            write_ms += write_timer.get_elapsed_ms();
+        }
+        std::cout << boid_counts[i] << " boids: update " << update_ms / NUM_BENCH_STEPS << " ms/frame, "
+                  << "write_objects " << write_ms / NUM_BENCH_STEPS << " ms/frame" << std::endl;
+        delete_objects(&objects);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    srand(1);
+    test_update();
+    if(vt::test_bench_mode(argc, argv)) {
+        bench();
+    }
+    return vt::test_report("test_boid_system");
+}
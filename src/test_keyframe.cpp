@@ -0,0 +1,235 @@
+// This file is part of dexvt-lite.
+// -- 3D Inverse Kinematics (Cyclic Coordinate Descent) with Constraints
+// Copyright (C) 2018 onlyuser <mailto:onlyuser@gmail.com>
+//
+// dexvt-lite is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// dexvt-lite is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with dexvt-lite.  If not, see <http://www.gnu.org/licenses/>.
+
+// exported frame values checked against per-frame interpolation
+
+#include <KeyframeMgr.h>
+#include <Util.h>
+#include <TestUtil.h>
+#include <glm/glm.hpp>
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <stdlib.h>
+
+#define NUM_TEST_TRACKS   200
+#define NUM_BENCH_OBJECTS 100
+#define MAX_VALUE         100
+#define MAX_GAP           40
+#define LINEAR_TOLERANCE  0.000001 // relative to MAX_VALUE
+#define BEZIER_TOLERANCE  0.00001  // relative to MAX_VALUE
+
+static float frand(float min, float max)
+{
+    return min + (max - min) * (static_cast<float>(rand()) / RAND_MAX);
+}
+
+static glm::vec3 random_value()
+{
+    return glm::vec3(frand(-MAX_VALUE, MAX_VALUE),
+                     frand(-MAX_VALUE, MAX_VALUE),
+                     frand(-MAX_VALUE, MAX_VALUE));
+}
+
+static float max_distance(const std::vector<glm::vec3> &values1, const std::vector<glm::vec3> &values2)
+{
+    float result = 0;
+    for(int i = 0; i < static_cast<int>(std::min(values1.size(), values2.size())); i++) {
+        result = std::max(result, glm::distance(values1[i], values2[i]));
+    }
+    return result;
+}
+
+static void test_bezier_interpolate_n()
+{
+    float max_error = 0;
+    for(int i = 0; i < NUM_TEST_TRACKS; i++) {
+        glm::vec3 p1 = random_value();
+        glm::vec3 p2 = random_value();
+        glm::vec3 p3 = random_value();
+        glm::vec3 p4 = random_value();
+        int segment_length = 1 + rand() % MAX_GAP;
+        int start_index    = rand() % segment_length;
+        int n              = segment_length - start_index;
+        float alpha_step   = 1.0f / segment_length;
+        std::vector<glm::vec3> values(n);
+        std::vector<glm::vec3> expected_values(n);
+        vt::bezier_interpolate_n(p1, p2, p3, p4, start_index * alpha_step, alpha_step, n, &values[0]);
+        for(int j = 0; j < n; j++) {
+            expected_values[j] = vt::bezier_interpolate(p1, p2, p3, p4, (start_index + j) * alpha_step);
+        }
+        max_error = std::max(max_error, max_distance(values, expected_values));
+    }
+    std::cout << "bezier_interpolate_n max error: " << max_error << std::endl;
+    TEST_CHECK(max_error < MAX_VALUE * BEZIER_TOLERANCE);
+}
+
+static vt::MotionTrack* alloc_random_motion_track(int num_keyframes)
+{
+    vt::MotionTrack* motion_track = new vt::MotionTrack(vt::MotionTrack::MOTION_TYPE_ORIGIN);
+    int frame_number = rand() % MAX_GAP - MAX_GAP / 2;
+    for(int i = 0; i < num_keyframes; i++) {
+        motion_track->insert_keyframe(frame_number, new vt::Keyframe(random_value(), rand() % 2));
+        frame_number += 1 + rand() % MAX_GAP;
+    }
+    motion_track->update_control_points(frand(0.1, 0.5));
+    return motion_track;
+}
+
+// frames before, inside and after the keyframes, starting mid-segment
+static void test_motion_track()
+{
+    float max_error[2] = {0, 0};
+    for(int i = 0; i < NUM_TEST_TRACKS; i++) {
+        vt::MotionTrack* motion_track = alloc_random_motion_track(2 + rand() % 9);
+        int first_frame_number = 0;
+        int last_frame_number  = 0;
+        motion_track->get_frame_number_range(&first_frame_number, &last_frame_number);
+        int start_frame_number = first_frame_number - 5 + rand() % (last_frame_number - first_frame_number + 10);
+        int end_frame_number   = start_frame_number + rand() % (last_frame_number - start_frame_number + 10);
+        int n = end_frame_number - start_frame_number;
+        for(int is_smooth = 0; is_smooth < 2; is_smooth++) {
+            std::vector<glm::vec3> values(n + 1);
+            std::vector<glm::vec3> expected_values(n);
+            values[n] = glm::vec3(-1);
+            if(n) {
+                TEST_CHECK(motion_track->export_frame_values(start_frame_number, end_frame_number, &values[0], is_smooth));
+            }
+            TEST_CHECK(values[n] == glm::vec3(-1)); // nothing written past the end
+            for(int j = 0; j < n; j++) {
+                TEST_CHECK(motion_track->interpolate_frame_value(start_frame_number + j, &expected_values[j], is_smooth));
+            }
+            max_error[is_smooth] = std::max(max_error[is_smooth], max_distance(values, expected_values));
+        }
+        delete motion_track;
+    }
+    std::cout << "export_frame_values max error: " << max_error[0] << " (linear), "
+                                                   << max_error[1] << " (bezier)" << std::endl;
+    TEST_CHECK(max_error[0] < MAX_VALUE * LINEAR_TOLERANCE);
+    TEST_CHECK(max_error[1] < MAX_VALUE * BEZIER_TOLERANCE);
+
+    vt::MotionTrack empty_motion_track(vt::MotionTrack::MOTION_TYPE_ORIGIN);
+    glm::vec3 value;
+    TEST_CHECK(!empty_motion_track.export_frame_values(0, 1, &value));
+    TEST_CHECK(!empty_motion_track.export_frame_values(0, 1, NULL));
+}
+
+static void insert_random_keyframes(long object_id, vt::MotionTrack::motion_type_t motion_type, int num_keyframes)
+{
+    vt::KeyframeMgr* keyframe_mgr = vt::KeyframeMgr::instance();
+    int frame_number = rand() % MAX_GAP;
+    for(int i = 0; i < num_keyframes; i++) {
+        keyframe_mgr->insert_keyframe(object_id, motion_type, frame_number, new vt::Keyframe(random_value(), true));
+        frame_number += 1 + rand() % MAX_GAP;
+    }
+}
+
+// vector overload covers the object's frame range, same as the old per-frame loop
+static void test_keyframe_mgr()
+{
+    vt::KeyframeMgr* keyframe_mgr = vt::KeyframeMgr::instance();
+    keyframe_mgr->clear();
+    for(long object_id = 0; object_id < 10; object_id++) {
+        insert_random_keyframes(object_id, vt::MotionTrack::MOTION_TYPE_ORIGIN, 2 + rand() % 8);
+        insert_random_keyframes(object_id, vt::MotionTrack::MOTION_TYPE_EULER,  2 + rand() % 8);
+    }
+    keyframe_mgr->update_control_points(0.25);
+    for(long object_id = 0; object_id < 10; object_id++) {
+        int start_frame_number = 0;
+        int end_frame_number   = 0;
+        TEST_CHECK(keyframe_mgr->get_frame_number_range(object_id, &start_frame_number, &end_frame_number));
+        for(int is_smooth = 0; is_smooth < 2; is_smooth++) {
+            std::vector<glm::vec3> origins;
+            std::vector<glm::vec3> eulers;
+            TEST_CHECK(keyframe_mgr->export_frame_values_for_object(object_id, &origins, &eulers, NULL, is_smooth));
+            TEST_CHECK(static_cast<int>(origins.size()) == end_frame_number - start_frame_number);
+            TEST_CHECK(static_cast<int>(eulers.size()) == end_frame_number - start_frame_number);
+            std::vector<glm::vec3> expected_origins;
+            std::vector<glm::vec3> expected_eulers;
+            for(int frame_number = start_frame_number; frame_number < end_frame_number; frame_number++) {
+                glm::vec3 origin;
+                glm::vec3 euler;
+                keyframe_mgr->interpolate_frame_value_for_object(object_id, frame_number, &origin, &euler, NULL, is_smooth);
+                expected_origins.push_back(origin);
+                expected_eulers.push_back(euler);
+            }
+            TEST_CHECK(max_distance(origins, expected_origins) < MAX_VALUE * BEZIER_TOLERANCE);
+            TEST_CHECK(max_distance(eulers, expected_eulers) < MAX_VALUE * BEZIER_TOLERANCE);
+        }
+    }
+    std::vector<glm::vec3> origins;
+    TEST_CHECK(!keyframe_mgr->export_frame_values_for_object(-1, &origins, NULL, NULL));
+    keyframe_mgr->clear();
+}
+
+static void bench()
+{
+    vt::KeyframeMgr* keyframe_mgr = vt::KeyframeMgr::instance();
+    keyframe_mgr->clear();
+    for(long object_id = 0; object_id < NUM_BENCH_OBJECTS; object_id++) {
+        insert_random_keyframes(object_id, vt::MotionTrack::MOTION_TYPE_ORIGIN, 100);
+        insert_random_keyframes(object_id, vt::MotionTrack::MOTION_TYPE_EULER,  100);
+        insert_random_keyframes(object_id, vt::MotionTrack::MOTION_TYPE_SCALE,  100);
+    }
+    keyframe_mgr->update_control_points(0.25);
+    for(int is_smooth = 0; is_smooth < 2; is_smooth++) {
+        size_t num_frames = 0;
+        vt::BenchTimer per_frame_timer;
+        for(long object_id = 0; object_id < NUM_BENCH_OBJECTS; object_id++) {
+            int start_frame_number = 0;
+            int end_frame_number   = 0;
+            keyframe_mgr->get_frame_number_range(object_id, &start_frame_number, &end_frame_number);
+            std::vector<glm::vec3> origins;
+            std::vector<glm::vec3> eulers;
+            std::vector<glm::vec3> scales;
+            for(int frame_number = start_frame_number; frame_number < end_frame_number; frame_number++) {
+                glm::vec3 origin;
+                glm::vec3 euler;
+                glm::vec3 scale;
+                keyframe_mgr->interpolate_frame_value_for_object(object_id, frame_number, &origin, &euler, &scale, is_smooth);
+                origins.push_back(origin);
+                eulers.push_back(euler);
+                scales.push_back(scale);
+            }
+            num_frames += origins.size();
+        }
+        double per_frame_ms = per_frame_timer.get_elapsed_ms();
+        vt::BenchTimer export_timer;
+        for(long object_id = 0; object_id < NUM_BENCH_OBJECTS; object_id++) {
+            std::vector<glm::vec3> origins;
+            std::vector<glm::vec3> eulers;
+            std::vector<glm::vec3> scales;
+            keyframe_mgr->export_frame_values_for_object(object_id, &origins, &eulers, &scales, is_smooth);
+        }
+        double export_ms = export_timer.get_elapsed_ms();
+        std::cout << (is_smooth ? "bezier: " : "linear: ") << num_frames << " frames, "
+                  << "export " << export_ms << " ms (per-frame " << per_frame_ms << " ms)" << std::endl;
+    }
+    keyframe_mgr->clear();
+}
+
+int main(int argc, char** argv)
+{
+    srand(1);
+    test_bezier_interpolate_n();
+    test_motion_track();
+    test_keyframe_mgr();
+    if(vt::test_bench_mode(argc, argv)) {
+        bench();
+    }
+    return vt::test_report("test_keyframe");
+}
@@ -0,0 +1,273 @@
+// This file is part of dexvt-lite.
+// -- 3D Inverse Kinematics (Cyclic Coordinate Descent) with Constraints
+// Copyright (C) 2018 onlyuser <mailto:onlyuser@gmail.com>
+//
+// dexvt-lite is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// dexvt-lite is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with dexvt-lite.  If not, see <http://www.gnu.org/licenses/>.
+
+// Mesh::merge_all() checked against the old one-mesh-at-a-time merge, including self merges,
+// null entries and merges too large for GLushort indices
+
+#include <Mesh.h>
+#include <PrimitiveFactory.h>
+#include <TestUtil.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <iostream>
+#include <vector>
+#include <string>
+#include <float.h>
+
+#define MAX_NUM_VERTEX  0x10000 // triangle indices are GLushort
+#define NUM_BENCH_MESHES 200
+
+struct mesh_data_t
+{
+    std::vector<glm::vec3>  m_vert_coords;
+    std::vector<glm::vec3>  m_vert_normals;
+    std::vector<glm::vec3>  m_vert_tangents;
+    std::vector<glm::vec2>  m_tex_coords;
+    std::vector<glm::ivec3> m_tri_indices;
+};
+
+static void get_mesh_data(const vt::Mesh* mesh, mesh_data_t* mesh_data)
+{
+    mesh_data->m_vert_coords.resize(mesh->get_num_vertex());
+    mesh_data->m_vert_normals.resize(mesh->get_num_vertex());
+    mesh_data->m_vert_tangents.resize(mesh->get_num_vertex());
+    mesh_data->m_tex_coords.resize(mesh->get_num_vertex());
+    mesh_data->m_tri_indices.resize(mesh->get_num_tri());
+    for(int i = 0; i < static_cast<int>(mesh->get_num_vertex()); i++) {
+        mesh_data->m_vert_coords[i]   = mesh->get_vert_coord(i);
+        mesh_data->m_vert_normals[i]  = mesh->get_vert_normal(i);
+        mesh_data->m_vert_tangents[i] = mesh->get_vert_tangent(i);
+        mesh_data->m_tex_coords[i]    = mesh->get_tex_coord(i);
+    }
+    for(int j = 0; j < static_cast<int>(mesh->get_num_tri()); j++) {
+        mesh_data->m_tri_indices[j] = mesh->get_tri_indices(j);
+    }
+}
+
+static void set_mesh_data(vt::Mesh* mesh, const mesh_data_t &mesh_data)
+{
+    mesh->resize(mesh_data.m_vert_coords.size(), mesh_data.m_tri_indices.size());
+    for(int i = 0; i < static_cast<int>(mesh_data.m_vert_coords.size()); i++) {
+        mesh->set_vert_coord(i,   mesh_data.m_vert_coords[i]);
+        mesh->set_vert_normal(i,  mesh_data.m_vert_normals[i]);
+        mesh->set_vert_tangent(i, mesh_data.m_vert_tangents[i]);
+        mesh->set_tex_coord(i,    mesh_data.m_tex_coords[i]);
+    }
+    for(int j = 0; j < static_cast<int>(mesh_data.m_tri_indices.size()); j++) {
+        mesh->set_tri_indices(j, mesh_data.m_tri_indices[j]);
+    }
+    mesh->update_bbox();
+}
+
+// the old path: append one mesh, offset its indices, then recompute the bbox over everything
+// (tex coords were left uninitialized unless copied, so they are zeroed here)
+static void old_merge(mesh_data_t* mesh_data, const mesh_data_t &other_mesh_data, bool copy_tex_coords)
+{
+    int vert_offset = mesh_data->m_vert_coords.size();
+    mesh_data->m_vert_coords.insert(mesh_data->m_vert_coords.end(),     other_mesh_data.m_vert_coords.begin(),   other_mesh_data.m_vert_coords.end());
+    mesh_data->m_vert_normals.insert(mesh_data->m_vert_normals.end(),   other_mesh_data.m_vert_normals.begin(),  other_mesh_data.m_vert_normals.end());
+    mesh_data->m_vert_tangents.insert(mesh_data->m_vert_tangents.end(), other_mesh_data.m_vert_tangents.begin(), other_mesh_data.m_vert_tangents.end());
+    if(copy_tex_coords) {
+        mesh_data->m_tex_coords.insert(mesh_data->m_tex_coords.end(), other_mesh_data.m_tex_coords.begin(), other_mesh_data.m_tex_coords.end());
+    } else {
+        mesh_data->m_tex_coords.resize(mesh_data->m_vert_coords.size(), glm::vec2(0));
+    }
+    for(std::vector<glm::ivec3>::const_iterator p = other_mesh_data.m_tri_indices.begin(); p != other_mesh_data.m_tri_indices.end(); p++) {
+        mesh_data->m_tri_indices.push_back(*p + glm::ivec3(vert_offset));
+    }
+}
+
+// bbox over vertices referenced by triangles, as Mesh::update_bbox() computes it
+static void get_reference_min_max(const mesh_data_t &mesh_data, glm::vec3* min, glm::vec3* max)
+{
+    *min = glm::vec3(FLT_MAX);
+    *max = glm::vec3(-FLT_MAX);
+    for(std::vector<glm::ivec3>::const_iterator p = mesh_data.m_tri_indices.begin(); p != mesh_data.m_tri_indices.end(); p++) {
+        for(int j = 0; j < 3; j++) {
+            *min = glm::min(*min, mesh_data.m_vert_coords[(*p)[j]]);
+            *max = glm::max(*max, mesh_data.m_vert_coords[(*p)[j]]);
+        }
+    }
+}
+
+// tex coords only compared over the first num_tex_coords vertices, the rest are unspecified unless copied
+static bool is_same_mesh(const vt::Mesh* mesh, const mesh_data_t &expected_mesh_data, size_t num_tex_coords)
+{
+    mesh_data_t mesh_data;
+    get_mesh_data(mesh, &mesh_data);
+    if(mesh_data.m_vert_coords   != expected_mesh_data.m_vert_coords ||
+       mesh_data.m_vert_normals  != expected_mesh_data.m_vert_normals ||
+       mesh_data.m_vert_tangents != expected_mesh_data.m_vert_tangents ||
+       mesh_data.m_tri_indices   != expected_mesh_data.m_tri_indices) {
+        return false;
+    }
+    for(int i = 0; i < static_cast<int>(num_tex_coords); i++) {
+        if(mesh_data.m_tex_coords[i] != expected_mesh_data.m_tex_coords[i]) {
+            return false;
+        }
+    }
+    glm::vec3 min, max, expected_min, expected_max;
+    mesh->get_min_max(&min, &max);
+    get_reference_min_max(expected_mesh_data, &expected_min, &expected_max);
+    return min == expected_min && max == expected_max;
+}
+
+// primitives spread out, so the merged bbox is a union of disjoint boxes
+static std::vector<vt::Mesh*> create_meshes()
+{
+    std::vector<vt::Mesh*> meshes;
+    meshes.push_back(vt::PrimitiveFactory::create_sphere("sphere", 8, 6));
+    meshes.push_back(vt::PrimitiveFactory::create_cylinder("cylinder", 8));
+    meshes.push_back(vt::PrimitiveFactory::create_torus("torus", 8, 6));
+    meshes.push_back(vt::PrimitiveFactory::create_grid("grid", 4, 4));
+    for(int i = 0; i < static_cast<int>(meshes.size()); i++) {
+        meshes[i]->transform_vertices(glm::translate(glm::mat4(1), glm::vec3(i * 3, -i, i * 2)));
+    }
+    return meshes;
+}
+
+static void test_merge()
+{
+    std::vector<vt::Mesh*> meshes = create_meshes();
+    for(int copy_tex_coords = 0; copy_tex_coords < 2; copy_tex_coords++) {
+        std::string suffix = copy_tex_coords ? " (tex coords)" : "";
+
+        // several meshes and null entries at once match merging one at a time
+        vt::Mesh* box = vt::PrimitiveFactory::create_box("box");
+        mesh_data_t expected_mesh_data;
+        get_mesh_data(box, &expected_mesh_data);
+        size_t num_box_vertex = box->get_num_vertex();
+        std::vector<const vt::MeshBase*> others;
+        others.push_back(NULL);
+        for(std::vector<vt::Mesh*>::iterator p = meshes.begin(); p != meshes.end(); p++) {
+            others.push_back(*p);
+            others.push_back(NULL);
+            mesh_data_t other_mesh_data;
+            get_mesh_data(*p, &other_mesh_data);
+            old_merge(&expected_mesh_data, other_mesh_data, copy_tex_coords);
+        }
+        box->merge_all(others, copy_tex_coords);
+        std::cout << "box + " << meshes.size() << " meshes" << suffix << ": " << box->get_num_vertex() << " vertices, "
+                  << box->get_num_tri() << " triangles" << std::endl;
+        TEST_CHECK(is_same_mesh(box, expected_mesh_data, copy_tex_coords ? box->get_num_vertex() : num_box_vertex));
+        delete box;
+
+        // into an empty mesh, the bbox comes only from the merged meshes
+        vt::Mesh* empty = new vt::Mesh("empty", 0, 0);
+        mesh_data_t expected_empty_mesh_data;
+        for(std::vector<vt::Mesh*>::iterator q = meshes.begin(); q != meshes.end(); q++) {
+            mesh_data_t other_mesh_data;
+            get_mesh_data(*q, &other_mesh_data);
+            old_merge(&expected_empty_mesh_data, other_mesh_data, copy_tex_coords);
+        }
+        empty->merge_all(std::vector<const vt::MeshBase*>(meshes.begin(), meshes.end()), copy_tex_coords);
+        TEST_CHECK(is_same_mesh(empty, expected_empty_mesh_data, copy_tex_coords ? empty->get_num_vertex() : 0));
+        delete empty;
+
+        // the mesh itself, twice, doubles from its own pre-merge contents each time
+        vt::Mesh* self = vt::PrimitiveFactory::create_box("self");
+        self->transform_vertices(glm::translate(glm::mat4(1), glm::vec3(1, 2, 3)));
+        mesh_data_t self_mesh_data;
+        get_mesh_data(self, &self_mesh_data);
+        mesh_data_t expected_self_mesh_data = self_mesh_data;
+        old_merge(&expected_self_mesh_data, self_mesh_data, copy_tex_coords);
+        old_merge(&expected_self_mesh_data, self_mesh_data, copy_tex_coords);
+        self->merge_all(std::vector<const vt::MeshBase*>(2, self), copy_tex_coords);
+        std::cout << "self x 3" << suffix << ": " << self->get_num_vertex() << " vertices, " << self->get_num_tri() << " triangles" << std::endl;
+        TEST_CHECK(self->get_num_vertex() == self_mesh_data.m_vert_coords.size() * 3);
+        TEST_CHECK(is_same_mesh(self, expected_self_mesh_data, copy_tex_coords ? self->get_num_vertex() : self_mesh_data.m_vert_coords.size()));
+        delete self;
+    }
+
+    // nothing but null entries leaves the mesh untouched
+    vt::Mesh* box = vt::PrimitiveFactory::create_box("box");
+    mesh_data_t box_mesh_data;
+    get_mesh_data(box, &box_mesh_data);
+    box->merge_all(std::vector<const vt::MeshBase*>(3, static_cast<const vt::MeshBase*>(NULL)), true);
+    TEST_CHECK(is_same_mesh(box, box_mesh_data, box->get_num_vertex()));
+    delete box;
+
+    // up to MAX_NUM_VERTEX vertices merge, one more is refused and leaves the mesh untouched
+    vt::Mesh* half = vt::PrimitiveFactory::create_grid("half", 1, 1);
+    mesh_data_t half_mesh_data;
+    get_mesh_data(half, &half_mesh_data);
+    half_mesh_data.m_vert_coords.resize(MAX_NUM_VERTEX / 2, glm::vec3(1));
+    half_mesh_data.m_vert_normals.resize(MAX_NUM_VERTEX / 2, glm::vec3(0, 1, 0));
+    half_mesh_data.m_vert_tangents.resize(MAX_NUM_VERTEX / 2, glm::vec3(1, 0, 0));
+    half_mesh_data.m_tex_coords.resize(MAX_NUM_VERTEX / 2, glm::vec2(0));
+    half_mesh_data.m_tri_indices.push_back(glm::ivec3(MAX_NUM_VERTEX / 2 - 3, MAX_NUM_VERTEX / 2 - 2, MAX_NUM_VERTEX / 2 - 1));
+    set_mesh_data(half, half_mesh_data);
+    mesh_data_t expected_full_mesh_data = half_mesh_data;
+    old_merge(&expected_full_mesh_data, half_mesh_data, true);
+    half->merge(half, true);
+    TEST_CHECK(half->get_num_vertex() == MAX_NUM_VERTEX);
+    TEST_CHECK(is_same_mesh(half, expected_full_mesh_data, half->get_num_vertex()));
+    TEST_CHECK(half->get_tri_indices(half->get_num_tri() - 1) == glm::ivec3(MAX_NUM_VERTEX - 3, MAX_NUM_VERTEX - 2, MAX_NUM_VERTEX - 1));
+    vt::Mesh* one_more = vt::PrimitiveFactory::create_grid("one_more", 1, 1);
+    one_more->resize(1, 0);
+    one_more->set_vert_coord(0, glm::vec3(0));
+    half->merge(one_more);
+    TEST_CHECK(half->get_num_vertex() == MAX_NUM_VERTEX);
+    TEST_CHECK(is_same_mesh(half, expected_full_mesh_data, half->get_num_vertex()));
+    delete one_more;
+    delete half;
+
+    for(std::vector<vt::Mesh*>::iterator r = meshes.begin(); r != meshes.end(); r++) {
+        delete *r;
+    }
+}
+
+static void bench()
+{
+    std::vector<vt::Mesh*> meshes = create_meshes();
+    std::vector<const vt::MeshBase*> others;
+    std::vector<mesh_data_t> others_mesh_data(meshes.size());
+    for(int i = 0; i < static_cast<int>(meshes.size()); i++) {
+        get_mesh_data(meshes[i], &others_mesh_data[i]);
+    }
+    for(int j = 0; j < NUM_BENCH_MESHES; j++) {
+        others.push_back(meshes[j % meshes.size()]);
+    }
+    vt::Mesh* mesh = new vt::Mesh("merged", 0, 0);
+    vt::BenchTimer timer;
+    mesh->merge_all(others, true);
+    double new_ms = timer.get_elapsed_ms();
+    vt::Mesh* old_mesh = new vt::Mesh("old_merged", 0, 0);
+    mesh_data_t old_mesh_data;
+    vt::BenchTimer old_timer;
+    for(int k = 0; k < NUM_BENCH_MESHES; k++) {
+        old_merge(&old_mesh_data, others_mesh_data[k % meshes.size()], true);
+        set_mesh_data(old_mesh, old_mesh_data); // the old path reallocated and recomputed the bbox every merge
+    }
+    double old_ms = old_timer.get_elapsed_ms();
+    std::cout << NUM_BENCH_MESHES << " meshes, " << mesh->get_num_vertex() << " vertices, " << mesh->get_num_tri() << " triangles: "
+              << new_ms << " ms (old path " << old_ms << " ms)" << std::endl;
+    delete mesh;
+    delete old_mesh;
+    for(std::vector<vt::Mesh*>::iterator p = meshes.begin(); p != meshes.end(); p++) {
+        delete *p;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    test_merge();
+    if(vt::test_bench_mode(argc, argv)) {
+        bench();
+    }
+    return vt::test_report("test_merge");
+}
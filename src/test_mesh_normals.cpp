@@ -0,0 +1,349 @@
+// This file is part of dexvt-lite.
+// -- 3D Inverse Kinematics (Cyclic Coordinate Descent) with Constraints
+// Copyright (C) 2018 onlyuser <mailto:onlyuser@gmail.com>
+//
+// dexvt-lite is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// dexvt-lite is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with dexvt-lite.  If not, see <http://www.gnu.org/licenses/>.
+
+// Mesh::update_normals_and_tangents() checked against serial per-triangle versions of the old and new math,
+// and Mesh::transform_vertices() checked for normals and bbox under non-uniform scale
+
+#include <Mesh.h>
+#include <PrimitiveFactory.h>
+#include <Util.h>
+#include <TestUtil.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <iostream>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <math.h>
+#include <float.h>
+
+#define TOLERANCE             0.0001
+#define MIN_AREA              0.000001
+#define MAX_FLAT_ANGLE_DIFF   0.1 // degrees, edges normalized before cross product in old path
+#define MAX_SMOOTH_ANGLE_DIFF 15  // degrees, unweighted vs area-weighted normals
+#define NUM_FAN_TRIS          4
+#define NUM_BENCH_ITERS       10
+#define UNREFERENCED_COORD    100 // far outside the mesh, so it would show up in the bbox
+
+// the old path: unit face normals, summed if smooth, first edge as tangent if flat
+// normals touched by degenerate triangles are left NaN, the old path turned those into noise
+static void old_update_normals_and_tangents(const vt::Mesh*         mesh,
+                                            std::vector<glm::vec3>* normals,
+                                            std::vector<glm::vec3>* tangents)
+{
+    normals->assign(mesh->get_num_vertex(), glm::vec3(0));
+    tangents->assign(mesh->get_num_vertex(), glm::vec3(0));
+    std::vector<bool> is_degenerate(mesh->get_num_vertex(), false);
+    for(int i = 0; i < static_cast<int>(mesh->get_num_tri()); i++) {
+        glm::ivec3 tri_indices = mesh->get_tri_indices(i);
+        glm::vec3 p0 = mesh->get_vert_coord(tri_indices[0]);
+        glm::vec3 p1 = mesh->get_vert_coord(tri_indices[1]);
+        glm::vec3 p2 = mesh->get_vert_coord(tri_indices[2]);
+        glm::vec3 e1 = glm::normalize(p1 - p0);
+        glm::vec3 e2 = glm::normalize(p2 - p0);
+        glm::vec3 n = glm::normalize(glm::cross(e1, e2));
+        bool is_degenerate_tri = glm::length(glm::cross(p1 - p0, p2 - p0)) < MIN_AREA;
+        for(int j = 0; j < 3; j++) {
+            int vert_index = tri_indices[j];
+            is_degenerate[vert_index] = is_degenerate[vert_index] || is_degenerate_tri;
+            if(mesh->is_smooth()) {
+                (*normals)[vert_index] += n;
+            } else {
+                (*normals)[vert_index]  = n;
+                (*tangents)[vert_index] = e1;
+            }
+        }
+    }
+    if(mesh->is_smooth()) {
+        for(int k = 0; k < static_cast<int>(mesh->get_num_vertex()); k++) {
+            (*normals)[k] = glm::normalize((*normals)[k]);
+        }
+    }
+    for(int k = 0; k < static_cast<int>(mesh->get_num_vertex()); k++) {
+        if(is_degenerate[k]) {
+            (*normals)[k] = glm::vec3(NAN);
+        }
+    }
+}
+
+// the new math, written as a serial scatter over triangles
+// areas are twice the area the normal comes from (zero if unreferenced)
+static void reference_update_normals_and_tangents(const vt::Mesh*         mesh,
+                                                  std::vector<glm::vec3>* normals,
+                                                  std::vector<glm::vec3>* tangents,
+                                                  std::vector<float>*     areas)
+{
+    normals->assign(mesh->get_num_vertex(), glm::vec3(0));
+    tangents->assign(mesh->get_num_vertex(), glm::vec3(0));
+    areas->assign(mesh->get_num_vertex(), 0);
+    for(int i = 0; i < static_cast<int>(mesh->get_num_tri()); i++) {
+        glm::ivec3 tri_indices = mesh->get_tri_indices(i);
+        glm::vec3 e1   = mesh->get_vert_coord(tri_indices[1]) - mesh->get_vert_coord(tri_indices[0]);
+        glm::vec3 e2   = mesh->get_vert_coord(tri_indices[2]) - mesh->get_vert_coord(tri_indices[0]);
+        glm::vec2 duv1 = mesh->get_tex_coord(tri_indices[1]) - mesh->get_tex_coord(tri_indices[0]);
+        glm::vec2 duv2 = mesh->get_tex_coord(tri_indices[2]) - mesh->get_tex_coord(tri_indices[0]);
+        glm::vec3 n = glm::cross(e1, e2); // area-weighted
+        float uv_det = duv1.x * duv2.y - duv2.x * duv1.y;
+        glm::vec3 t = uv_det ? (e1 * duv2.y - e2 * duv1.y) / uv_det : e1;
+        for(int j = 0; j < 3; j++) {
+            int vert_index = tri_indices[j];
+            if(mesh->is_smooth()) {
+                (*normals)[vert_index]  += n;
+                (*tangents)[vert_index] += t;
+                (*areas)[vert_index]    += glm::length(n);
+            } else {
+                (*normals)[vert_index]  = n;
+                (*tangents)[vert_index] = t;
+                (*areas)[vert_index]    = glm::length(n);
+            }
+        }
+    }
+    for(int k = 0; k < static_cast<int>(mesh->get_num_vertex()); k++) {
+        glm::vec3 &normal  = (*normals)[k];
+        glm::vec3 &tangent = (*tangents)[k];
+        normal   = glm::normalize(normal);
+        tangent -= normal * glm::dot(normal, tangent);
+        tangent  = glm::normalize(tangent);
+    }
+}
+
+static float angle_diff(glm::vec3 v1, glm::vec3 v2)
+{
+    return glm::degrees(acos(glm::clamp(glm::dot(glm::normalize(v1), glm::normalize(v2)), -1.0f, 1.0f)));
+}
+
+static bool is_finite(glm::vec3 v)
+{
+    return std::isfinite(v.x) && std::isfinite(v.y) && std::isfinite(v.z);
+}
+
+static void check_mesh(vt::Mesh* mesh, std::string name)
+{
+    for(int is_smooth = 0; is_smooth < 2; is_smooth++) {
+        mesh->set_smooth(is_smooth);
+        mesh->update_normals_and_tangents();
+        std::vector<glm::vec3> old_normals;
+        std::vector<glm::vec3> old_tangents;
+        std::vector<glm::vec3> expected_normals;
+        std::vector<glm::vec3> expected_tangents;
+        std::vector<float>     areas;
+        old_update_normals_and_tangents(mesh, &old_normals, &old_tangents);
+        reference_update_normals_and_tangents(mesh, &expected_normals, &expected_tangents, &areas);
+        float max_error     = 0;
+        float max_old_angle = 0;
+        for(int i = 0; i < static_cast<int>(mesh->get_num_vertex()); i++) {
+            if(areas[i] < MIN_AREA) {
+                continue; // unreferenced, or normal only from degenerate triangles (e.g. sphere poles)
+            }
+            glm::vec3 normal  = mesh->get_vert_normal(i);
+            glm::vec3 tangent = mesh->get_vert_tangent(i);
+            max_error = std::max(max_error, glm::distance(normal,  expected_normals[i]));
+            max_error = std::max(max_error, glm::distance(tangent, expected_tangents[i]));
+            TEST_CHECK(fabs(glm::length(normal) - 1) < TOLERANCE);
+            TEST_CHECK(fabs(glm::length(tangent) - 1) < TOLERANCE);
+            TEST_CHECK(fabs(glm::dot(normal, tangent)) < TOLERANCE);
+            if(is_finite(old_normals[i])) {
+                max_old_angle = std::max(max_old_angle, angle_diff(normal, old_normals[i]));
+            }
+        }
+        std::cout << name << (is_smooth ? " (smooth)" : " (flat)") << ": max error " << max_error
+                  << ", max normal angle vs old path " << max_old_angle << " deg" << std::endl;
+        TEST_CHECK(max_error < TOLERANCE);
+
+        // flat normals don't depend on weighting, smooth ones only differ where face areas differ
+        TEST_CHECK(max_old_angle < (is_smooth ? MAX_SMOOTH_ANGLE_DIFF : MAX_FLAT_ANGLE_DIFF));
+    }
+}
+
+// a bumpy grid, so neighboring faces have different areas and normals
+static vt::Mesh* create_bumpy_grid(int cols, int rows)
+{
+    vt::Mesh* mesh = vt::PrimitiveFactory::create_grid("bumpy_grid", cols, rows, 10, 10);
+    for(int i = 0; i < static_cast<int>(mesh->get_num_vertex()); i++) {
+        glm::vec3 pos = mesh->get_vert_coord(i);
+        pos.y = sin(pos.x * 2) * cos(pos.z * 3) * 0.5;
+        mesh->set_vert_coord(i, pos);
+    }
+    return mesh;
+}
+
+static void test_primitives()
+{
+    std::vector<std::pair<std::string, vt::Mesh*> > meshes;
+    meshes.push_back(std::make_pair("grid",       vt::PrimitiveFactory::create_grid("grid", 8, 8)));
+    meshes.push_back(std::make_pair("bumpy_grid", create_bumpy_grid(32, 32)));
+    meshes.push_back(std::make_pair("sphere",     vt::PrimitiveFactory::create_sphere("sphere", 16, 12)));
+    meshes.push_back(std::make_pair("cylinder",   vt::PrimitiveFactory::create_cylinder("cylinder", 16)));
+    meshes.push_back(std::make_pair("torus",      vt::PrimitiveFactory::create_torus("torus", 16, 12)));
+    meshes.push_back(std::make_pair("box",        vt::PrimitiveFactory::create_box("box")));
+    meshes.push_back(std::make_pair("geosphere",  vt::PrimitiveFactory::create_geosphere("geosphere", 1, 2)));
+    for(std::vector<std::pair<std::string, vt::Mesh*> >::iterator p = meshes.begin(); p != meshes.end(); p++) {
+        check_mesh((*p).second, (*p).first);
+        delete (*p).second;
+    }
+
+    // a corner between two perpendicular faces of equal area, one of them fanned into more triangles,
+    // gets the bisecting normal when area-weighted regardless of how the faces are split
+    vt::Mesh* corner = new vt::Mesh("corner", 2 + NUM_FAN_TRIS + 1, 1 + NUM_FAN_TRIS);
+    corner->set_vert_coord(0, glm::vec3(0, 0, 0));
+    corner->set_vert_coord(1, glm::vec3(1, 0, 0));
+    for(int i = 0; i <= NUM_FAN_TRIS; i++) {
+        float alpha = static_cast<float>(i) / NUM_FAN_TRIS;
+        corner->set_vert_coord(2 + i, glm::vec3(0, 1 - alpha, alpha));
+    }
+    corner->set_tri_indices(0, glm::ivec3(0, 2 + NUM_FAN_TRIS, 1)); // y = 0 face
+    for(int i = 0; i < NUM_FAN_TRIS; i++) {
+        corner->set_tri_indices(1 + i, glm::ivec3(0, 2 + i, 3 + i)); // x = 0 face
+    }
+    corner->set_smooth(true);
+    corner->update_normals_and_tangents();
+    std::vector<glm::vec3> old_normals;
+    std::vector<glm::vec3> old_tangents;
+    old_update_normals_and_tangents(corner, &old_normals, &old_tangents);
+    float corner_angle     = angle_diff(corner->get_vert_normal(0), glm::vec3(1, 1, 0));
+    float old_corner_angle = angle_diff(old_normals[0],             glm::vec3(1, 1, 0));
+    std::cout << "corner (smooth): normal angle vs bisector " << corner_angle << " deg"
+              << " (old path " << old_corner_angle << " deg)" << std::endl;
+    TEST_CHECK(corner_angle < MAX_FLAT_ANGLE_DIFF);
+    delete corner;
+
+    // adjacency is rebuilt after the triangles change
+    vt::Mesh* grid = vt::PrimitiveFactory::create_grid("grid", 2, 2);
+    grid->set_smooth(true);
+    grid->update_normals_and_tangents();
+    grid->resize(grid->get_num_vertex(), grid->get_num_tri() - 1, true);
+    check_mesh(grid, "grid (one triangle removed)");
+    delete grid;
+}
+
+// every triangle gets its own vertices, so flat normals are exact face normals,
+// plus one vertex no triangle uses
+static vt::Mesh* create_unwelded_grid(int cols, int rows)
+{
+    vt::Mesh* grid = create_bumpy_grid(cols, rows);
+    int num_tri = grid->get_num_tri();
+    vt::Mesh* mesh = new vt::Mesh("unwelded_grid", num_tri * 3 + 1, num_tri);
+    for(int i = 0; i < num_tri; i++) {
+        glm::ivec3 tri_indices = grid->get_tri_indices(i);
+        for(int j = 0; j < 3; j++) {
+            mesh->set_vert_coord(i * 3 + j, grid->get_vert_coord(tri_indices[j]));
+            mesh->set_tex_coord(i * 3 + j,  grid->get_tex_coord(tri_indices[j]));
+        }
+        mesh->set_tri_indices(i, glm::ivec3(i * 3, i * 3 + 1, i * 3 + 2));
+    }
+    mesh->set_vert_coord(num_tri * 3, glm::vec3(UNREFERENCED_COORD));
+    delete grid;
+    return mesh;
+}
+
+// non-uniform scale with translation: normals need the inverse transpose, bbox skips unreferenced vertices
+static void test_transform()
+{
+    vt::Mesh* mesh = create_unwelded_grid(8, 8);
+    mesh->set_smooth(false);
+    mesh->update_normals_and_tangents();
+    glm::mat4 transform = glm::translate(glm::mat4(1), glm::vec3(3, -2, 5)) *
+                          glm::rotate(glm::mat4(1), glm::radians(30.0f), glm::vec3(0, 0, 1)) *
+                          glm::scale(glm::mat4(1), glm::vec3(4, 0.25, 2));
+    glm::vec3 expected_min(FLT_MAX);
+    glm::vec3 expected_max(-FLT_MAX);
+    std::vector<glm::vec3> old_normals(mesh->get_num_vertex());
+    for(int i = 0; i < static_cast<int>(mesh->get_num_vertex()) - 1; i++) {
+        glm::vec3 pos = glm::vec3(transform * glm::vec4(mesh->get_vert_coord(i), 1));
+        expected_min = glm::min(expected_min, pos);
+        expected_max = glm::max(expected_max, pos);
+        old_normals[i] = glm::normalize(glm::vec3(transform * glm::vec4(mesh->get_vert_normal(i), 0))); // old path
+    }
+    mesh->transform_vertices(transform);
+    float max_dot     = 0;
+    float max_old_dot = 0;
+    for(int i = 0; i < static_cast<int>(mesh->get_num_tri()); i++) {
+        glm::ivec3 tri_indices = mesh->get_tri_indices(i);
+        glm::vec3 p0 = mesh->get_vert_coord(tri_indices[0]);
+        glm::vec3 p1 = mesh->get_vert_coord(tri_indices[1]);
+        glm::vec3 p2 = mesh->get_vert_coord(tri_indices[2]);
+        glm::vec3 e1 = glm::normalize(p1 - p0);
+        glm::vec3 e2 = glm::normalize(p2 - p0);
+        glm::vec3 face_normal = glm::cross(p1 - p0, p2 - p0);
+        for(int j = 0; j < 3; j++) {
+            glm::vec3 normal  = mesh->get_vert_normal(tri_indices[j]);
+            glm::vec3 tangent = mesh->get_vert_tangent(tri_indices[j]);
+            max_dot     = std::max(max_dot,     std::max(fabs(glm::dot(normal, e1)), fabs(glm::dot(normal, e2))));
+            max_old_dot = std::max(max_old_dot, fabs(glm::dot(old_normals[tri_indices[j]], e1)));
+            TEST_CHECK(glm::dot(normal, face_normal) > 0); // still facing the same side
+            TEST_CHECK(fabs(glm::length(normal) - 1) < TOLERANCE);
+            TEST_CHECK(fabs(glm::length(tangent) - 1) < TOLERANCE);
+            TEST_CHECK(fabs(glm::dot(normal, tangent)) < TOLERANCE);
+        }
+    }
+    std::cout << "transform: max |normal . edge| " << max_dot << " (old path " << max_old_dot << ")" << std::endl;
+    TEST_CHECK(max_dot < TOLERANCE);
+    glm::vec3 min, max;
+    mesh->get_min_max(&min, &max);
+    TEST_CHECK(glm::distance(min, expected_min) < TOLERANCE);
+    TEST_CHECK(glm::distance(max, expected_max) < TOLERANCE);
+    delete mesh;
+}
+
+static void bench_mesh(vt::Mesh* mesh, std::string name)
+{
+    std::vector<glm::vec3> normals;
+    std::vector<glm::vec3> tangents;
+    std::vector<float>     areas;
+    for(int is_smooth = 0; is_smooth < 2; is_smooth++) {
+        mesh->set_smooth(is_smooth);
+        mesh->update_normals_and_tangents(); // builds adjacency
+        vt::BenchTimer timer;
+        for(int i = 0; i < NUM_BENCH_ITERS; i++) {
+            mesh->update_normals_and_tangents();
+        }
+        double new_ms = timer.get_elapsed_ms() / NUM_BENCH_ITERS;
+        vt::BenchTimer old_timer;
+        for(int i = 0; i < NUM_BENCH_ITERS; i++) {
+            old_update_normals_and_tangents(mesh, &normals, &tangents);
+        }
+        double old_ms = old_timer.get_elapsed_ms() / NUM_BENCH_ITERS;
+        vt::BenchTimer reference_timer;
+        for(int i = 0; i < NUM_BENCH_ITERS; i++) {
+            reference_update_normals_and_tangents(mesh, &normals, &tangents, &areas);
+        }
+        double reference_ms = reference_timer.get_elapsed_ms() / NUM_BENCH_ITERS;
+        std::cout << name << (is_smooth ? " (smooth)" : " (flat)") << ", "
+                  << mesh->get_num_vertex() << " vertices, " << mesh->get_num_tri() << " triangles: "
+                  << new_ms << " ms (old path " << old_ms << " ms, serial reference " << reference_ms << " ms)" << std::endl;
+    }
+}
+
+static void bench()
+{
+    vt::Mesh* grid = create_bumpy_grid(250, 250);
+    bench_mesh(grid, "bumpy_grid");
+    delete grid;
+    vt::Mesh* sphere = vt::PrimitiveFactory::create_sphere("sphere", 250, 250);
+    bench_mesh(sphere, "sphere");
+    delete sphere;
+}
+
+int main(int argc, char** argv)
+{
+    test_primitives();
+    test_transform();
+    if(vt::test_bench_mode(argc, argv)) {
+        bench();
+    }
+    return vt::test_report("test_mesh_normals");
+}
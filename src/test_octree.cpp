@@ -0,0 +1,342 @@
+// This file is part of dexvt-lite.
+// -- 3D Inverse Kinematics (Cyclic Coordinate Descent) with Constraints
+// Copyright (C) 2018 onlyuser <mailto:onlyuser@gmail.com>
+//
+// dexvt-lite is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// dexvt-lite is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with dexvt-lite.  If not, see <http://www.gnu.org/licenses/>.
+
+// Octree queries checked against a brute-force scan over the same boxes
+
+#include <Octree.h>
+#include <Util.h>
+#include <TestUtil.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <iostream>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <stdlib.h>
+
+#define WORLD_SIZE        100
+#define TREE_DEPTH        5
+#define NUM_TEST_OBJECTS  2000
+#define NUM_BENCH_OBJECTS 100000
+#define NUM_QUERIES       50
+
+struct box_t
+{
+    glm::vec3 m_min;
+    glm::vec3 m_max;
+};
+
+typedef std::map<long, box_t> boxes_t;
+
+static float frand(float min, float max)
+{
+    return min + (max - min) * (static_cast<float>(rand()) / RAND_MAX);
+}
+
+// mostly small boxes, a few large ones, some sticking out of the root if spill
+static box_t random_box(bool spill = true)
+{
+    float half_world = WORLD_SIZE * 0.5 * (spill ? 1.1 : 0.9);
+    glm::vec3 center(frand(-half_world, half_world),
+                     frand(-half_world, half_world),
+                     frand(-half_world, half_world));
+    float size = (rand() % 20) ? frand(0, 2) : frand(0, 20);
+    box_t box;
+    box.m_min = center - glm::vec3(size * 0.5);
+    box.m_max = center + glm::vec3(size * 0.5);
+    return box;
+}
+
+static float box_distance2(glm::vec3 pos, const box_t &box)
+{
+    glm::vec3 offset = glm::max(glm::max(box.m_min - pos, pos - box.m_max), glm::vec3(0));
+    return glm::dot(offset, offset);
+}
+
+static std::vector<float> get_distances(glm::vec3 pos, const boxes_t &boxes, const std::vector<long> &ids)
+{
+    std::vector<float> distances;
+    for(std::vector<long>::const_iterator p = ids.begin(); p != ids.end(); p++) {
+        distances.push_back(box_distance2(pos, boxes.find(*p)->second));
+    }
+    return distances;
+}
+
+static void brute_force_k_nearest(int k, glm::vec3 pos, const boxes_t &boxes, std::vector<float>* distances)
+{
+    distances->clear();
+    for(boxes_t::const_iterator p = boxes.begin(); p != boxes.end(); p++) {
+        distances->push_back(box_distance2(pos, (*p).second));
+    }
+    std::sort(distances->begin(), distances->end());
+    distances->resize(std::min(k, static_cast<int>(distances->size())));
+}
+
+static void brute_force_within_radius(glm::vec3 pos, float radius, const boxes_t &boxes, std::vector<long>* ids)
+{
+    ids->clear();
+    for(boxes_t::const_iterator p = boxes.begin(); p != boxes.end(); p++) {
+        if(box_distance2(pos, (*p).second) <= radius * radius) {
+            ids->push_back((*p).first);
+        }
+    }
+}
+
+static void brute_force_in_frustum(glm::mat4 view_proj_transform, const boxes_t &boxes, std::vector<long>* ids)
+{
+    glm::vec4 planes[6];
+    vt::extract_frustum_planes(view_proj_transform, planes);
+    ids->clear();
+    for(boxes_t::const_iterator p = boxes.begin(); p != boxes.end(); p++) {
+        if(vt::frustum_test_aabb(planes, (*p).second.m_min, (*p).second.m_max) != vt::FRUSTUM_OUTSIDE) {
+            ids->push_back((*p).first);
+        }
+    }
+}
+
+static glm::vec3 random_pos()
+{
+    float half_world = WORLD_SIZE * 0.5;
+    return glm::vec3(frand(-half_world, half_world),
+                     frand(-half_world, half_world),
+                     frand(-half_world, half_world));
+}
+
+static glm::mat4 random_view_proj()
+{
+    glm::vec3 eye = random_pos();
+    glm::vec3 target = random_pos();
+    return glm::perspective(glm::radians(frand(30, 90)), frand(0.5, 2), 1.0f, frand(10, WORLD_SIZE)) *
+           glm::lookAt(eye, target, glm::vec3(0, 1, 0));
+}
+
+static void check_queries(const vt::Octree &octree, const boxes_t &boxes)
+{
+    for(int i = 0; i < NUM_QUERIES; i++) {
+        glm::vec3 pos = random_pos();
+
+        // k nearest (compare distances, since ties may come back in either order)
+        int k = 1 + rand() % 32;
+        std::vector<long> k_nearest;
+        int n = octree.find_k_nearest(k, pos, &k_nearest);
+        TEST_CHECK(n == static_cast<int>(k_nearest.size()));
+        std::vector<float> expected_distances;
+        brute_force_k_nearest(k, pos, boxes, &expected_distances);
+        std::vector<float> distances = get_distances(pos, boxes, k_nearest);
+        TEST_CHECK(std::is_sorted(distances.begin(), distances.end()));
+        TEST_CHECK(distances == expected_distances);
+
+        // within radius
+        float radius = frand(0, WORLD_SIZE * 0.25);
+        std::vector<long> ids;
+        n = octree.find_within_radius(pos, radius, &ids);
+        TEST_CHECK(n == static_cast<int>(ids.size()));
+        std::vector<long> expected_ids;
+        brute_force_within_radius(pos, radius, boxes, &expected_ids);
+        std::sort(ids.begin(), ids.end());
+        TEST_CHECK(ids == expected_ids);
+
+        // in frustum
+        glm::mat4 view_proj_transform = random_view_proj();
+        ids.clear();
+        n = octree.find_in_frustum(view_proj_transform, &ids);
+        TEST_CHECK(n == static_cast<int>(ids.size()));
+        brute_force_in_frustum(view_proj_transform, boxes, &expected_ids);
+        std::sort(ids.begin(), ids.end());
+        TEST_CHECK(ids == expected_ids);
+    }
+}
+
+static vt::Octree* alloc_octree()
+{
+    return new vt::Octree(glm::vec3(-WORLD_SIZE * 0.5), glm::vec3(WORLD_SIZE), TREE_DEPTH);
+}
+
+static void test_box_objects()
+{
+    vt::Octree* octree = alloc_octree();
+    boxes_t boxes;
+    for(long id = 0; id < NUM_TEST_OBJECTS; id++) {
+        box_t box = random_box();
+        TEST_CHECK(octree->add_object(id, box.m_min, box.m_max));
+        boxes[id] = box;
+    }
+    TEST_CHECK(!octree->add_object(0, glm::vec3(0), glm::vec3(1)));
+    check_queries(*octree, boxes);
+
+    // move some boxes a little and some far, grow or shrink others
+    for(boxes_t::iterator p = boxes.begin(); p != boxes.end(); p++) {
+        switch(rand() % 4) {
+            case 0:
+                {
+                    glm::vec3 offset(frand(-1, 1), frand(-1, 1), frand(-1, 1));
+                    (*p).second.m_min += offset;
+                    (*p).second.m_max += offset;
+                }
+                break;
+            case 1:
+                (*p).second = random_box();
+                break;
+            case 2:
+                (*p).second.m_max += glm::vec3(frand(-0.5, 5));
+                (*p).second.m_max = glm::max((*p).second.m_min, (*p).second.m_max);
+                break;
+            default:
+                continue;
+        }
+        TEST_CHECK(octree->update_object((*p).first, (*p).second.m_min, (*p).second.m_max));
+    }
+    check_queries(*octree, boxes);
+
+    // remove every third box
+    for(long id = 0; id < NUM_TEST_OBJECTS; id += 3) {
+        TEST_CHECK(octree->remove_object(id));
+        TEST_CHECK(!octree->has_object(id));
+        boxes.erase(id);
+    }
+    TEST_CHECK(!octree->remove_object(0));
+    check_queries(*octree, boxes);
+
+    // update_object() adds unknown ids
+    box_t box = random_box();
+    TEST_CHECK(octree->update_object(NUM_TEST_OBJECTS, box.m_min, box.m_max));
+    TEST_CHECK(octree->has_object(NUM_TEST_OBJECTS));
+    boxes[NUM_TEST_OBJECTS] = box;
+    check_queries(*octree, boxes);
+
+    octree->clear_objects();
+    std::vector<long> ids;
+    TEST_CHECK(!octree->has_object(1));
+    TEST_CHECK(octree->find_within_radius(glm::vec3(0), WORLD_SIZE * 2, &ids) == 0);
+    delete octree;
+}
+
+static void test_point_objects()
+{
+    vt::Octree* octree = alloc_octree();
+    std::vector<glm::vec3> positions(NUM_TEST_OBJECTS);
+    for(int i = 0; i < NUM_TEST_OBJECTS; i++) {
+        positions[i] = random_pos();
+        TEST_CHECK(octree->add_object(i, &positions[i]));
+    }
+
+    // update() picks up the tracked positions
+    for(int i = 0; i < NUM_TEST_OBJECTS; i += 2) {
+        positions[i] = (i % 4) ? positions[i] + glm::vec3(frand(-1, 1)) : random_pos();
+    }
+    octree->update();
+    boxes_t boxes;
+    for(int i = 0; i < NUM_TEST_OBJECTS; i++) {
+        box_t box;
+        box.m_min = box.m_max = positions[i];
+        boxes[i] = box;
+    }
+    check_queries(*octree, boxes);
+    delete octree;
+}
+
+static void bench()
+{
+    vt::Octree* octree = alloc_octree();
+    boxes_t boxes;
+    for(long id = 0; id < NUM_BENCH_OBJECTS; id++) {
+        box_t box = random_box(false);
+        boxes[id] = box;
+    }
+    vt::BenchTimer add_timer;
+    for(boxes_t::iterator p = boxes.begin(); p != boxes.end(); p++) {
+        octree->add_object((*p).first, (*p).second.m_min, (*p).second.m_max);
+    }
+    std::cout << "add_object:         " << add_timer.get_elapsed_ms() / NUM_BENCH_OBJECTS * 1000 << " us/object" << std::endl;
+
+    vt::BenchTimer update_timer;
+    for(boxes_t::iterator p = boxes.begin(); p != boxes.end(); p++) {
+        glm::vec3 offset(frand(-0.1, 0.1), frand(-0.1, 0.1), frand(-0.1, 0.1));
+        (*p).second.m_min += offset;
+        (*p).second.m_max += offset;
+        octree->update_object((*p).first, (*p).second.m_min, (*p).second.m_max);
+    }
+    std::cout << "update_object:      " << update_timer.get_elapsed_ms() / NUM_BENCH_OBJECTS * 1000 << " us/object" << std::endl;
+
+    std::vector<glm::vec3> positions;
+    std::vector<glm::mat4> view_proj_transforms;
+    for(int i = 0; i < NUM_QUERIES; i++) {
+        positions.push_back(random_pos());
+        view_proj_transforms.push_back(random_view_proj());
+    }
+    std::vector<long>  ids;
+    std::vector<float> distances;
+    double octree_ms[3];
+    double brute_force_ms[3];
+
+    vt::BenchTimer timer0;
+    for(int i = 0; i < NUM_QUERIES; i++) {
+        ids.clear();
+        octree->find_k_nearest(16, positions[i], &ids);
+    }
+    octree_ms[0] = timer0.get_elapsed_ms();
+    vt::BenchTimer timer1;
+    for(int i = 0; i < NUM_QUERIES; i++) {
+        brute_force_k_nearest(16, positions[i], boxes, &distances);
+    }
+    brute_force_ms[0] = timer1.get_elapsed_ms();
+
+    vt::BenchTimer timer2;
+    for(int i = 0; i < NUM_QUERIES; i++) {
+        ids.clear();
+        octree->find_within_radius(positions[i], 5, &ids);
+    }
+    octree_ms[1] = timer2.get_elapsed_ms();
+    vt::BenchTimer timer3;
+    for(int i = 0; i < NUM_QUERIES; i++) {
+        brute_force_within_radius(positions[i], 5, boxes, &ids);
+    }
+    brute_force_ms[1] = timer3.get_elapsed_ms();
+
+    vt::BenchTimer timer4;
+    for(int i = 0; i < NUM_QUERIES; i++) {
+        ids.clear();
+        octree->find_in_frustum(view_proj_transforms[i], &ids);
+    }
+    octree_ms[2] = timer4.get_elapsed_ms();
+    vt::BenchTimer timer5;
+    for(int i = 0; i < NUM_QUERIES; i++) {
+        brute_force_in_frustum(view_proj_transforms[i], boxes, &ids);
+    }
+    brute_force_ms[2] = timer5.get_elapsed_ms();
+
+    const char* query_names[] = {"find_k_nearest:     ",
+                                 "find_within_radius: ",
+                                 "find_in_frustum:    "};
+    for(int j = 0; j < 3; j++) {
+        std::cout << query_names[j] << octree_ms[j] / NUM_QUERIES << " ms/query (brute force "
+                  << brute_force_ms[j] / NUM_QUERIES << " ms/query)" << std::endl;
+    }
+    delete octree;
+}
+
+int main(int argc, char** argv)
+{
+    srand(1);
+    test_box_objects();
+    test_point_objects();
+    if(vt::test_bench_mode(argc, argv)) {
+        std::cout << NUM_BENCH_OBJECTS << " objects, depth " << TREE_DEPTH << std::endl;
+        bench();
+    }
+    return vt::test_report("test_octree");
+}
@@ -0,0 +1,286 @@
+// This file is part of dexvt-lite.
+// -- 3D Inverse Kinematics (Cyclic Coordinate Descent) with Constraints
+// Copyright (C) 2018 onlyuser <mailto:onlyuser@gmail.com>
+//
+// dexvt-lite is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// dexvt-lite is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with dexvt-lite.  If not, see <http://www.gnu.org/licenses/>.
+
+// mesh_tessellate() checked against the old std::map version, and for closed-mesh topology across levels
+
+#include <Modifiers.h>
+#include <Mesh.h>
+#include <PrimitiveFactory.h>
+#include <Util.h>
+#include <TestUtil.h>
+#include <glm/glm.hpp>
+#include <iostream>
+#include <vector>
+#include <map>
+#include <set>
+#include <string>
+#include <algorithm>
+
+#define MAX_TEST_LEVELS  4
+#define MAX_NUM_VERTEX   0x10000 // triangle indices are GLushort
+#define NUM_BENCH_LEVELS 6
+
+struct mesh_data_t
+{
+    std::vector<glm::vec3>  m_vert_coords;
+    std::vector<glm::vec2>  m_tex_coords;
+    std::vector<glm::ivec3> m_tri_indices;
+};
+
+static void get_mesh_data(const vt::Mesh* mesh, mesh_data_t* mesh_data)
+{
+    mesh_data->m_vert_coords.resize(mesh->get_num_vertex());
+    mesh_data->m_tex_coords.resize(mesh->get_num_vertex());
+    mesh_data->m_tri_indices.resize(mesh->get_num_tri());
+    for(int i = 0; i < static_cast<int>(mesh->get_num_vertex()); i++) {
+        mesh_data->m_vert_coords[i] = mesh->get_vert_coord(i);
+        mesh_data->m_tex_coords[i]  = mesh->get_tex_coord(i);
+    }
+    for(int j = 0; j < static_cast<int>(mesh->get_num_tri()); j++) {
+        mesh_data->m_tri_indices[j] = mesh->get_tri_indices(j);
+    }
+}
+
+static void set_mesh_data(vt::Mesh* mesh, const mesh_data_t &mesh_data)
+{
+    mesh->resize(mesh_data.m_vert_coords.size(), mesh_data.m_tri_indices.size());
+    mesh->set_vert_coords(&mesh_data.m_vert_coords[0]);
+    mesh->set_tex_coords(&mesh_data.m_tex_coords[0]);
+    mesh->set_tri_indices(&mesh_data.m_tri_indices[0]);
+    mesh->update_normals_and_tangents();
+}
+
+static int find_or_insert_mid_vert(std::map<uint32_t, int>* shared_vert_map, int* current_vert_index, int vert_index1, int vert_index2)
+{
+    uint32_t key = MAKELONG(std::min(vert_index1, vert_index2), std::max(vert_index1, vert_index2));
+    std::map<uint32_t, int>::iterator p = shared_vert_map->find(key);
+    if(p != shared_vert_map->end()) {
+        return (*p).second;
+    }
+    int vert_index = (*current_vert_index)++;
+    shared_vert_map->insert(std::pair<uint32_t, int>(key, vert_index));
+    return vert_index;
+}
+
+// the old path, one level at a time with a std::map of shared edge vertices
+static void old_tessellate(mesh_data_t* mesh_data, vt::tessellation_type_t tessellation_type)
+{
+    std::vector<glm::vec3>  &vert_coords = mesh_data->m_vert_coords;
+    std::vector<glm::vec2>  &tex_coords  = mesh_data->m_tex_coords;
+    std::vector<glm::ivec3>  tri_indices;
+    tri_indices.swap(mesh_data->m_tri_indices);
+    int current_vert_index = vert_coords.size();
+    switch(tessellation_type) {
+        case vt::TESSELLATION_TYPE_EDGE_CENTER:
+            {
+                std::map<uint32_t, int> shared_vert_map;
+                vert_coords.resize(vert_coords.size() + tri_indices.size() * 3);
+                tex_coords.resize(tex_coords.size() + tri_indices.size() * 3);
+                for(std::vector<glm::ivec3>::iterator p = tri_indices.begin(); p != tri_indices.end(); p++) {
+                    glm::ivec3 tri = *p;
+                    int ab = find_or_insert_mid_vert(&shared_vert_map, &current_vert_index, tri[0], tri[1]);
+                    int bc = find_or_insert_mid_vert(&shared_vert_map, &current_vert_index, tri[1], tri[2]);
+                    int ca = find_or_insert_mid_vert(&shared_vert_map, &current_vert_index, tri[2], tri[0]);
+                    vert_coords[ab] = (vert_coords[tri[0]] + vert_coords[tri[1]]) * 0.5f;
+                    vert_coords[bc] = (vert_coords[tri[1]] + vert_coords[tri[2]]) * 0.5f;
+                    vert_coords[ca] = (vert_coords[tri[2]] + vert_coords[tri[0]]) * 0.5f;
+                    tex_coords[ab]  = (tex_coords[tri[0]] + tex_coords[tri[1]]) * 0.5f;
+                    tex_coords[bc]  = (tex_coords[tri[1]] + tex_coords[tri[2]]) * 0.5f;
+                    tex_coords[ca]  = (tex_coords[tri[2]] + tex_coords[tri[0]]) * 0.5f;
+                    mesh_data->m_tri_indices.push_back(glm::ivec3(tri[0], ab, ca));
+                    mesh_data->m_tri_indices.push_back(glm::ivec3(tri[1], bc, ab));
+                    mesh_data->m_tri_indices.push_back(glm::ivec3(tri[2], ca, bc));
+                    mesh_data->m_tri_indices.push_back(glm::ivec3(ab, bc, ca));
+                }
+                vert_coords.resize(current_vert_index);
+                tex_coords.resize(current_vert_index);
+            }
+            break;
+        case vt::TESSELLATION_TYPE_TRI_CENTER:
+            for(std::vector<glm::ivec3>::iterator p = tri_indices.begin(); p != tri_indices.end(); p++) {
+                glm::ivec3 tri = *p;
+                int new_vert_index = current_vert_index++;
+                vert_coords.push_back((vert_coords[tri[0]] + vert_coords[tri[1]] + vert_coords[tri[2]]) * (1.0f / 3));
+                tex_coords.push_back((tex_coords[tri[0]] + tex_coords[tri[1]] + tex_coords[tri[2]]) * (1.0f / 3));
+                mesh_data->m_tri_indices.push_back(glm::ivec3(tri[0], tri[1], new_vert_index));
+                mesh_data->m_tri_indices.push_back(glm::ivec3(tri[1], tri[2], new_vert_index));
+                mesh_data->m_tri_indices.push_back(glm::ivec3(tri[2], tri[0], new_vert_index));
+            }
+            break;
+    }
+}
+
+// closed and welded, so every edge has exactly two triangles
+static vt::Mesh* create_octahedron()
+{
+    glm::vec3 vert_coords[] = {glm::vec3( 1,  0,  0), glm::vec3(-1,  0,  0),
+                               glm::vec3( 0,  1,  0), glm::vec3( 0, -1,  0),
+                               glm::vec3( 0,  0,  1), glm::vec3( 0,  0, -1)};
+    glm::ivec3 tri_indices[] = {glm::ivec3(0, 2, 4), glm::ivec3(2, 1, 4), glm::ivec3(1, 3, 4), glm::ivec3(3, 0, 4),
+                                glm::ivec3(2, 0, 5), glm::ivec3(1, 2, 5), glm::ivec3(3, 1, 5), glm::ivec3(0, 3, 5)};
+    vt::Mesh* mesh = new vt::Mesh("octahedron", 6, 8);
+    for(int i = 0; i < 6; i++) {
+        mesh->set_vert_coord(i, vert_coords[i]);
+        mesh->set_tex_coord(i, glm::vec2(vert_coords[i].x, vert_coords[i].y) * 0.5f + glm::vec2(0.5));
+    }
+    for(int j = 0; j < 8; j++) {
+        mesh->set_tri_indices(j, tri_indices[j]);
+    }
+    return mesh;
+}
+
+static vt::Mesh* create_tetrahedron()
+{
+    vt::Mesh* mesh = new vt::Mesh("tetrahedron", 4, 4);
+    mesh->set_vert_coord(0, glm::vec3( 1,  1,  1));
+    mesh->set_vert_coord(1, glm::vec3(-1, -1,  1));
+    mesh->set_vert_coord(2, glm::vec3(-1,  1, -1));
+    mesh->set_vert_coord(3, glm::vec3( 1, -1, -1));
+    for(int i = 0; i < 4; i++) {
+        mesh->set_tex_coord(i, glm::vec2(i % 2, i / 2));
+    }
+    mesh->set_tri_indices(0, glm::ivec3(0, 1, 2));
+    mesh->set_tri_indices(1, glm::ivec3(0, 3, 1));
+    mesh->set_tri_indices(2, glm::ivec3(0, 2, 3));
+    mesh->set_tri_indices(3, glm::ivec3(1, 3, 2));
+    return mesh;
+}
+
+static bool is_same_mesh_data(const mesh_data_t &mesh_data1, const mesh_data_t &mesh_data2)
+{
+    return mesh_data1.m_vert_coords == mesh_data2.m_vert_coords &&
+           mesh_data1.m_tex_coords  == mesh_data2.m_tex_coords &&
+           mesh_data1.m_tri_indices == mesh_data2.m_tri_indices;
+}
+
+// every directed edge appears once and its reverse once, so the surface is closed and consistently wound
+static bool is_closed(const mesh_data_t &mesh_data, int* num_edges)
+{
+    std::set<std::pair<int, int> > directed_edges;
+    for(std::vector<glm::ivec3>::const_iterator p = mesh_data.m_tri_indices.begin(); p != mesh_data.m_tri_indices.end(); p++) {
+        for(int j = 0; j < 3; j++) {
+            if(!directed_edges.insert(std::make_pair((*p)[j], (*p)[(j + 1) % 3])).second) {
+                return false;
+            }
+        }
+    }
+    for(std::set<std::pair<int, int> >::iterator q = directed_edges.begin(); q != directed_edges.end(); q++) {
+        if(directed_edges.find(std::make_pair((*q).second, (*q).first)) == directed_edges.end()) {
+            return false;
+        }
+    }
+    *num_edges = directed_edges.size() / 2;
+    return true;
+}
+
+static void test_closed_mesh(vt::Mesh* mesh, std::string name, vt::tessellation_type_t tessellation_type)
+{
+    std::string type_name = (tessellation_type == vt::TESSELLATION_TYPE_EDGE_CENTER) ? "edge center" : "tri center";
+    mesh_data_t old_mesh_data;
+    get_mesh_data(mesh, &old_mesh_data);
+    for(int level = 1; level <= MAX_TEST_LEVELS; level++) {
+        vt::mesh_tessellate(mesh, tessellation_type, false);
+        old_tessellate(&old_mesh_data, tessellation_type);
+        mesh_data_t mesh_data;
+        get_mesh_data(mesh, &mesh_data);
+        TEST_CHECK(is_same_mesh_data(mesh_data, old_mesh_data));
+        int num_edges = 0;
+        bool closed = is_closed(mesh_data, &num_edges);
+        int euler_characteristic = static_cast<int>(mesh->get_num_vertex()) - num_edges + static_cast<int>(mesh->get_num_tri());
+        std::cout << name << " (" << type_name << ") level " << level << ": "
+                  << mesh->get_num_vertex() << " vertices, " << num_edges << " edges, " << mesh->get_num_tri() << " triangles, "
+                  << "V - E + F = " << euler_characteristic << (closed ? "" : ", not closed") << std::endl;
+        TEST_CHECK(closed);
+        TEST_CHECK(euler_characteristic == 2);
+    }
+
+    // several levels at once match one level at a time
+    vt::Mesh* multi_level_mesh = (name == "octahedron") ? create_octahedron() : create_tetrahedron();
+    vt::mesh_tessellate(multi_level_mesh, tessellation_type, false, MAX_TEST_LEVELS);
+    mesh_data_t multi_level_mesh_data;
+    get_mesh_data(multi_level_mesh, &multi_level_mesh_data);
+    TEST_CHECK(is_same_mesh_data(multi_level_mesh_data, old_mesh_data));
+    delete multi_level_mesh;
+}
+
+static void test_tessellate()
+{
+    vt::tessellation_type_t tessellation_types[] = {vt::TESSELLATION_TYPE_EDGE_CENTER, vt::TESSELLATION_TYPE_TRI_CENTER};
+    for(int i = 0; i < 2; i++) {
+        vt::Mesh* octahedron = create_octahedron();
+        test_closed_mesh(octahedron, "octahedron", tessellation_types[i]);
+        delete octahedron;
+        vt::Mesh* tetrahedron = create_tetrahedron();
+        test_closed_mesh(tetrahedron, "tetrahedron", tessellation_types[i]);
+        delete tetrahedron;
+
+        // open meshes with split vertices match the old path too
+        vt::Mesh* box = vt::PrimitiveFactory::create_box("box");
+        mesh_data_t old_mesh_data;
+        get_mesh_data(box, &old_mesh_data);
+        vt::mesh_tessellate(box, tessellation_types[i], false, 2);
+        old_tessellate(&old_mesh_data, tessellation_types[i]);
+        old_tessellate(&old_mesh_data, tessellation_types[i]);
+        mesh_data_t mesh_data;
+        get_mesh_data(box, &mesh_data);
+        TEST_CHECK(is_same_mesh_data(mesh_data, old_mesh_data));
+        delete box;
+    }
+
+    // stops before triangle indices overflow
+    vt::Mesh* octahedron = create_octahedron();
+    vt::mesh_tessellate(octahedron, vt::TESSELLATION_TYPE_EDGE_CENTER, false, 10);
+    std::cout << "octahedron (edge center) level 10: " << octahedron->get_num_vertex() << " vertices" << std::endl;
+    TEST_CHECK(octahedron->get_num_vertex() <= MAX_NUM_VERTEX);
+    TEST_CHECK(octahedron->get_num_tri() == 8 * 4 * 4 * 4 * 4 * 4 * 4); // level 7 would need 65538 vertices
+    delete octahedron;
+}
+
+static void bench()
+{
+    vt::tessellation_type_t tessellation_types[] = {vt::TESSELLATION_TYPE_EDGE_CENTER, vt::TESSELLATION_TYPE_TRI_CENTER};
+    for(int i = 0; i < 2; i++) {
+        int levels = (tessellation_types[i] == vt::TESSELLATION_TYPE_EDGE_CENTER) ? NUM_BENCH_LEVELS : NUM_BENCH_LEVELS + 2;
+        vt::Mesh* mesh = create_octahedron();
+        mesh_data_t old_mesh_data;
+        get_mesh_data(mesh, &old_mesh_data);
+        vt::BenchTimer timer;
+        vt::mesh_tessellate(mesh, tessellation_types[i], false, levels);
+        double new_ms = timer.get_elapsed_ms();
+        vt::Mesh* old_mesh = create_octahedron();
+        vt::BenchTimer old_timer;
+        for(int level = 0; level < levels; level++) {
+            old_tessellate(&old_mesh_data, tessellation_types[i]);
+            set_mesh_data(old_mesh, old_mesh_data); // the old path updated the mesh every level
+        }
+        double old_ms = old_timer.get_elapsed_ms();
+        std::cout << "octahedron (" << ((tessellation_types[i] == vt::TESSELLATION_TYPE_EDGE_CENTER) ? "edge center" : "tri center")
+                  << "), " << levels << " levels, " << mesh->get_num_vertex() << " vertices, " << mesh->get_num_tri() << " triangles: "
+                  << new_ms << " ms (old path " << old_ms << " ms)" << std::endl;
+        delete mesh;
+        delete old_mesh;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    test_tessellate();
+    if(vt::test_bench_mode(argc, argv)) {
+        bench();
+    }
+    return vt::test_report("test_tessellate");
+}